@@ -0,0 +1,49 @@
+#!/bin/sh
+# code-size.sh <executable>...
+#
+# Reports the code size of each dispatch-benchmark variant: the total size
+# of the functions in namespaces staticmode_variant::, flags_variant:: and
+# virtual_variant:: (kernels, and the benchmark loops they are inlined into),
+# and of their data symbols (e.g. vtables and typeinfo). Requires nm
+# (binutils or llvm-nm).
+#
+# Functions that the compiler inlined into a variant's loops count towards
+# that variant; shared primitives (bench::) that were not inlined are listed
+# separately.
+
+NM=${NM:-nm}
+
+if [ $# -eq 0 ]; then
+    echo "usage: $0 <executable>..." >&2
+    exit 2
+fi
+
+for exe in "$@"; do
+    echo "$exe:"
+    "$NM" -C --print-size "$exe" | awk '
+        NF >= 4 {
+            type = $3
+            name = $4
+            for (i = 5; i <= NF; ++i)
+                name = name " " $i
+            size = 0
+            hex = tolower($2)
+            for (i = 1; i <= length(hex); ++i)
+                size = size * 16 + index("0123456789abcdef", substr(hex, i, 1)) - 1
+            isCode = (type ~ /^[tTwWi]$/)
+            for (v = 1; v <= 4; ++v) {
+                if (index(name, ns[v] "::") > 0) {
+                    if (isCode) code[v] += size; else data[v] += size
+                    break
+                }
+            }
+        }
+        BEGIN {
+            ns[1] = "staticmode_variant"; ns[2] = "flags_variant"; ns[3] = "virtual_variant"; ns[4] = "bench"
+            printf "  %-20s %12s %12s\n", "variant", "code bytes", "data bytes"
+        }
+        END {
+            for (v = 1; v <= 4; ++v)
+                printf "  %-20s %12d %12d\n", ns[v], code[v], data[v]
+        }'
+done
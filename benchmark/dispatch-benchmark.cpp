@@ -0,0 +1,262 @@
+// dispatch-benchmark: StaticMode overloads vs runtime bitmask flags vs
+// virtual dispatch, on the kernels in kernels.h.
+//
+// This answers an audience question recorded in
+// docs/melb-cpp-talk-feb-2017/postmortem.md: "How does this compare to
+// normal flag logic with link-time optimization?" The benchmark is built
+// twice, as dispatch-benchmark (-O2) and dispatch-benchmark-lto (-O2 -flto).
+// Run both, then compare code size per variant with code-size.sh (or build
+// the benchmark-report target to do all three).
+//
+// Each variant calls each kernel with every combination of modes, in a
+// fixed order, with the modes known at the call site (i.e. `dashed|arrows`,
+// `dashed|arrows` flags, or a pen made for dashed arrows). This is the
+// situation that the talk is about; dispatch on modes that are only known at
+// runtime is covered by examples/mode-function.cpp and
+// examples/block-dispatch.cpp. The results of all variants must match.
+//
+// Usage: dispatch-benchmark [repetitions]
+
+#include <algorithm> // min
+#include <chrono>
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t
+#include <cstdlib> // atoi
+#include <cstring> // memcpy
+#include <iomanip> // setw
+#include <iostream> // cout
+#include <memory> // unique_ptr
+#include <vector>
+
+#include "kernels.h"
+
+#if defined(_MSC_VER)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+#if defined(STATICMODE_BENCHMARK_LTO)
+static const char *const buildName = "-O2 -flto";
+#else
+static const char *const buildName = "-O2";
+#endif
+
+using bench::Raster;
+using bench::Line;
+
+static const std::size_t lineCount = 9 * 2000;  // a multiple of the 9 drawLine mode combinations
+static const std::size_t blockSize = 64;
+static const std::size_t blockCount = 6 * 200;  // a multiple of the 6 processBlock mode combinations, one block each
+
+// A loop per variant and kernel. Each is a separate (not inlined) function,
+// so that code-size.sh can attribute code to its variant's namespace.
+
+namespace staticmode_variant {
+
+BENCH_NOINLINE static void drawLines(Raster& r, const Line *lines)
+{
+    for (std::size_t i = 0; i < lineCount; i += 9) {
+        drawLine(r, lines[i], solid | no_ends);
+        drawLine(r, lines[i + 1], solid | arrows);
+        drawLine(r, lines[i + 2], solid | circles);
+        drawLine(r, lines[i + 3], dotted | no_ends);
+        drawLine(r, lines[i + 4], dotted | arrows);
+        drawLine(r, lines[i + 5], dotted | circles);
+        drawLine(r, lines[i + 6], dashed | no_ends);
+        drawLine(r, lines[i + 7], dashed | arrows);
+        drawLine(r, lines[i + 8], dashed | circles);
+    }
+}
+
+BENCH_NOINLINE static void processBlocks(float *x)
+{
+    for (std::size_t b = 0; b < blockCount; b += 6) {
+        processBlock(x, blockSize, no_saturation | normal);
+        processBlock(x + blockSize, blockSize, no_saturation | inverted);
+        processBlock(x + 2 * blockSize, blockSize, soft | normal);
+        processBlock(x + 3 * blockSize, blockSize, soft | inverted);
+        processBlock(x + 4 * blockSize, blockSize, hard | normal);
+        processBlock(x + 5 * blockSize, blockSize, hard | inverted);
+    }
+}
+
+} // end namespace staticmode_variant
+
+namespace flags_variant {
+
+BENCH_NOINLINE static void drawLines(Raster& r, const Line *lines)
+{
+    for (std::size_t i = 0; i < lineCount; i += 9) {
+        drawLine(r, lines[i], solid | no_ends);
+        drawLine(r, lines[i + 1], solid | arrows);
+        drawLine(r, lines[i + 2], solid | circles);
+        drawLine(r, lines[i + 3], dotted | no_ends);
+        drawLine(r, lines[i + 4], dotted | arrows);
+        drawLine(r, lines[i + 5], dotted | circles);
+        drawLine(r, lines[i + 6], dashed | no_ends);
+        drawLine(r, lines[i + 7], dashed | arrows);
+        drawLine(r, lines[i + 8], dashed | circles);
+    }
+}
+
+BENCH_NOINLINE static void processBlocks(float *x)
+{
+    for (std::size_t b = 0; b < blockCount; b += 6) {
+        processBlock(x, blockSize, no_saturation | normal);
+        processBlock(x + blockSize, blockSize, no_saturation | inverted);
+        processBlock(x + 2 * blockSize, blockSize, soft | normal);
+        processBlock(x + 3 * blockSize, blockSize, soft | inverted);
+        processBlock(x + 4 * blockSize, blockSize, hard | normal);
+        processBlock(x + 5 * blockSize, blockSize, hard | inverted);
+    }
+}
+
+} // end namespace flags_variant
+
+namespace virtual_variant {
+
+// pens[9] and processors[6] in the same order as the other variants' calls
+BENCH_NOINLINE static void drawLines(Raster& r, const Line *lines, const Pen *pens)
+{
+    for (std::size_t i = 0; i < lineCount; i += 9) {
+        for (std::size_t k = 0; k < 9; ++k)
+            drawLine(r, lines[i + k], pens[k]);
+    }
+}
+
+BENCH_NOINLINE static void processBlocks(float *x, const std::unique_ptr<SampleProcessor> *processors)
+{
+    for (std::size_t b = 0; b < blockCount; b += 6) {
+        for (std::size_t k = 0; k < 6; ++k)
+            processors[k]->processBlock(x + k * blockSize, blockSize);
+    }
+}
+
+} // end namespace virtual_variant
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+    enum { staticmodeVariant, flagsVariant, virtualVariant, variantCount };
+    const char *const variantNames[variantCount] = { "staticmode", "flags", "virtual" };
+
+    struct Inputs {
+        std::vector<Line> lines;
+        std::vector<float> samples; // 6 blocks
+        std::vector<virtual_variant::Pen> pens;
+        std::vector<std::unique_ptr<virtual_variant::SampleProcessor> > processors;
+    };
+
+    Inputs makeInputs()
+    {
+        Inputs in;
+        std::uint32_t seed = 12345;
+        auto next = [&seed](int range) {
+            seed = seed * 1664525u + 1013904223u;
+            return static_cast<int>((seed >> 8) % static_cast<std::uint32_t>(range));
+        };
+
+        for (std::size_t i = 0; i < lineCount; ++i) {
+            Line l = { next(Raster::size), next(Raster::size), next(Raster::size), next(Raster::size) };
+            in.lines.push_back(l);
+        }
+
+        for (std::size_t i = 0; i < 6 * blockSize; ++i)
+            in.samples.push_back(static_cast<float>(next(4001) - 2000) / 500.f);
+
+        using namespace bench;
+        const LineStyle lineStyles[] = { LineStyle::solid, LineStyle::dotted, LineStyle::dashed };
+        const EndStyle endStyles[] = { EndStyle::no_ends, EndStyle::arrows, EndStyle::circles };
+        for (LineStyle ls : lineStyles) {
+            for (EndStyle es : endStyles)
+                in.pens.push_back(virtual_variant::makePen(ls, es));
+        }
+
+        const Saturation saturations[] = { Saturation::none, Saturation::soft, Saturation::hard };
+        const Polarity polarities[] = { Polarity::normal, Polarity::inverted };
+        for (Saturation s : saturations) {
+            for (Polarity p : polarities)
+                in.processors.push_back(virtual_variant::makeSampleProcessor(s, p));
+        }
+        return in;
+    }
+
+    template<typename F>
+    double bestSeconds(int repetitions, F f)
+    {
+        double best = 0;
+        for (int i = 0; i < repetitions; ++i) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            f();
+            double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best = (i == 0) ? t : std::min(best, t);
+        }
+        return best;
+    }
+
+    std::uint32_t floatChecksum(const std::vector<float>& x)
+    {
+        std::uint32_t h = 2166136261u;
+        for (float f : x) {
+            std::uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            h = (h ^ bits) * 16777619u;
+        }
+        return h;
+    }
+
+} // end anonymous namespace
+
+int main(int argc, char *argv[])
+{
+    const int repetitions = (argc > 1) ? std::atoi(argv[1]) : 20;
+    const Inputs in = makeInputs();
+
+    double drawNs[variantCount], processNs[variantCount];
+    std::uint32_t drawChecksums[variantCount], processChecksums[variantCount];
+
+    for (int v = 0; v < variantCount; ++v) {
+        Raster raster;
+        raster.clear();
+        drawNs[v] = 1e9 / lineCount * bestSeconds(repetitions, [&]() {
+            switch (v) {
+            case staticmodeVariant: staticmode_variant::drawLines(raster, in.lines.data()); break;
+            case flagsVariant: flags_variant::drawLines(raster, in.lines.data()); break;
+            default: virtual_variant::drawLines(raster, in.lines.data(), in.pens.data()); break;
+            }
+        });
+        drawChecksums[v] = raster.checksum();
+
+        std::vector<float> samples = in.samples;
+        processNs[v] = 1e9 / blockCount * bestSeconds(repetitions, [&]() {
+            switch (v) {
+            case staticmodeVariant: staticmode_variant::processBlocks(samples.data()); break;
+            case flagsVariant: flags_variant::processBlocks(samples.data()); break;
+            default: virtual_variant::processBlocks(samples.data(), in.processors.data()); break;
+            }
+        });
+        processChecksums[v] = floatChecksum(samples);
+    }
+
+    std::cout << "build: " << buildName << ", best of " << repetitions << " runs\n\n";
+    std::cout << std::setw(30) << "ns per call:";
+    for (int v = 0; v < variantCount; ++v)
+        std::cout << std::setw(12) << variantNames[v];
+    std::cout << "\n" << std::fixed << std::setprecision(2);
+
+    std::cout << std::setw(30) << "drawLine (1 line)";
+    for (int v = 0; v < variantCount; ++v)
+        std::cout << std::setw(12) << drawNs[v];
+    std::cout << "\n" << std::setw(30) << "processBlock (64 samples)";
+    for (int v = 0; v < variantCount; ++v)
+        std::cout << std::setw(12) << processNs[v];
+    std::cout << "\n";
+
+    bool match = true;
+    for (int v = 1; v < variantCount; ++v)
+        match = match && drawChecksums[v] == drawChecksums[0] && processChecksums[v] == processChecksums[0];
+    std::cout << "\nresults " << (match ? "match" : "DIFFER") << "\n";
+    return match ? 0 : 1;
+}
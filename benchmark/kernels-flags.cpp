@@ -0,0 +1,49 @@
+// Runtime bitmask flags, as in docs/melb-cpp-talk-feb-2017/postmortem.md
+
+#include <cassert>
+
+#include "kernels.h"
+
+namespace flags_variant {
+
+void drawLine(Raster& r, const Line& l, int flags)
+{
+    assert((flags & ~(LineStyle_MASK | EndStyle_MASK)) == 0); // only expected flags
+    int lineStyle = flags & LineStyle_MASK;
+    int endStyle = flags & EndStyle_MASK;
+
+    switch (lineStyle) {
+    case solid: rasterize(r, l, solidPixel); break;
+    case dotted: rasterize(r, l, dottedPixel); break;
+    case dashed: rasterize(r, l, dashedPixel); break;
+    default: assert(false); // unexpected line style
+    }
+
+    switch (endStyle) {
+    case no_ends: break;
+    case arrows: drawArrowEnds(r, l); break;
+    case circles: drawCircleEnds(r, l); break;
+    default: assert(false); // unexpected end style
+    }
+}
+
+// the per-sample flag logic of a typical implementation
+static float processSample(int flags, float x)
+{
+    switch (flags & Saturation_MASK) {
+    case no_saturation: x = saturateNone(x); break;
+    case soft: x = saturateSoft(x); break;
+    case hard: x = saturateHard(x); break;
+    default: assert(false); // unexpected saturation
+    }
+    return (flags & inverted) ? -x : x;
+}
+
+void processBlock(float *x, std::size_t count, int flags)
+{
+    assert((flags & ~(Saturation_MASK | Polarity_MASK)) == 0); // only expected flags
+    for (std::size_t i = 0; i < count; ++i)
+        x[i] = processSample(flags, x[i]);
+}
+
+} // end namespace flags_variant
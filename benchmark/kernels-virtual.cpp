@@ -0,0 +1,78 @@
+// Virtual dispatch: strategy objects chosen at runtime
+
+#include "kernels.h"
+
+namespace virtual_variant {
+
+LineStyleStrategy::~LineStyleStrategy() {}
+EndStyleStrategy::~EndStyleStrategy() {}
+SampleProcessor::~SampleProcessor() {}
+
+namespace {
+
+    template<bool (*PixelOn)(int)>
+    class PatternLineStyle : public LineStyleStrategy {
+    public:
+        void drawBody(Raster& r, const Line& l) const override { rasterize(r, l, PixelOn); }
+    };
+
+    class NoEnds : public EndStyleStrategy {
+    public:
+        void drawEnds(Raster&, const Line&) const override {}
+    };
+
+    class ArrowEnds : public EndStyleStrategy {
+    public:
+        void drawEnds(Raster& r, const Line& l) const override { drawArrowEnds(r, l); }
+    };
+
+    class CircleEnds : public EndStyleStrategy {
+    public:
+        void drawEnds(Raster& r, const Line& l) const override { drawCircleEnds(r, l); }
+    };
+
+    template<float (*Saturate)(float), bool Inverted>
+    class Processor : public SampleProcessor {
+    public:
+        void processBlock(float *x, std::size_t count) const override {
+            for (std::size_t i = 0; i < count; ++i)
+                x[i] = Inverted ? -Saturate(x[i]) : Saturate(x[i]);
+        }
+    };
+
+    template<float (*Saturate)(float)>
+    std::unique_ptr<SampleProcessor> makeProcessor(Polarity polarity) {
+        if (polarity == Polarity::inverted)
+            return std::unique_ptr<SampleProcessor>(new Processor<Saturate, true>());
+        return std::unique_ptr<SampleProcessor>(new Processor<Saturate, false>());
+    }
+
+} // end anonymous namespace
+
+Pen makePen(LineStyle lineStyle, EndStyle endStyle)
+{
+    Pen pen;
+    switch (lineStyle) {
+    case LineStyle::solid: pen.body.reset(new PatternLineStyle<solidPixel>()); break;
+    case LineStyle::dotted: pen.body.reset(new PatternLineStyle<dottedPixel>()); break;
+    case LineStyle::dashed: pen.body.reset(new PatternLineStyle<dashedPixel>()); break;
+    }
+    switch (endStyle) {
+    case EndStyle::no_ends: pen.ends.reset(new NoEnds()); break;
+    case EndStyle::arrows: pen.ends.reset(new ArrowEnds()); break;
+    case EndStyle::circles: pen.ends.reset(new CircleEnds()); break;
+    }
+    return pen;
+}
+
+std::unique_ptr<SampleProcessor> makeSampleProcessor(Saturation saturation, Polarity polarity)
+{
+    switch (saturation) {
+    case Saturation::none: return makeProcessor<saturateNone>(polarity);
+    case Saturation::soft: return makeProcessor<saturateSoft>(polarity);
+    case Saturation::hard: return makeProcessor<saturateHard>(polarity);
+    }
+    return std::unique_ptr<SampleProcessor>();
+}
+
+} // end namespace virtual_variant
@@ -0,0 +1,231 @@
+// Kernels for dispatch-benchmark.cpp, implemented three ways:
+//
+//   - staticmode_variant: StaticMode overloads, selected at compile time.
+//     Templates, so defined here, in the header.
+//   - flags_variant: runtime `int flags` with a switch, as in
+//     docs/melb-cpp-talk-feb-2017/postmortem.md. Defined in kernels-flags.cpp.
+//   - virtual_variant: strategy objects with virtual functions.
+//     Defined in kernels-virtual.cpp.
+//
+// The flags and virtual variants are in their own translation units, as a
+// library would be, so that the compiler can only specialize them for
+// constant flags (or devirtualize them) across translation units with
+// link-time optimization.
+//
+// All three variants are built from the same primitives (bench::...), so
+// they differ only in how the modes are dispatched.
+//
+// Two kernels:
+//
+//   - drawLine: rasterize a line into a 64x64 raster with a line style
+//     (solid, dotted, dashed) and an end style (no ends, arrows, circles).
+//     Dispatch is once per line: a few dozen pixels of work per call.
+//   - processBlock: apply a saturation (none, soft, hard) and a polarity
+//     (normal, inverted) to each sample of a block. The flags variant
+//     switches per sample, as such code is usually written.
+
+#ifndef INCLUDED_STATICMODE_BENCHMARK_KERNELS_H
+#define INCLUDED_STATICMODE_BENCHMARK_KERNELS_H
+
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t
+#include <memory> // unique_ptr
+
+#include "StaticMode.h"
+
+namespace bench {
+
+///////////////////////////////////////////////////////////////////////////////
+// Shared primitives
+
+struct Raster {
+    static const int size = 64;
+    unsigned char pixels[size * size];
+
+    void clear() { for (unsigned char& p : pixels) p = 0; }
+
+    std::uint32_t checksum() const {
+        std::uint32_t h = 2166136261u;
+        for (unsigned char p : pixels)
+            h = (h ^ p) * 16777619u;
+        return h;
+    }
+};
+
+struct Line {
+    int x0, y0, x1, y1;
+};
+
+inline void plot(Raster& r, int x, int y) {
+    if (x >= 0 && x < Raster::size && y >= 0 && y < Raster::size)
+        r.pixels[y * Raster::size + x] = 1;
+}
+
+// the pattern of each line style: is pixel /i/ of the line drawn?
+inline bool solidPixel(int) { return true; }
+inline bool dottedPixel(int i) { return (i & 1) == 0; }
+inline bool dashedPixel(int i) { return (i % 6) < 4; }
+
+template<typename PixelPredicate>
+inline void rasterize(Raster& r, const Line& l, PixelPredicate on) {
+    const int dx = l.x1 - l.x0, dy = l.y1 - l.y0;
+    const int adx = (dx < 0) ? -dx : dx, ady = (dy < 0) ? -dy : dy;
+    const int n = (adx > ady) ? adx : ady;
+    if (n == 0) {
+        plot(r, l.x0, l.y0);
+        return;
+    }
+    for (int i = 0; i <= n; ++i) {
+        if (on(i))
+            plot(r, l.x0 + (dx * i) / n, l.y0 + (dy * i) / n);
+    }
+}
+
+inline void drawArrowEnds(Raster& r, const Line& l) {
+    // a small fixed arrowhead at each end
+    static const int offsets[][2] = { {-1,-1}, {-2,-2}, {-1,1}, {-2,2}, {1,-1}, {2,-2}, {1,1}, {2,2} };
+    for (const int *o : offsets) {
+        plot(r, l.x0 + o[0], l.y0 + o[1]);
+        plot(r, l.x1 - o[0], l.y1 - o[1]);
+    }
+}
+
+inline void drawCircleEnds(Raster& r, const Line& l) {
+    static const int offsets[][2] = { {2,0}, {2,1}, {1,2}, {0,2}, {-1,2}, {-2,1}, {-2,0}, {-2,-1},
+                                      {-1,-2}, {0,-2}, {1,-2}, {2,-1} };
+    for (const int *o : offsets) {
+        plot(r, l.x0 + o[0], l.y0 + o[1]);
+        plot(r, l.x1 + o[0], l.y1 + o[1]);
+    }
+}
+
+inline float saturateNone(float x) { return x; }
+inline float saturateSoft(float x) { return x / (1.f + ((x < 0.f) ? -x : x)); }
+inline float saturateHard(float x) { return (x < -1.f) ? -1.f : (x > 1.f) ? 1.f : x; }
+
+///////////////////////////////////////////////////////////////////////////////
+// Modes
+
+enum class LineStyle { solid, dotted, dashed };
+enum class EndStyle { no_ends, arrows, circles };
+enum class Saturation { none, soft, hard };
+enum class Polarity { normal, inverted };
+
+} // end namespace bench
+
+///////////////////////////////////////////////////////////////////////////////
+// StaticMode overloads
+
+namespace staticmode_variant {
+
+using namespace bench;
+
+constexpr staticmode::Mode<LineStyle, LineStyle::solid> solid;
+constexpr staticmode::Mode<LineStyle, LineStyle::dotted> dotted;
+constexpr staticmode::Mode<LineStyle, LineStyle::dashed> dashed;
+
+constexpr staticmode::Mode<EndStyle, EndStyle::no_ends> no_ends;
+constexpr staticmode::Mode<EndStyle, EndStyle::arrows> arrows;
+constexpr staticmode::Mode<EndStyle, EndStyle::circles> circles;
+
+constexpr staticmode::Mode<Saturation, Saturation::none> no_saturation;
+constexpr staticmode::Mode<Saturation, Saturation::soft> soft;
+constexpr staticmode::Mode<Saturation, Saturation::hard> hard;
+
+constexpr staticmode::Mode<Polarity, Polarity::normal> normal;
+constexpr staticmode::Mode<Polarity, Polarity::inverted> inverted;
+
+inline void drawBody_(decltype(solid), Raster& r, const Line& l) { rasterize(r, l, solidPixel); }
+inline void drawBody_(decltype(dotted), Raster& r, const Line& l) { rasterize(r, l, dottedPixel); }
+inline void drawBody_(decltype(dashed), Raster& r, const Line& l) { rasterize(r, l, dashedPixel); }
+
+inline void drawEnds_(decltype(no_ends), Raster&, const Line&) {}
+inline void drawEnds_(decltype(arrows), Raster& r, const Line& l) { drawArrowEnds(r, l); }
+inline void drawEnds_(decltype(circles), Raster& r, const Line& l) { drawCircleEnds(r, l); }
+
+template<typename ModeExpr>
+void drawLine(Raster& r, const Line& l, ModeExpr) {
+    static_assert(staticmode::has_no_other_modes<staticmode::type_pack<LineStyle, EndStyle>, ModeExpr>::value,
+        "drawLine() only accepts LineStyle and EndStyle modes.");
+    drawBody_(staticmode::get_mode_t<LineStyle, ModeExpr, decltype(solid)>{}, r, l);
+    drawEnds_(staticmode::get_mode_t<EndStyle, ModeExpr, decltype(no_ends)>{}, r, l);
+}
+
+inline float saturate_(decltype(no_saturation), float x) { return saturateNone(x); }
+inline float saturate_(decltype(soft), float x) { return saturateSoft(x); }
+inline float saturate_(decltype(hard), float x) { return saturateHard(x); }
+
+inline float polarity_(decltype(normal), float x) { return x; }
+inline float polarity_(decltype(inverted), float x) { return -x; }
+
+template<typename ModeExpr>
+void processBlock(float *x, std::size_t count, ModeExpr) {
+    static_assert(staticmode::has_no_other_modes<staticmode::type_pack<Saturation, Polarity>, ModeExpr>::value,
+        "processBlock() only accepts Saturation and Polarity modes.");
+    using saturation_t = staticmode::get_mode_t<Saturation, ModeExpr, decltype(no_saturation)>;
+    using polarity_t = staticmode::get_mode_t<Polarity, ModeExpr, decltype(normal)>;
+    for (std::size_t i = 0; i < count; ++i)
+        x[i] = polarity_(polarity_t{}, saturate_(saturation_t{}, x[i]));
+}
+
+} // end namespace staticmode_variant
+
+///////////////////////////////////////////////////////////////////////////////
+// Runtime bitmask flags
+
+namespace flags_variant {
+
+using namespace bench;
+
+enum LineStyleFlags { solid = 0, dotted = 0x01, dashed = 0x02, LineStyle_MASK = 0x03 };
+enum EndStyleFlags { no_ends = 0, arrows = 0x04, circles = 0x08, EndStyle_MASK = 0x0c };
+enum SaturationFlags { no_saturation = 0, soft = 0x10, hard = 0x20, Saturation_MASK = 0x30 };
+enum PolarityFlags { normal = 0, inverted = 0x40, Polarity_MASK = 0x40 };
+
+void drawLine(Raster& r, const Line& l, int flags);
+void processBlock(float *x, std::size_t count, int flags);
+
+} // end namespace flags_variant
+
+///////////////////////////////////////////////////////////////////////////////
+// Virtual dispatch: one strategy object per category
+
+namespace virtual_variant {
+
+using namespace bench;
+
+class LineStyleStrategy {
+public:
+    virtual ~LineStyleStrategy();
+    virtual void drawBody(Raster& r, const Line& l) const = 0;
+};
+
+class EndStyleStrategy {
+public:
+    virtual ~EndStyleStrategy();
+    virtual void drawEnds(Raster& r, const Line& l) const = 0;
+};
+
+class SampleProcessor {
+public:
+    virtual ~SampleProcessor();
+    virtual void processBlock(float *x, std::size_t count) const = 0;
+};
+
+// A pen holds the strategies for a line style and an end style
+struct Pen {
+    std::unique_ptr<LineStyleStrategy> body;
+    std::unique_ptr<EndStyleStrategy> ends;
+};
+
+Pen makePen(LineStyle lineStyle, EndStyle endStyle);
+std::unique_ptr<SampleProcessor> makeSampleProcessor(Saturation saturation, Polarity polarity);
+
+inline void drawLine(Raster& r, const Line& l, const Pen& pen) {
+    pen.body->drawBody(r, l);
+    pen.ends->drawEnds(r, l);
+}
+
+} // end namespace virtual_variant
+
+#endif /* INCLUDED_STATICMODE_BENCHMARK_KERNELS_H */
@@ -0,0 +1,84 @@
+# staticmode_isa_objects(<out_var> <source> [ISAS <level>...] [INCLUDE_DIRECTORIES <dir>...])
+#
+# Compiles <source> once per instruction set level, as object libraries
+# <name>_<level>, where <name> is the source file name without extension.
+# Each variant is compiled with -DSTATICMODE_ISA=<level>,
+# -DSTATICMODE_ISA_NS=isa_<level> and the compiler flags for that level, so
+# that <source> can define its kernel overloads for staticmode::compiled_isa_t
+# (see include/StaticModeIsa.h).
+#
+# Every inline function and template that <source> defines must be inside
+# STATICMODE_ISA_NAMESPACE_BEGIN / STATICMODE_ISA_NAMESPACE_END (a namespace
+# per level), or in an anonymous namespace. Otherwise each object has its own
+# copy, compiled for its level, the linker keeps any one of them, and e.g. the
+# avx512 copy may run on a CPU without AVX-512.
+#
+# Sets <out_var> to the list of $<TARGET_OBJECTS:...> expressions, to be
+# added to the sources of an executable or library.
+#
+# Levels default to all of scalar sse2 avx2 avx512, because a dispatcher over
+# staticmode::Isas refers to the kernels for every level. The scalar level
+# uses the compiler's baseline target with auto-vectorization disabled. On
+# other processors than x86, the other levels are built without extra flags
+# (runtime_isa() is always scalar there, so they are never called).
+#
+# example usage:
+#
+#   include(${StaticMode_SOURCE_DIR}/cmake/StaticModeIsa.cmake)
+#   staticmode_isa_objects(SUM_OBJECTS sum_kernels.cpp)
+#   add_executable(app main.cpp ${SUM_OBJECTS})
+
+function(staticmode_isa_flags_ level out_var)
+  set(flags "")
+  if (NOT "${CMAKE_SYSTEM_PROCESSOR}" MATCHES "^(x86_64|AMD64|amd64|i.86|x86)$")
+    if (("${level}" STREQUAL "scalar")
+        AND (("${CMAKE_CXX_COMPILER_ID}" STREQUAL "GNU") OR ("${CMAKE_CXX_COMPILER_ID}" MATCHES "Clang")))
+      set(flags "-fno-tree-vectorize")
+    endif()
+  elseif (("${CMAKE_CXX_COMPILER_ID}" STREQUAL "GNU") OR ("${CMAKE_CXX_COMPILER_ID}" MATCHES "Clang"))
+    if ("${level}" STREQUAL "scalar")
+      set(flags "-fno-tree-vectorize")
+    elseif ("${level}" STREQUAL "sse2")
+      set(flags "-msse2")
+    elseif ("${level}" STREQUAL "avx2")
+      set(flags "-mavx2 -mfma")
+    elseif ("${level}" STREQUAL "avx512")
+      set(flags "-mavx512f -mavx2 -mfma")
+    endif()
+  elseif ("${CMAKE_CXX_COMPILER_ID}" STREQUAL "MSVC")
+    if ("${level}" STREQUAL "avx2")
+      set(flags "/arch:AVX2")
+    elseif ("${level}" STREQUAL "avx512")
+      set(flags "/arch:AVX512")
+    endif()
+  endif()
+  set(${out_var} "${flags}" PARENT_SCOPE)
+endfunction()
+
+function(staticmode_isa_objects out_var source)
+  cmake_parse_arguments(ARG "" "" "ISAS;INCLUDE_DIRECTORIES" ${ARGN})
+
+  if (ARG_ISAS)
+    set(levels ${ARG_ISAS})
+  else()
+    set(levels scalar sse2 avx2 avx512)
+  endif()
+
+  get_filename_component(name "${source}" NAME_WE)
+  set(objects "")
+
+  foreach(level ${levels})
+    staticmode_isa_flags_(${level} flags)
+
+    add_library(${name}_${level} OBJECT ${source})
+    set_target_properties(${name}_${level} PROPERTIES
+      COMPILE_FLAGS "${flags}"
+      COMPILE_DEFINITIONS "STATICMODE_ISA=${level};STATICMODE_ISA_NS=isa_${level}")
+    if (ARG_INCLUDE_DIRECTORIES)
+      set_property(TARGET ${name}_${level} APPEND PROPERTY INCLUDE_DIRECTORIES ${ARG_INCLUDE_DIRECTORIES})
+    endif()
+    list(APPEND objects $<TARGET_OBJECTS:${name}_${level}>)
+  endforeach()
+
+  set(${out_var} ${objects} PARENT_SCOPE)
+endfunction()
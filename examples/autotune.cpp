@@ -0,0 +1,128 @@
+//!clang++ -std=c++11 -O2 -Weverything -Wno-c++98-compat -Wno-unused-const-variable autotune.cpp -I../include -o autotune.out && ./autotune.out
+
+// This example demonstrates `autotune_cached`, which picks the fastest of
+// several equivalent combinations of modes on the host CPU, and remembers the
+// choice for later runs.
+//
+// `WaveshapeKernel` applies `sin()` to a block of samples. Its modes select
+// how: computed with `std::sin` or looked up in a table with linear
+// interpolation, and processed one sample or four samples per iteration.
+// Which combination is fastest depends on the CPU (and compiler), so the
+// first run times all four on a representative block and writes the winning
+// packed key to `autotune.cache`, keyed by CPU model. Later runs load the key
+// from the cache without timing anything, and bind a `mode_function` to it.
+//
+// Usage: autotune [cache file]
+//
+// Delete the cache file (or run on another CPU) to tune again.
+
+#include <chrono>
+#include <cmath> // sin
+#include <cstddef> // size_t
+#include <iostream> // cout
+#include <string>
+#include <vector>
+
+#include "StaticMode.h"
+#include "StaticModeDispatch.h"
+#include "StaticModeTune.h"
+
+enum class Evaluation { compute, table };
+enum class Unroll { x1, x4 };
+
+using Evaluations = staticmode::ModeCategory<Evaluation, Evaluation::compute, Evaluation::table>;
+using Unrolls = staticmode::ModeCategory<Unroll, Unroll::x1, Unroll::x4>;
+
+struct WaveshapeTuning : staticmode::ModeSpace<Evaluations, Unrolls> {};
+
+// sin(x) for x in [0, 2pi), by table lookup with linear interpolation
+class SinTable {
+public:
+    static const std::size_t size = 4096;
+
+    static const SinTable& instance() {
+        static const SinTable table;
+        return table;
+    }
+
+    float operator()(float x) const {
+        float position = x * scale_;
+        std::size_t i = static_cast<std::size_t>(position);
+        float fraction = position - static_cast<float>(i);
+        return values_[i] + fraction * (values_[i + 1] - values_[i]);
+    }
+
+private:
+    SinTable() : scale_(static_cast<float>(size) / 6.28318530718f), values_(size + 1) {
+        for (std::size_t i = 0; i <= size; ++i)
+            values_[i] = static_cast<float>(std::sin(6.28318530718 * static_cast<double>(i) / size));
+    }
+
+    float scale_;
+    std::vector<float> values_;
+};
+
+inline float sin_(staticmode::Mode<Evaluation, Evaluation::compute>, float x) { return std::sin(x); }
+inline float sin_(staticmode::Mode<Evaluation, Evaluation::table>, float x) { return SinTable::instance()(x); }
+
+// out[i] = sin(in[i]), for in[i] in [0, 2pi)
+struct WaveshapeKernel {
+    template<typename ModeExpr>
+    static void apply(const float *in, float *out, std::size_t count) {
+        using evaluation_t = staticmode::get_mode_t<Evaluation, ModeExpr, staticmode::Mode<Evaluation, Evaluation::compute> >;
+        using unroll_t = staticmode::get_mode_t<Unroll, ModeExpr, staticmode::Mode<Unroll, Unroll::x1> >;
+
+        std::size_t i = 0;
+        if (unroll_t::value == Unroll::x4) {
+            for (; i + 4 <= count; i += 4) {
+                out[i] = sin_(evaluation_t{}, in[i]);
+                out[i + 1] = sin_(evaluation_t{}, in[i + 1]);
+                out[i + 2] = sin_(evaluation_t{}, in[i + 2]);
+                out[i + 3] = sin_(evaluation_t{}, in[i + 3]);
+            }
+        }
+        for (; i < count; ++i)
+            out[i] = sin_(evaluation_t{}, in[i]);
+    }
+};
+
+using WaveshapeFunction = staticmode::mode_function<void(const float*, float*, std::size_t), Evaluations, Unrolls>;
+
+static const char *const names[] = { "compute x1", "table x1", "compute x4", "table x4" };
+
+int main(int argc, char *argv[])
+{
+    const std::string cacheFile = (argc > 1) ? argv[1] : "autotune.cache";
+
+    // representative input: a block of phases
+    const std::size_t count = 1 << 14;
+    std::vector<float> in(count), out(count);
+    for (std::size_t i = 0; i < count; ++i)
+        in[i] = 6.28318530718f * static_cast<float>((i * 7919) % count) / static_cast<float>(count);
+    const float *input = in.data();
+    float *output = out.data();
+    std::size_t blockSize = count;
+
+    std::cout << "cpu: " << staticmode::cpu_model() << "\n";
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    staticmode::autotune_result tuned =
+        staticmode::autotune_cached<WaveshapeTuning, WaveshapeKernel>(cacheFile, "waveshape-v1", input, output, blockSize);
+    double startupUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << (tuned.cached ? "loaded " : "tuned ") << names[tuned.key] << " (key " << tuned.key << ") in "
+        << startupUs << " us, " << (tuned.cached ? "from " : "saved to ") << cacheFile << "\n";
+
+    // for reference: the time of each candidate now
+    std::vector<double> times = staticmode::autotune_times<WaveshapeTuning, WaveshapeKernel>(5, input, output, blockSize);
+    for (std::size_t key = 0; key < WaveshapeTuning::size; ++key)
+        std::cout << "  " << names[key] << ": " << times[key] * 1e9 / count << " ns/sample\n";
+
+    WaveshapeFunction waveshape = WaveshapeFunction::bind<WaveshapeKernel>(tuned.key);
+    waveshape(input, output, count);
+
+    float checksum = 0;
+    for (std::size_t i = 0; i < count; ++i)
+        checksum += output[i];
+    std::cout << "checksum: " << checksum << "\n";
+}
@@ -0,0 +1,167 @@
+//!clang++ -std=c++11 -O2 -Weverything -Wno-c++98-compat -Wno-unused-const-variable batch-dispatch.cpp -I../include -o batch-dispatch.out && ./batch-dispatch.out
+
+// This example demonstrates `mode_batch`, which processes an array of
+// records that each carry their own packed mode key.
+//
+// Dispatching per record (a switch or table lookup for every record) costs a
+// mispredicted indirect branch whenever consecutive records have different
+// modes, and prevents the mode-specialized kernels from being vectorized.
+// `mode_batch` instead partitions the records by key in one linear pass
+// (a counting sort), gathers their inputs into contiguous buckets, calls
+// each kernel instantiation once over its bucket, and scatters the results
+// back to the original order.
+//
+// Run with `--benchmark` to compare per-record dispatch with `mode_batch`.
+
+#include <chrono>
+#include <cstdint>
+#include <cstring> // strcmp
+#include <iostream> // cout
+#include <vector>
+
+#include "StaticMode.h"
+#include "StaticModeDispatch.h"
+
+enum class Curve { linear, square, cube };
+
+constexpr staticmode::Mode<Curve, Curve::linear> linear;
+constexpr staticmode::Mode<Curve, Curve::square> square;
+constexpr staticmode::Mode<Curve, Curve::cube> cube;
+
+enum class Clip { unclipped, clipped };
+
+constexpr staticmode::Mode<Clip, Clip::unclipped> unclipped;
+constexpr staticmode::Mode<Clip, Clip::clipped> clipped;
+
+using Curves = staticmode::ModeCategory<Curve, Curve::linear, Curve::square, Curve::cube>;
+using Clips = staticmode::ModeCategory<Clip, Clip::unclipped, Clip::clipped>;
+
+struct ShaperModes : staticmode::ModeSpace<Curves, Clips> {};
+
+struct Record {
+    float value;
+    std::uint8_t modeKey; // ShaperModes packed key
+};
+
+
+inline float curve_(decltype(linear), float x) { return x; }
+inline float curve_(decltype(square), float x) { return x * x; }
+inline float curve_(decltype(cube), float x) { return x * x * x; }
+
+inline float clip_(decltype(unclipped), float x) { return x; }
+inline float clip_(decltype(clipped), float x) { return (x > 1.f) ? 1.f : x; }
+
+template<typename ModeExpr>
+inline float shape(ModeExpr, float x) {
+    using curve_t = staticmode::get_mode_t<Curve, ModeExpr, /*default:*/decltype(linear)>;
+    using clip_t = staticmode::get_mode_t<Clip, ModeExpr, /*default:*/decltype(unclipped)>;
+    return clip_(clip_t{}, curve_(curve_t{}, x));
+}
+
+// Per-record kernel, for per-record dispatch
+struct ShapeOne {
+    template<typename ModeExpr>
+    static float apply(float x) { return shape(ModeExpr{}, x); }
+};
+
+// Bucket kernel: the loop is compiled for a single combination of modes
+struct ShapeBucket {
+    template<typename ModeExpr>
+    static void apply(std::size_t first, std::size_t last, const float *in, float *out) {
+        for (std::size_t i = first; i < last; ++i)
+            out[i] = shape(ModeExpr{}, in[i]);
+    }
+};
+
+// Process /records/ with per-record dispatch
+static void processPerRecord(const std::vector<Record>& records, float *out)
+{
+    using Dispatch = staticmode::multi_dispatch<ShapeOne, ShaperModes>;
+    for (std::size_t i = 0; i < records.size(); ++i)
+        out[i] = Dispatch::find(records[i].modeKey)(records[i].value);
+}
+
+struct BatchProcessor {
+    staticmode::mode_batch<ShaperModes> batch;
+    std::vector<float> sortedIn, sortedOut;
+
+    // Process /records/ one bucket at a time
+    void process(const std::vector<Record>& records, float *out) {
+        const std::size_t count = records.size();
+        batch.partition(count, [&records](std::size_t i) { return records[i].modeKey; });
+
+        sortedIn.resize(count);
+        sortedOut.resize(count);
+        for (std::size_t j = 0; j < count; ++j)
+            sortedIn[j] = records[batch.order()[j]].value;
+
+        batch.for_each_bucket<ShapeBucket>(sortedIn.data(), sortedOut.data());
+        batch.scatter(sortedOut.data(), out);
+    }
+};
+
+template<typename Process>
+static void benchmark(const char *name, const std::vector<Record>& records, Process process)
+{
+    const int iterations = 200;
+    std::vector<float> out(records.size());
+    double checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        process(records, out.data());
+        checksum += static_cast<double>(out[static_cast<std::size_t>(i) % out.size()]);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << "  " << name << ": " << ns / (static_cast<double>(iterations) * static_cast<double>(records.size()))
+        << " ns/record (checksum " << checksum << ")\n";
+}
+
+static std::vector<Record> makeRecords(std::size_t count, bool mixed)
+{
+    std::vector<Record> records;
+    unsigned seed = 1;
+    for (std::size_t i = 0; i < count; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        Record r;
+        r.value = static_cast<float>(seed >> 16) / 32768.f;
+        r.modeKey = static_cast<std::uint8_t>(mixed ? (seed >> 8) % ShaperModes::size : 3);
+        records.push_back(r);
+    }
+    return records;
+}
+
+static void runBenchmarks(bool mixed)
+{
+    std::cout << (mixed ? "mixed modes:\n" : "same modes:\n");
+
+    std::vector<Record> records = makeRecords(16384, mixed);
+    BatchProcessor processor;
+
+    benchmark("per-record dispatch", records,
+        [](const std::vector<Record>& r, float *out) { processPerRecord(r, out); });
+    benchmark("mode_batch", records,
+        [&processor](const std::vector<Record>& r, float *out) { processor.process(r, out); });
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<Record> records = makeRecords(8, true);
+    std::vector<float> perRecord(records.size()), batched(records.size());
+
+    processPerRecord(records, perRecord.data());
+    BatchProcessor processor;
+    processor.process(records, batched.data());
+
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        std::cout << "key " << static_cast<int>(records[i].modeKey) << ": " << records[i].value
+            << " -> " << perRecord[i] << " " << batched[i] << "\n";
+    }
+
+    if (argc > 1 && std::strcmp(argv[1], "--benchmark") == 0) {
+        runBenchmarks(true);
+        runBenchmarks(false);
+    }
+}
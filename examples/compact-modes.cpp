@@ -0,0 +1,109 @@
+//!clang++ -std=c++11 -Weverything -Wno-c++98-compat -Wno-unused-const-variable compact-modes.cpp -I../include -o compact-modes.out && ./compact-modes.out
+
+// This example demonstrates using a `ModeSpace` to give mode expressions
+// a compact canonical type.
+//
+// `drawLine()` accepts any mode expression, but forwards to `drawLine_()`,
+// which is instantiated on `compact_t<PainterModes, ModeExpr>` rather than on
+// `ModeExpr`. As a result:
+//   - `dashed|arrows`, `arrows|dashed` and `dashed|arrows|solid_fill` (with
+//     solid_fill being the default fill) all share a single instantiation.
+//   - the instantiation's symbol is `drawLine_<PackedModes<PainterModes, 5> >`
+//     rather than `drawLine_<ModeSet<Mode<LineStyle, ...>, Mode<EndStyle, ...>, ...> >`,
+//     which keeps the symbol table and debug info small.
+//
+// Compile with -DUSE_COMPACT_MODES=0 to instantiate `drawLine_()` directly on
+// the mode expression and compare symbol and debug info sizes.
+
+#include <iostream> // cout
+
+#include "StaticMode.h"
+
+#ifndef USE_COMPACT_MODES
+#define USE_COMPACT_MODES 1
+#endif
+
+enum class LineStyle { solid, dotted, dashed };
+
+constexpr staticmode::Mode<LineStyle, LineStyle::solid> solid;
+constexpr staticmode::Mode<LineStyle, LineStyle::dotted> dotted;
+constexpr staticmode::Mode<LineStyle, LineStyle::dashed> dashed;
+
+enum class EndStyle { no_ends, arrows, circles };
+
+constexpr staticmode::Mode<EndStyle, EndStyle::no_ends> no_ends;
+constexpr staticmode::Mode<EndStyle, EndStyle::arrows> arrows;
+constexpr staticmode::Mode<EndStyle, EndStyle::circles> circles;
+
+enum class FillStyle { solid_fill, hatched };
+
+constexpr staticmode::Mode<FillStyle, FillStyle::solid_fill> solid_fill;
+constexpr staticmode::Mode<FillStyle, FillStyle::hatched> hatched;
+
+// The first mode listed in each category is that category's default.
+
+using LineStyles = staticmode::ModeCategory<LineStyle, LineStyle::solid, LineStyle::dotted, LineStyle::dashed>;
+using EndStyles = staticmode::ModeCategory<EndStyle, EndStyle::no_ends, EndStyle::arrows, EndStyle::circles>;
+using FillStyles = staticmode::ModeCategory<FillStyle, FillStyle::solid_fill, FillStyle::hatched>;
+
+// A named struct (rather than a type alias) keeps PackedModes<> symbols short.
+struct PainterModes : staticmode::ModeSpace<LineStyles, EndStyles, FillStyles> {};
+
+
+inline void drawLineBody_(decltype(solid)) { std::cout << "__________"; }
+inline void drawLineBody_(decltype(dotted)) { std::cout << ".........."; }
+inline void drawLineBody_(decltype(dashed)) { std::cout << "----------"; }
+
+inline void drawLeftEnd_(decltype(no_ends)) { std::cout << " "; }
+inline void drawLeftEnd_(decltype(arrows)) { std::cout << "<"; }
+inline void drawLeftEnd_(decltype(circles)) { std::cout << "o"; }
+
+inline void drawRightEnd_(decltype(no_ends)) {}
+inline void drawRightEnd_(decltype(arrows)) { std::cout << ">"; }
+inline void drawRightEnd_(decltype(circles)) { std::cout << "o"; }
+
+inline void drawFill_(decltype(solid_fill)) { std::cout << " [solid]"; }
+inline void drawFill_(decltype(hatched)) { std::cout << " [hatched]"; }
+
+// drawLine_ works with any mode expression type, including PackedModes
+template<typename ModeExpr>
+void drawLine_(ModeExpr /*modes*/) {
+    using lineStyle_t = staticmode::get_mode_t<LineStyle, ModeExpr, /*default:*/decltype(solid)>;
+    using endStyle_t = staticmode::get_mode_t<EndStyle, ModeExpr, /*default:*/decltype(no_ends)>;
+    using fillStyle_t = staticmode::get_mode_t<FillStyle, ModeExpr, /*default:*/decltype(solid_fill)>;
+
+    drawLeftEnd_(endStyle_t{});
+    drawLineBody_(lineStyle_t{});
+    drawRightEnd_(endStyle_t{});
+    drawFill_(fillStyle_t{});
+    std::cout << "\n";
+}
+
+template<typename ModeExpr=staticmode::ModeSet<> > // default to empty ModeSet
+inline void drawLine(ModeExpr /*modes*/={}) {
+    static_assert(staticmode::is_mode_expr<ModeExpr>::value == true,
+            "/modes/ argument has unexpected type. Expected a Mode or ModeSet.");
+
+    // (compact_t also rejects modes from categories that are not in PainterModes)
+#if USE_COMPACT_MODES
+    drawLine_(staticmode::compact_t<PainterModes, ModeExpr>{});
+#else
+    drawLine_(ModeExpr{});
+#endif
+}
+
+int main()
+{
+    drawLine(dashed | arrows);
+    drawLine(arrows | dashed);              // same instantiation as dashed|arrows
+    drawLine(dashed | arrows | solid_fill); // same again: solid_fill is the default
+
+    drawLine(dotted | circles | hatched);
+    drawLine(hatched | circles | dotted);   // same instantiation as dotted|circles|hatched
+
+    drawLine(solid | no_ends);
+    drawLine();                             // same instantiation as solid|no_ends
+
+    drawLine(dotted);
+    drawLine(circles | hatched);
+}
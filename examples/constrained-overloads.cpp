@@ -0,0 +1,111 @@
+//!clang++ -std=c++11 -Weverything -Wno-c++98-compat -Wno-unused-const-variable constrained-overloads.cpp -I../include -o constrained-overloads.out && ./constrained-overloads.out
+
+// This example demonstrates constraining mode expression parameters so that
+// invalid mode expressions remove an overload from overload resolution,
+// instead of causing a static_assert failure inside the function body.
+//
+//   - `enable_if_accepts_modes_t` and `enable_if_requires_mode_t` (C++11)
+//     constrain the `drawLine()` overloads below. A line style is drawn by
+//     the first overload, a fill pattern by the second. A mode expression
+//     picks whichever overload accepts it.
+//   - `is_callable_with_modes` probes whether a callable accepts a mode
+//     expression, without instantiating the callable's body.
+//   - With C++20, the `AcceptsModes` and `RequiresMode` concepts can be used
+//     instead of `enable_if_accepts_modes_t` and `enable_if_requires_mode_t`
+//     (see README.md).
+
+#include <iostream> // cout
+
+#include "StaticMode.h"
+
+enum class LineStyle { dotted, dashed, solid };
+
+constexpr staticmode::Mode<LineStyle, LineStyle::dotted> dotted;
+constexpr staticmode::Mode<LineStyle, LineStyle::dashed> dashed;
+constexpr staticmode::Mode<LineStyle, LineStyle::solid> solid;
+
+enum class EndStyle { no_ends, arrows, circles };
+
+constexpr staticmode::Mode<EndStyle, EndStyle::no_ends> no_ends;
+constexpr staticmode::Mode<EndStyle, EndStyle::arrows> arrows;
+constexpr staticmode::Mode<EndStyle, EndStyle::circles> circles;
+
+enum class FillPattern { hatched, checkered };
+
+constexpr staticmode::Mode<FillPattern, FillPattern::hatched> hatched;
+constexpr staticmode::Mode<FillPattern, FillPattern::checkered> checkered;
+
+
+inline void drawLineBody_(decltype(dotted)) { std::cout << ".........."; }
+inline void drawLineBody_(decltype(dashed)) { std::cout << "----------"; }
+inline void drawLineBody_(decltype(solid)) { std::cout << "__________"; }
+
+inline void drawFillBody_(decltype(hatched)) { std::cout << "//////////"; }
+inline void drawFillBody_(decltype(checkered)) { std::cout << "#-#-#-#-#-"; }
+
+inline void drawLeftEnd_(decltype(no_ends)) { std::cout << " "; }
+inline void drawLeftEnd_(decltype(arrows)) { std::cout << "<"; }
+inline void drawLeftEnd_(decltype(circles)) { std::cout << "o"; }
+
+inline void drawRightEnd_(decltype(no_ends)) {}
+inline void drawRightEnd_(decltype(arrows)) { std::cout << ">"; }
+inline void drawRightEnd_(decltype(circles)) { std::cout << "o"; }
+
+// Overload 1: a line style and optional end style
+template<typename ModeExpr,
+    staticmode::enable_if_requires_mode_t<ModeExpr, LineStyle> = 0,
+    staticmode::enable_if_accepts_modes_t<ModeExpr, LineStyle, EndStyle> = 0>
+void drawLine(ModeExpr /*modes*/) {
+    using endStyle_t = staticmode::get_mode_t<EndStyle, ModeExpr, /*default:*/decltype(no_ends)>;
+
+    drawLeftEnd_(endStyle_t{});
+    drawLineBody_(staticmode::get_mode_t<LineStyle, ModeExpr, /*unused default:*/decltype(solid)>{});
+    drawRightEnd_(endStyle_t{});
+    std::cout << "\n";
+}
+
+// Overload 2: a fill pattern and optional end style
+template<typename ModeExpr,
+    staticmode::enable_if_requires_mode_t<ModeExpr, FillPattern> = 0,
+    staticmode::enable_if_accepts_modes_t<ModeExpr, FillPattern, EndStyle> = 0>
+void drawLine(ModeExpr /*modes*/) {
+    using endStyle_t = staticmode::get_mode_t<EndStyle, ModeExpr, /*default:*/decltype(no_ends)>;
+
+    drawLeftEnd_(endStyle_t{});
+    drawFillBody_(staticmode::get_mode_t<FillPattern, ModeExpr, /*unused default:*/decltype(hatched)>{});
+    drawRightEnd_(endStyle_t{});
+    std::cout << "\n";
+}
+
+// A function object that forwards to the drawLine() overload set
+struct DrawLine {
+    template<typename ModeExpr>
+    auto operator()(ModeExpr modes) const -> decltype(drawLine(modes)) { drawLine(modes); }
+};
+
+// Call /f/ with /modes/ if /f/ accepts them, otherwise report that it doesn't
+template<typename F, typename ModeExpr>
+typename std::enable_if<staticmode::is_callable_with_modes<F, ModeExpr>::value>::type
+drawIfAccepted(F f, ModeExpr modes) { f(modes); }
+
+template<typename F, typename ModeExpr>
+typename std::enable_if<!staticmode::is_callable_with_modes<F, ModeExpr>::value>::type
+drawIfAccepted(F, ModeExpr) { std::cout << "(not accepted)\n"; }
+
+int main()
+{
+    drawLine(dotted | arrows);      // overload 1
+    drawLine(dashed);               // overload 1
+    drawLine(checkered | circles);  // overload 2
+    drawLine(hatched);              // overload 2
+
+    drawIfAccepted(DrawLine{}, solid | circles);
+    drawIfAccepted(DrawLine{}, solid | hatched); // neither overload accepts both a line style and a fill
+
+    // The following are correctly caught as compile errors
+    // (no matching overload of drawLine).
+
+    //drawLine(arrows);             // neither a line style nor a fill pattern
+    //drawLine(dotted | hatched);   // both a line style and a fill pattern
+    //drawLine(42);                 // invalid argument type
+}
@@ -0,0 +1,126 @@
+//!clang++ -std=c++11 -O2 -Weverything -Wno-c++98-compat -Wno-unused-const-variable -Wno-exit-time-destructors dispatch-stats.cpp -I../include -pthread -o dispatch-stats.out && ./dispatch-stats.out
+
+// This example demonstrates dispatch instrumentation: counting how often
+// each combination of modes runs, and how long each call takes, with
+// instrument_t. Whether a build is instrumented is itself a mode: with
+// BuildModes = uninstrumented_t, instrument_t<Kernel, ...> is Kernel, and
+// nothing is added.
+//
+// Four worker threads call a `mode_function` bound to different
+// combinations of a mixing kernel. Then the per-thread counters are merged
+// and written to dispatch.stats (or the file named on the command line).
+// Finally, the example compares the time per call with and without
+// instrumentation.
+//
+// Usage: dispatch-stats [stats file]
+
+#include <chrono>
+#include <cstddef> // size_t
+#include <iostream> // cout
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "StaticMode.h"
+#include "StaticModeDispatch.h"
+#include "StaticModeInstrument.h"
+#include "StaticModeNames.h"
+
+enum class Gain { unity, scaled };
+enum class Clip { none, hard };
+enum class Channels { mono, stereo };
+
+using Gains = staticmode::ModeCategory<Gain, Gain::unity, Gain::scaled>;
+using Clips = staticmode::ModeCategory<Clip, Clip::none, Clip::hard>;
+using ChannelLayouts = staticmode::ModeCategory<Channels, Channels::mono, Channels::stereo>;
+
+// mix(out, in, frames)
+using MixFunction = staticmode::mode_function<void(float*, const float*, std::size_t), Gains, Clips, ChannelLayouts>;
+using MixModes = MixFunction::space_type;
+
+STATICMODE_MODE_NAMES(Gain, "gain", "unity", "scaled")
+STATICMODE_MODE_NAMES(Clip, "clip", "none", "hard")
+STATICMODE_MODE_NAMES(Channels, "channels", "mono", "stereo")
+
+namespace {
+
+struct MixKernel {
+    template<typename ModeExpr>
+    static void apply(float *out, const float *in, std::size_t frames) {
+        using gain_t = staticmode::get_mode_t<Gain, ModeExpr, staticmode::Mode<Gain, Gain::unity> >;
+        using clip_t = staticmode::get_mode_t<Clip, ModeExpr, staticmode::Mode<Clip, Clip::none> >;
+        using channels_t = staticmode::get_mode_t<Channels, ModeExpr, staticmode::Mode<Channels, Channels::mono> >;
+
+        const std::size_t n = frames * ((channels_t::value == Channels::stereo) ? 2 : 1);
+        for (std::size_t i = 0; i < n; ++i) {
+            float x = out[i] + ((gain_t::value == Gain::scaled) ? 0.5f * in[i] : in[i]);
+            if (clip_t::value == Clip::hard)
+                x = (x < -1.f) ? -1.f : (x > 1.f) ? 1.f : x;
+            out[i] = x;
+        }
+    }
+};
+
+// the build configuration: change to uninstrumented_t to remove the instrumentation
+using BuildModes = staticmode::instrumented_t;
+
+using Mix = staticmode::instrument_t<MixKernel, MixModes, BuildModes>;
+
+double secondsPerCall(MixFunction mix, std::vector<float>& out, const std::vector<float>& in, std::size_t frames) {
+    const int calls = 200000;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < calls; ++i)
+        mix(out.data(), in.data(), frames);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / calls;
+}
+
+} // end anonymous namespace
+
+int main(int argc, char *argv[]) {
+    const std::string statsFile = (argc > 1) ? argv[1] : "dispatch.stats";
+
+    // each worker mixes with its own combination, a different number of times
+    std::vector<std::thread> workers;
+    for (std::size_t w = 0; w < 4; ++w) {
+        workers.emplace_back([w] {
+            std::vector<float> in(2 * 256, 0.25f), out(2 * 256, 0.f);
+            MixFunction mix = MixFunction::bind<Mix>(w == 3 ? Gain::scaled : Gain::unity,
+                (w & 1) ? Clip::hard : Clip::none, (w >= 2) ? Channels::stereo : Channels::mono);
+            for (std::size_t i = 0; i < 1000 * (w + 1); ++i)
+                mix(out.data(), in.data(), 64 + (i % 4) * 64);
+        });
+    }
+    for (std::thread& t : workers)
+        t.join();
+
+    const staticmode::dispatch_stats stats = staticmode::collect_dispatch_stats<Mix>();
+    if (stats.keys.empty()) {
+        std::cout << "not instrumented\n";
+        return 0;
+    }
+    if (!staticmode::dump_dispatch_stats(statsFile, stats, &staticmode::to_string<MixModes>)) {
+        std::cerr << "can't write " << statsFile << "\n";
+        return 1;
+    }
+    std::cout << "wrote " << statsFile << ":\n" << std::ifstream(statsFile.c_str()).rdbuf();
+
+    for (const staticmode::dispatch_key_stats& s : stats.keys) {
+        if (s.calls != 0) {
+            std::cout << staticmode::to_string<MixModes>(s.key) << ": median <= "
+                << staticmode::dispatch_percentile(s, 50) << " " << stats.unit << ", 99th percentile <= "
+                << staticmode::dispatch_percentile(s, 99) << " " << stats.unit << "\n";
+        }
+    }
+
+    // the cost of instrumentation, per call
+    std::vector<float> in(2 * 16, 0.25f), out(2 * 16, 0.f);
+    const std::size_t key = MixModes::key(Gain::scaled, Clip::hard, Channels::stereo);
+    using TscMix = staticmode::instrument_t<MixKernel, MixModes, BuildModes, staticmode::tsc_ticks>;
+    const double plain = secondsPerCall(MixFunction::bind<MixKernel>(key), out, in, 16);
+    const double steady = secondsPerCall(MixFunction::bind<Mix>(key), out, in, 16);
+    const double tsc = secondsPerCall(MixFunction::bind<TscMix>(key), out, in, 16);
+    std::cout << "16-frame mix: " << plain * 1e9 << " ns/call uninstrumented, " << steady * 1e9
+        << " ns/call with steady_clock_ticks, " << tsc * 1e9 << " ns/call with tsc_ticks\n";
+    return 0;
+}
@@ -0,0 +1,110 @@
+//!clang++ -std=c++11 -Weverything -Wno-c++98-compat -Wno-unused-const-variable hot-swap.cpp -I../include -pthread -o hot-swap.out && ./hot-swap.out
+
+// This example demonstrates changing modes while a real-time thread is
+// running, without locks or allocation on the real-time thread.
+//
+//   - `GainFunction` (a `staticmode::atomic_mode_function`) is the active
+//     dispatch entry: the control thread publishes a new kernel with one
+//     store, and the real-time thread reads it with one acquire load per
+//     block.
+//   - `staticmode::hot_swap<Smoother>` publishes a stateful object. Replaced
+//     objects are deleted on the control thread, once the real-time thread
+//     has reported (with `quiescent()`) that it no longer uses them.
+
+#include <atomic>
+#include <chrono>
+#include <iostream> // cout
+#include <memory> // unique_ptr
+#include <thread>
+
+#include "StaticMode.h"
+#include "StaticModeAtomic.h"
+
+enum class Curve { linear, square };
+
+constexpr staticmode::Mode<Curve, Curve::linear> linear;
+constexpr staticmode::Mode<Curve, Curve::square> square;
+
+enum class Polarity { normal, inverted };
+
+constexpr staticmode::Mode<Polarity, Polarity::normal> normal;
+constexpr staticmode::Mode<Polarity, Polarity::inverted> inverted;
+
+using Curves = staticmode::ModeCategory<Curve, Curve::linear, Curve::square>;
+using Polarities = staticmode::ModeCategory<Polarity, Polarity::normal, Polarity::inverted>;
+
+
+inline float curve_(decltype(linear), float x) { return x; }
+inline float curve_(decltype(square), float x) { return x * x; }
+
+inline float polarity_(decltype(normal), float x) { return x; }
+inline float polarity_(decltype(inverted), float x) { return -x; }
+
+constexpr std::size_t blockSize = 64;
+
+struct GainKernel {
+    template<typename ModeExpr>
+    static void apply(float *block) {
+        using curve_t = staticmode::get_mode_t<Curve, ModeExpr, /*default:*/decltype(linear)>;
+        using polarity_t = staticmode::get_mode_t<Polarity, ModeExpr, /*default:*/decltype(normal)>;
+        for (std::size_t i = 0; i < blockSize; ++i)
+            block[i] = polarity_(polarity_t{}, curve_(curve_t{}, block[i]));
+    }
+};
+
+using GainFunction = staticmode::atomic_mode_function<void(float*), Curves, Polarities>;
+
+// Stateful per-configuration object
+struct Smoother {
+    float coefficient;
+    float state;
+
+    explicit Smoother(float c) : coefficient(c), state(0.f) {}
+
+    float process(float x) { return state += coefficient * (x - state); }
+};
+
+int main()
+{
+    GainFunction gain;
+    gain.store<GainKernel>(linear | normal);
+
+    staticmode::hot_swap<Smoother> smoother(std::unique_ptr<Smoother>(new Smoother(0.5f)));
+
+    std::atomic<bool> running(true);
+    std::atomic<int> blocks(0);
+    float last = 0.f;
+
+    // the real-time thread
+    std::thread audio([&]() {
+        float block[blockSize];
+        while (running.load(std::memory_order_relaxed)) {
+            for (float& x : block)
+                x = 0.5f;
+
+            gain.load()(block);                         // one acquire load, one indirect call
+            Smoother *s = smoother.get();               // one acquire load
+            for (float& x : block)
+                x = s->process(x);
+            last = block[blockSize - 1];
+
+            smoother.quiescent();                       // /s/ is no longer used
+            ++blocks;
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+
+    // the control thread
+    for (int i = 0; i < 4; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        gain.store<GainKernel>(Curve::square, (i % 2) ? Polarity::normal : Polarity::inverted);
+        smoother.publish(std::unique_ptr<Smoother>(new Smoother(0.1f * static_cast<float>(i + 1))));
+        std::cout << "published key " << gain.load().key() << "\n";
+    }
+
+    running = false;
+    audio.join();
+
+    std::cout << "processed " << (blocks > 0 ? "some" : "no") << " blocks, last sample " << last << "\n";
+    std::cout << "retired smoothers pending: " << smoother.collect() << "\n";
+}
@@ -0,0 +1,108 @@
+//!clang++ -std=c++11 -O2 -Weverything -Wno-c++98-compat -Wno-unused-const-variable -Wno-exit-time-destructors manifest.cpp -I../include -o manifest.out && ./manifest.out && ../tools/manifest-report.py manifest.out
+
+// This example demonstrates the instantiation manifest: STATICMODE_MANIFEST()
+// records each combination of modes that a kernel is compiled for in the
+// executable, with no runtime cost. manifest_records() lists them at
+// runtime, and tools/manifest-report.py reads them from the executable file
+// and reports the code size of each combination, and of each mode.
+//
+// `ResampleKernel` resamples a buffer with 3 interpolations x 2 channel
+// layouts x 2 edge policies = 12 instantiations. The report shows which
+// category costs the most code: here, cubic interpolation.
+//
+// Usage: manifest, then: tools/manifest-report.py <path to manifest>
+
+#include <cstddef> // size_t
+#include <cstdio> // printf
+#include <vector>
+
+#include "StaticMode.h"
+#include "StaticModeDispatch.h"
+#include "StaticModeManifest.h"
+#include "StaticModeNames.h"
+
+enum class Interpolation { nearest, linear, cubic };
+enum class Channels { mono, stereo };
+enum class Edge { clamp, wrap };
+
+using Interpolations = staticmode::ModeCategory<Interpolation, Interpolation::nearest, Interpolation::linear, Interpolation::cubic>;
+using ChannelLayouts = staticmode::ModeCategory<Channels, Channels::mono, Channels::stereo>;
+using Edges = staticmode::ModeCategory<Edge, Edge::clamp, Edge::wrap>;
+
+// resample(in, count, out, outCount), bound to runtime modes (see StaticModeDispatch.h)
+using ResampleFunction = staticmode::mode_function<void(const float*, std::size_t, float*, std::size_t),
+    Interpolations, ChannelLayouts, Edges>;
+using ResampleModes = ResampleFunction::space_type;
+
+STATICMODE_MODE_NAMES(Interpolation, "interpolation", "nearest", "linear", "cubic")
+STATICMODE_MODE_NAMES(Channels, "channels", "mono", "stereo")
+STATICMODE_MODE_NAMES(Edge, "edge", "clamp", "wrap")
+
+namespace {
+
+template<typename ModeExpr>
+long sampleIndex(long i, long n) {
+    using edge_t = staticmode::get_mode_t<Edge, ModeExpr, staticmode::Mode<Edge, Edge::clamp> >;
+    if (edge_t::value == Edge::wrap)
+        return ((i % n) + n) % n;
+    return (i < 0) ? 0 : (i >= n) ? n - 1 : i;
+}
+
+template<typename ModeExpr>
+float interpolate(const float *x, long n, long stride, double position) {
+    using interpolation_t = staticmode::get_mode_t<Interpolation, ModeExpr, staticmode::Mode<Interpolation, Interpolation::nearest> >;
+    const long i = static_cast<long>(position);
+    const float t = static_cast<float>(position - static_cast<double>(i));
+    auto at = [&](long j) { return x[sampleIndex<ModeExpr>(j, n) * stride]; };
+
+    switch (interpolation_t::value) {
+    case Interpolation::nearest:
+        return at((t < 0.5f) ? i : i + 1);
+    case Interpolation::linear:
+        return at(i) + t * (at(i + 1) - at(i));
+    case Interpolation::cubic: {
+        // Catmull-Rom
+        const float p0 = at(i - 1), p1 = at(i), p2 = at(i + 1), p3 = at(i + 2);
+        return p1 + 0.5f * t * (p2 - p0 + t * (2.f * p0 - 5.f * p1 + 4.f * p2 - p3 + t * (3.f * (p1 - p2) + p3 - p0)));
+    }
+    }
+    return 0.f;
+}
+
+struct ResampleKernel {
+    // resample /count/ frames of /in/ to /outCount/ frames of /out/
+    template<typename ModeExpr>
+    static void apply(const float *in, std::size_t count, float *out, std::size_t outCount) {
+        STATICMODE_MANIFEST(ResampleModes, ModeExpr);
+
+        using channels_t = staticmode::get_mode_t<Channels, ModeExpr, staticmode::Mode<Channels, Channels::mono> >;
+        const long channels = (channels_t::value == Channels::stereo) ? 2 : 1;
+        const double step = static_cast<double>(count) / static_cast<double>(outCount);
+        for (std::size_t j = 0; j < outCount; ++j) {
+            const double position = static_cast<double>(j) * step;
+            for (long c = 0; c < channels; ++c)
+                out[static_cast<long>(j) * channels + c] = interpolate<ModeExpr>(in + c, static_cast<long>(count), channels, position);
+        }
+    }
+};
+
+} // end anonymous namespace
+
+int main() {
+    std::vector<float> in(2 * 100), out(2 * 147);
+    for (std::size_t i = 0; i < in.size(); ++i)
+        in[i] = static_cast<float>(i % 17);
+
+    // binding at runtime instantiates every combination
+    for (std::size_t key = 0; key < ResampleModes::size; ++key) {
+        ResampleFunction resample = ResampleFunction::bind<ResampleKernel>(key);
+        resample(in.data(), 100, out.data(), 147);
+    }
+
+    std::vector<staticmode::manifest_record> records = staticmode::manifest_records();
+    std::printf("%u combinations in this executable:\n", static_cast<unsigned>(records.size()));
+    for (const staticmode::manifest_record& r : records)
+        std::printf("  %2u  %016llx  %s\n", static_cast<unsigned>(r.key), static_cast<unsigned long long>(r.hash), r.name);
+    std::printf("run tools/manifest-report.py on this executable for the code size of each\n");
+    return 0;
+}
@@ -0,0 +1,85 @@
+//!clang++ -std=c++11 -Weverything -Wno-c++98-compat -Wno-unused-const-variable mode-function.cpp -I../include -o mode-function.out && ./mode-function.out
+
+// This example demonstrates `mode_function`, a replacement for a
+// `std::function` that wraps a lambda that switches on runtime modes.
+//
+// `DrawLineKernel::apply<ModeExpr>` is a family of mode-specialized kernels.
+// `DrawLineFunction::bind<DrawLineKernel>(lineStyle, endStyle)` resolves the
+// kernel for runtime mode values once, when the callback is configured.
+// The resulting `DrawLineFunction` is two words, trivially copyable, and
+// calling it is a single indirect call: no switch, no allocation.
+// `try_bind` is the checked form, for values that come from outside the
+// program: it returns an unbound function for a value that is not a mode.
+
+#include <iostream> // cout
+#include <vector>
+
+#include "StaticMode.h"
+#include "StaticModeDispatch.h"
+
+enum class LineStyle { dotted, dashed, solid };
+
+constexpr staticmode::Mode<LineStyle, LineStyle::dotted> dotted;
+constexpr staticmode::Mode<LineStyle, LineStyle::dashed> dashed;
+constexpr staticmode::Mode<LineStyle, LineStyle::solid> solid;
+
+enum class EndStyle { no_ends, arrows, circles };
+
+constexpr staticmode::Mode<EndStyle, EndStyle::no_ends> no_ends;
+constexpr staticmode::Mode<EndStyle, EndStyle::arrows> arrows;
+constexpr staticmode::Mode<EndStyle, EndStyle::circles> circles;
+
+using LineStyles = staticmode::ModeCategory<LineStyle, LineStyle::solid, LineStyle::dotted, LineStyle::dashed>;
+using EndStyles = staticmode::ModeCategory<EndStyle, EndStyle::no_ends, EndStyle::arrows, EndStyle::circles>;
+
+
+inline void drawLineBody_(decltype(dotted), int length) { while (length--) std::cout << "."; }
+inline void drawLineBody_(decltype(dashed), int length) { while (length--) std::cout << "-"; }
+inline void drawLineBody_(decltype(solid), int length) { while (length--) std::cout << "_"; }
+
+inline void drawLeftEnd_(decltype(no_ends)) { std::cout << " "; }
+inline void drawLeftEnd_(decltype(arrows)) { std::cout << "<"; }
+inline void drawLeftEnd_(decltype(circles)) { std::cout << "o"; }
+
+inline void drawRightEnd_(decltype(no_ends)) {}
+inline void drawRightEnd_(decltype(arrows)) { std::cout << ">"; }
+inline void drawRightEnd_(decltype(circles)) { std::cout << "o"; }
+
+struct DrawLineKernel {
+    template<typename ModeExpr>
+    static void apply(int length) {
+        using lineStyle_t = staticmode::get_mode_t<LineStyle, ModeExpr, /*default:*/decltype(solid)>;
+        using endStyle_t = staticmode::get_mode_t<EndStyle, ModeExpr, /*default:*/decltype(no_ends)>;
+
+        drawLeftEnd_(endStyle_t{});
+        drawLineBody_(lineStyle_t{}, length);
+        drawRightEnd_(endStyle_t{});
+        std::cout << "\n";
+    }
+};
+
+using DrawLineFunction = staticmode::mode_function<void(int), LineStyles, EndStyles>;
+
+int main()
+{
+    std::vector<DrawLineFunction> callbacks;
+
+    // bind runtime values (e.g. from a config file). The last one is not an EndStyle.
+    const int config[][2] = { { 1, 1 }, { 0, 2 }, { 2, 3 } };
+    for (const int *entry : config) {
+        DrawLineFunction f = DrawLineFunction::try_bind<DrawLineKernel>(
+            static_cast<LineStyle>(entry[0]), static_cast<EndStyle>(entry[1]));
+        if (f)
+            callbacks.push_back(f);
+        else
+            std::cout << "invalid config: " << entry[0] << ", " << entry[1] << "\n";
+    }
+
+    // bind a mode expression
+    callbacks.push_back(DrawLineFunction::bind<DrawLineKernel>(solid));
+
+    for (const DrawLineFunction& f : callbacks)
+        f(8);
+
+    std::cout << "sizeof(DrawLineFunction): " << sizeof(DrawLineFunction) << "\n";
+}
@@ -0,0 +1,106 @@
+//!clang++ -std=c++11 -Weverything -Wno-c++98-compat -Wno-unused-const-variable mode-keyed.cpp -I../include -o mode-keyed.out && ./mode-keyed.out
+
+// This example demonstrates `mode_keyed`, a base class for small objects that
+// store their packed mode key in a single byte instead of a vtable pointer.
+//
+// `KeyedPainter` has the same family of mode-configured `drawLine`
+// implementations as `AsciiPainterT` in type-erasure.cpp, but the
+// implementation is chosen per object at runtime. `drawLine()` dispatches
+// through a per-class table of function pointers indexed by the object's key
+// (built at compile time), so dispatch is O(1) like a virtual call.
+//
+// A `KeyedPainter` with a one-byte length field is 2 bytes, whereas an
+// equivalent class with virtual functions is 16 bytes on a typical 64-bit
+// platform (vtable pointer plus padding), so large arrays of them are much
+// denser.
+
+#include <iostream> // cout
+#include <vector>
+
+#include "StaticMode.h"
+#include "StaticModeErasure.h"
+
+enum class LineStyle { dotted, dashed, solid };
+
+constexpr staticmode::Mode<LineStyle, LineStyle::dotted> dotted;
+constexpr staticmode::Mode<LineStyle, LineStyle::dashed> dashed;
+constexpr staticmode::Mode<LineStyle, LineStyle::solid> solid;
+
+enum class EndStyle { no_ends, arrows, circles };
+
+constexpr staticmode::Mode<EndStyle, EndStyle::no_ends> no_ends;
+constexpr staticmode::Mode<EndStyle, EndStyle::arrows> arrows;
+constexpr staticmode::Mode<EndStyle, EndStyle::circles> circles;
+
+using LineStyles = staticmode::ModeCategory<LineStyle, LineStyle::solid, LineStyle::dotted, LineStyle::dashed>;
+using EndStyles = staticmode::ModeCategory<EndStyle, EndStyle::no_ends, EndStyle::arrows, EndStyle::circles>;
+
+struct PainterModes : staticmode::ModeSpace<LineStyles, EndStyles> {};
+
+
+class KeyedPainter : public staticmode::mode_keyed<KeyedPainter, PainterModes> {
+    static char line_(decltype(dotted)) { return '.'; }
+    static char line_(decltype(dashed)) { return '-'; }
+    static char line_(decltype(solid)) { return '_'; }
+
+    static const char *leftEnd_(decltype(no_ends)) { return " "; }
+    static const char *leftEnd_(decltype(arrows)) { return "<"; }
+    static const char *leftEnd_(decltype(circles)) { return "o"; }
+
+    static const char *rightEnd_(decltype(no_ends)) { return ""; }
+    static const char *rightEnd_(decltype(arrows)) { return ">"; }
+    static const char *rightEnd_(decltype(circles)) { return "o"; }
+
+    // The mode-configured implementation of drawLine()
+    struct DrawLine {
+        template<typename ModeExpr>
+        static void apply(const KeyedPainter& self) {
+            using lineStyle_t = staticmode::get_mode_t<LineStyle, ModeExpr, /*default:*/decltype(solid)>;
+            using endStyle_t = staticmode::get_mode_t<EndStyle, ModeExpr, /*default:*/decltype(no_ends)>;
+
+            std::cout << leftEnd_(endStyle_t{});
+            for (unsigned i = 0; i < self.length_; ++i)
+                std::cout << line_(lineStyle_t{});
+            std::cout << rightEnd_(endStyle_t{}) << "\n";
+        }
+    };
+
+    unsigned char length_;
+
+public:
+    template<typename ModeExpr>
+    KeyedPainter(ModeExpr modes, unsigned char length) : mode_keyed(modes), length_(length) {}
+
+    KeyedPainter(std::size_t key, unsigned char length) : mode_keyed(key), length_(length) {}
+
+    void drawLine() const { dispatch<DrawLine>(); }
+};
+
+// For comparison: the size of an equivalent class with a virtual function
+class VirtualPainter {
+public:
+    virtual ~VirtualPainter();
+    virtual void drawLine() const = 0;
+protected:
+    unsigned char length_ = 0;
+};
+
+VirtualPainter::~VirtualPainter() {}
+
+int main()
+{
+    std::vector<KeyedPainter> painters;
+    painters.push_back(KeyedPainter(dashed|arrows, 10));
+    painters.push_back(KeyedPainter(dotted|circles, 6));
+
+    // runtime values (e.g. from a config file) must be checked
+    const std::size_t key = PainterModes::key(LineStyle::solid, EndStyle::arrows);
+    if (KeyedPainter::valid_key(key))
+        painters.push_back(KeyedPainter(key, 3));
+
+    for (const KeyedPainter& p : painters)
+        p.drawLine();
+
+    std::cout << "sizeof(KeyedPainter): " << sizeof(KeyedPainter) << "\n";
+    std::cout << "sizeof(VirtualPainter): " << sizeof(VirtualPainter) << "\n";
+}
@@ -0,0 +1,63 @@
+//!clang++ -std=c++11 -Weverything -Wno-c++98-compat -Wno-unused-const-variable -Wno-exit-time-destructors mode-names.cpp -I../include -o mode-names.out && ./mode-names.out "line=dashed,end=arrows"
+
+// This example demonstrates naming modes with `STATICMODE_MODE_NAMES` (see
+// StaticModeNames.h), converting mode expressions to strings with
+// `to_string()`, and parsing mode strings such as "line=dashed,end=arrows"
+// (e.g. from a config file or the command line) into packed keys with
+// `parse_modes()`.
+//
+// Mode names are looked up with a perfect hash computed at compile time, so
+// parsing does not allocate and does not compare against each name in turn.
+//
+// Run with a mode string as the first argument, e.g.:
+//
+//   ./mode-names "end=circles,line=dotted"
+
+#include <iostream> // cout
+
+#include "StaticMode.h"
+#include "StaticModeNames.h"
+
+enum class LineStyle { solid, dotted, dashed };
+
+constexpr staticmode::Mode<LineStyle, LineStyle::solid> solid;
+constexpr staticmode::Mode<LineStyle, LineStyle::dotted> dotted;
+constexpr staticmode::Mode<LineStyle, LineStyle::dashed> dashed;
+
+enum class EndStyle { no_ends, arrows, circles };
+
+constexpr staticmode::Mode<EndStyle, EndStyle::no_ends> no_ends;
+constexpr staticmode::Mode<EndStyle, EndStyle::arrows> arrows;
+constexpr staticmode::Mode<EndStyle, EndStyle::circles> circles;
+
+STATICMODE_MODE_NAMES(LineStyle, "line", "solid", "dotted", "dashed")
+STATICMODE_MODE_NAMES(EndStyle, "end", "none", "arrows", "circles")
+
+using LineStyles = staticmode::ModeCategory<LineStyle, LineStyle::solid, LineStyle::dotted, LineStyle::dashed>;
+using EndStyles = staticmode::ModeCategory<EndStyle, EndStyle::no_ends, EndStyle::arrows, EndStyle::circles>;
+
+struct PainterModes : staticmode::ModeSpace<LineStyles, EndStyles> {};
+
+int main(int argc, char *argv[])
+{
+    // Names are available at compile time
+    static_assert(staticmode::mode_name(dashed)[0] == 'd', "");
+
+    std::cout << staticmode::to_string(dotted | circles) << "\n";
+    std::cout << staticmode::to_string(staticmode::compact<PainterModes>(arrows)) << "\n"; // includes the default line style
+
+    const char *config = (argc > 1) ? argv[1] : "line=dashed,end=arrows";
+
+    std::size_t key = staticmode::parse_modes<PainterModes>(config);
+    if (key == PainterModes::size) {
+        std::cout << "invalid mode string: \"" << config << "\"\n";
+        return 1;
+    }
+
+    std::cout << "\"" << config << "\" -> key " << key
+        << " (" << staticmode::to_string<PainterModes>(key) << ")\n";
+
+    std::cout << "line style: " << staticmode::mode_name(PainterModes::value<LineStyle>(key)) << "\n";
+    std::cout << "end style: " << staticmode::mode_name(PainterModes::value<EndStyle>(key)) << "\n";
+    return 0;
+}
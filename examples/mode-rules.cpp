@@ -0,0 +1,96 @@
+//!clang++ -std=c++11 -Weverything -Wno-c++98-compat -Wno-unused-const-variable mode-rules.cpp -I../include -o mode-rules.out && ./mode-rules.out
+
+// This example demonstrates using `ModeRules` to declare which combinations
+// of modes are valid:
+//
+//   - "circles requires solid": circle ends may only be drawn on solid lines
+//   - "dotted excludes arrows": dotted lines may not have arrow ends
+//
+// The same rules are used in two ways:
+//   - `drawLine()` uses `is_allowed` to reject invalid mode expressions at
+//     compile time.
+//   - `validateConfig()` checks runtime values (e.g. from a config file) with
+//     a single bit test in a bitmap computed at compile time.
+//
+// Uncomment the lines at the end of `main()` to test the compile-time error checking.
+
+#include <iostream> // cout
+
+#include "StaticMode.h"
+
+enum class LineStyle { solid, dotted, dashed };
+
+constexpr staticmode::Mode<LineStyle, LineStyle::solid> solid;
+constexpr staticmode::Mode<LineStyle, LineStyle::dotted> dotted;
+constexpr staticmode::Mode<LineStyle, LineStyle::dashed> dashed;
+
+enum class EndStyle { no_ends, arrows, circles };
+
+constexpr staticmode::Mode<EndStyle, EndStyle::no_ends> no_ends;
+constexpr staticmode::Mode<EndStyle, EndStyle::arrows> arrows;
+constexpr staticmode::Mode<EndStyle, EndStyle::circles> circles;
+
+using LineStyles = staticmode::ModeCategory<LineStyle, LineStyle::solid, LineStyle::dotted, LineStyle::dashed>;
+using EndStyles = staticmode::ModeCategory<EndStyle, EndStyle::no_ends, EndStyle::arrows, EndStyle::circles>;
+
+struct PainterModes : staticmode::ModeSpace<LineStyles, EndStyles> {};
+
+using PainterRules = staticmode::ModeRules<PainterModes,
+    staticmode::Requires<decltype(circles), decltype(solid)>,
+    staticmode::Excludes<decltype(dotted), decltype(arrows)> >;
+
+
+inline void drawLineBody_(decltype(solid)) { std::cout << "__________"; }
+inline void drawLineBody_(decltype(dotted)) { std::cout << ".........."; }
+inline void drawLineBody_(decltype(dashed)) { std::cout << "----------"; }
+
+inline void drawLeftEnd_(decltype(no_ends)) { std::cout << " "; }
+inline void drawLeftEnd_(decltype(arrows)) { std::cout << "<"; }
+inline void drawLeftEnd_(decltype(circles)) { std::cout << "o"; }
+
+inline void drawRightEnd_(decltype(no_ends)) {}
+inline void drawRightEnd_(decltype(arrows)) { std::cout << ">"; }
+inline void drawRightEnd_(decltype(circles)) { std::cout << "o"; }
+
+template<typename ModeExpr=staticmode::ModeSet<> > // default to empty ModeSet
+void drawLine(ModeExpr /*modes*/={}) {
+    static_assert(staticmode::is_mode_expr<ModeExpr>::value == true,
+            "/modes/ argument has unexpected type. Expected a Mode or ModeSet.");
+
+    static_assert(staticmode::is_allowed<PainterRules, ModeExpr>::value,
+            "/modes/ is not an allowed combination. "
+            "(circles requires solid, dotted excludes arrows)");
+
+    using lineStyle_t = staticmode::get_mode_t<LineStyle, ModeExpr, /*default:*/decltype(solid)>;
+    using endStyle_t = staticmode::get_mode_t<EndStyle, ModeExpr, /*default:*/decltype(no_ends)>;
+
+    drawLeftEnd_(endStyle_t{});
+    drawLineBody_(lineStyle_t{});
+    drawRightEnd_(endStyle_t{});
+    std::cout << "\n";
+}
+
+// Validate runtime configuration values
+static bool validateConfig(LineStyle lineStyle, EndStyle endStyle)
+{
+    return PainterRules::test(PainterModes::key(lineStyle, endStyle));
+}
+
+int main()
+{
+    drawLine(solid | circles);
+    drawLine(dotted | no_ends);
+    drawLine(dashed | arrows);
+    drawLine(circles); // ok: default line style is solid
+
+    std::cout << "dashed|circles valid: " << validateConfig(LineStyle::dashed, EndStyle::circles) << "\n";
+    std::cout << "dashed|arrows valid: " << validateConfig(LineStyle::dashed, EndStyle::arrows) << "\n";
+    std::cout << "dotted|arrows valid: " << validateConfig(LineStyle::dotted, EndStyle::arrows) << "\n";
+
+    // The following are correctly caught as compile errors.
+    // Uncomment any of the lines below and you'll get an informative
+    // static_assert-based compiler error.
+
+    //drawLine(dashed | circles);   // circles requires solid
+    //drawLine(dotted | arrows);    // dotted excludes arrows
+}
@@ -0,0 +1,120 @@
+//!clang++ -std=c++11 -O2 -Weverything -Wno-c++98-compat -Wno-unused-const-variable -Wno-exit-time-destructors mode-sweep.cpp -I../include -pthread -o mode-sweep.out && ./mode-sweep.out
+
+// This example demonstrates `sweep`, which runs a kernel once for every
+// combination of modes in a `ModeSpace` (every instantiation), in parallel,
+// and reports the time and an output checksum of each combination.
+//
+// `HashKernel` hashes a buffer of 64-bit words. It has 4 unroll factors x
+// 2 accumulator layouts x 3 block sizes x 2 traversal orders = 48
+// instantiations. They must all produce the same hash (the hash is a sum, so
+// the order of the additions doesn't matter). The sweep checks that
+// they do, names the slowest and fastest combinations, and writes a report.
+//
+// Usage: mode-sweep [threads] [report.csv] [report.json]
+//
+// With threads = 0 (the default) the sweep uses every hardware thread.
+
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <cstdlib> // atoi
+#include <fstream>
+#include <iostream> // cout
+#include <vector>
+
+#include "StaticMode.h"
+#include "StaticModeNames.h"
+#include "StaticModeSweep.h"
+
+enum class Unroll { x1, x2, x4, x8 };
+enum class Accumulators { single, dual };
+enum class Blocking { none, b256, b4096 };
+enum class Order { forward, reverse };
+
+using Unrolls = staticmode::ModeCategory<Unroll, Unroll::x1, Unroll::x2, Unroll::x4, Unroll::x8>;
+using AccumulatorLayouts = staticmode::ModeCategory<Accumulators, Accumulators::single, Accumulators::dual>;
+using Blockings = staticmode::ModeCategory<Blocking, Blocking::none, Blocking::b256, Blocking::b4096>;
+using Orders = staticmode::ModeCategory<Order, Order::forward, Order::reverse>;
+
+struct HashModes : staticmode::ModeSpace<Unrolls, AccumulatorLayouts, Blockings, Orders> {};
+
+STATICMODE_MODE_NAMES(Unroll, "unroll", "x1", "x2", "x4", "x8")
+STATICMODE_MODE_NAMES(Accumulators, "acc", "single", "dual")
+STATICMODE_MODE_NAMES(Blocking, "block", "none", "256", "4096")
+STATICMODE_MODE_NAMES(Order, "order", "forward", "reverse")
+
+constexpr std::size_t unrollFactor(Unroll u) { return (u == Unroll::x1) ? 1 : (u == Unroll::x2) ? 2 : (u == Unroll::x4) ? 4 : 8; }
+constexpr std::size_t blockSize(Blocking b, std::size_t n) { return (b == Blocking::b256) ? 256 : (b == Blocking::b4096) ? 4096 : n; }
+
+inline std::uint64_t mix(std::uint64_t x) { return (x ^ (x >> 29)) * 0xbf58476d1ce4e5b9ull; }
+
+// sum of mix(words[i]): the same for every combination of modes
+struct HashKernel {
+    template<typename ModeExpr>
+    static std::uint64_t apply(const std::vector<std::uint64_t>& words) {
+        using unroll_t = staticmode::get_mode_t<Unroll, ModeExpr, staticmode::Mode<Unroll, Unroll::x1> >;
+        using accumulators_t = staticmode::get_mode_t<Accumulators, ModeExpr, staticmode::Mode<Accumulators, Accumulators::single> >;
+        using blocking_t = staticmode::get_mode_t<Blocking, ModeExpr, staticmode::Mode<Blocking, Blocking::none> >;
+        using order_t = staticmode::get_mode_t<Order, ModeExpr, staticmode::Mode<Order, Order::forward> >;
+
+        const std::size_t n = words.size();
+        const std::size_t unroll = unrollFactor(unroll_t::value);
+        const std::size_t block = blockSize(blocking_t::value, n);
+        const bool dual = (accumulators_t::value == Accumulators::dual);
+        const bool reverse = (order_t::value == Order::reverse);
+
+        std::uint64_t acc[2] = { 0, 0 };
+        for (std::size_t b = 0; b < n; b += block) {
+            const std::size_t end = (b + block < n) ? b + block : n;
+            std::size_t i = b;
+            for (; i + unroll <= end; i += unroll) {
+                for (std::size_t j = 0; j < unroll; ++j) { // constant trip count: unrolled by the compiler
+                    std::size_t k = reverse ? n - 1 - (i + j) : i + j;
+                    acc[dual ? (j & 1) : 0] += mix(words[k]);
+                }
+            }
+            for (; i < end; ++i)
+                acc[0] += mix(words[reverse ? n - 1 - i : i]);
+        }
+        return acc[0] + acc[1];
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    const unsigned threads = (argc > 1) ? static_cast<unsigned>(std::atoi(argv[1])) : 0;
+
+    std::vector<std::uint64_t> words(1 << 18);
+    for (std::size_t i = 0; i < words.size(); ++i)
+        words[i] = i * 0x9e3779b97f4a7c15ull;
+
+    std::vector<staticmode::sweep_result> results = staticmode::sweep<HashModes, HashKernel>(threads, 5, words);
+
+    std::size_t mismatches = 0, fastest = 0, slowest = 0;
+    for (const staticmode::sweep_result& r : results) {
+        if (r.checksum != results[0].checksum) {
+            std::cout << "checksum mismatch: " << staticmode::to_string<HashModes>(r.key) << "\n";
+            ++mismatches;
+        }
+        if (r.seconds < results[fastest].seconds)
+            fastest = r.key;
+        if (r.seconds > results[slowest].seconds)
+            slowest = r.key;
+    }
+
+    std::cout << results.size() << " combinations, " << mismatches << " checksum mismatches\n"
+        << "fastest: " << staticmode::to_string<HashModes>(fastest) << " "
+        << results[fastest].seconds * 1e9 / static_cast<double>(words.size()) << " ns/word\n"
+        << "slowest: " << staticmode::to_string<HashModes>(slowest) << " "
+        << results[slowest].seconds * 1e9 / static_cast<double>(words.size()) << " ns/word\n";
+
+    if (argc > 2) {
+        std::ofstream csv(argv[2]);
+        staticmode::write_sweep_csv(csv, results, &staticmode::to_string<HashModes>);
+    }
+    if (argc > 3) {
+        std::ofstream json(argv[3]);
+        staticmode::write_sweep_json(json, results, &staticmode::to_string<HashModes>);
+    }
+
+    return (mismatches == 0) ? 0 : 1;
+}
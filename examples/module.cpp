@@ -0,0 +1,46 @@
+//!g++ -std=c++20 -fmodules-ts -I../include -x c++ ../include/StaticMode.cppm module.cpp -o module.out && ./module.out
+
+// This is the minimal example (see minimal.cpp), but it uses the C++20
+// named module `staticmode` instead of including StaticMode.h.
+//
+// The module is only built when CMake is configured with
+// -DSTATICMODE_BUILD_MODULE=ON (requires CMake 3.28 or newer, a generator
+// that supports C++20 modules such as Ninja, and a C++20 compiler with
+// modules support).
+
+#include <iostream> // cout
+
+import staticmode;
+
+enum class LineStyle { dotted, dashed };
+
+constexpr staticmode::Mode<LineStyle, LineStyle::dotted> dotted;
+constexpr staticmode::Mode<LineStyle, LineStyle::dashed> dashed;
+
+enum class EndStyle { arrow, circle };
+
+constexpr staticmode::Mode<EndStyle, EndStyle::arrow> arrow;
+constexpr staticmode::Mode<EndStyle, EndStyle::circle> circle;
+
+inline void drawLine_(decltype(dotted)) { std::cout << "....."; }
+inline void drawLine_(decltype(dashed)) { std::cout << "-----"; }
+inline void drawRightEnd_(decltype(arrow)) { std::cout << ">"; }
+inline void drawRightEnd_(decltype(circle)) { std::cout << "o"; }
+
+template<typename ModeExpr=staticmode::ModeSet<> > // default to empty ModeSet
+void drawLine(ModeExpr /*modes*/={}) {
+    using lineStyle_t = staticmode::get_mode_t<LineStyle, ModeExpr, /*default:*/decltype(dashed)>;
+    using endStyle_t = staticmode::get_mode_t<EndStyle, ModeExpr, /*default:*/decltype(arrow)>;
+
+    drawLine_(lineStyle_t{});
+    drawRightEnd_(endStyle_t{});
+    std::cout << "\n";
+}
+
+int main()
+{
+    drawLine(dotted|circle);
+    drawLine(dotted); // defaults to arrow end style
+    drawLine(circle); // defaults to dashed line style
+    drawLine();       // defaults to dashed|arrow
+}
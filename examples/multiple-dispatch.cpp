@@ -0,0 +1,101 @@
+//!clang++ -std=c++11 -Weverything -Wno-c++98-compat -Wno-unused-const-variable multiple-dispatch.cpp -I../include -o multiple-dispatch.out && ./multiple-dispatch.out
+
+// This example demonstrates dispatching on the runtime modes of two objects.
+//
+// `Image` stores its pixel format as a packed mode key. `convertPixels()`
+// depends on the formats of both the source and the destination image.
+// `ConvertDispatch` (a `staticmode::multi_dispatch`) is one table of all
+// 3 x 3 instantiations of `ConvertKernel::apply<FromModes, ToModes>`, so a
+// conversion costs one table lookup and one indirect call, instead of a
+// nested switch or a double virtual dispatch.
+//
+// `sameChannelCount()` does not depend on the order of its operands, so
+// `ChannelCountDispatch` (a `staticmode::symmetric_dispatch`) only
+// instantiates the 6 unordered pairs of formats.
+
+#include <cstdint>
+#include <iostream> // cout
+#include <vector>
+
+#include "StaticMode.h"
+#include "StaticModeDispatch.h"
+
+enum class PixelFormat { gray8, rgb24, rgba32 };
+
+constexpr staticmode::Mode<PixelFormat, PixelFormat::gray8> gray8;
+constexpr staticmode::Mode<PixelFormat, PixelFormat::rgb24> rgb24;
+constexpr staticmode::Mode<PixelFormat, PixelFormat::rgba32> rgba32;
+
+using PixelFormats = staticmode::ModeCategory<PixelFormat, PixelFormat::gray8, PixelFormat::rgb24, PixelFormat::rgba32>;
+
+struct FormatModes : staticmode::ModeSpace<PixelFormats> {};
+
+constexpr std::size_t channels_(decltype(gray8)) { return 1; }
+constexpr std::size_t channels_(decltype(rgb24)) { return 3; }
+constexpr std::size_t channels_(decltype(rgba32)) { return 4; }
+
+struct Image {
+    std::size_t formatKey;
+    std::size_t width;
+    std::vector<std::uint8_t> pixels;
+};
+
+struct ConvertKernel {
+    template<typename FromModes, typename ToModes>
+    static void apply(const Image& from, Image& to) {
+        using from_t = staticmode::get_mode_t<PixelFormat, FromModes, decltype(gray8)>;
+        using to_t = staticmode::get_mode_t<PixelFormat, ToModes, decltype(gray8)>;
+
+        const std::size_t fromChannels = channels_(from_t{});
+        const std::size_t toChannels = channels_(to_t{});
+
+        to.width = from.width;
+        to.pixels.assign(from.width * toChannels, 0xFF); // alpha defaults to opaque
+        for (std::size_t x = 0; x < from.width; ++x) {
+            for (std::size_t c = 0; c < toChannels && c < 3; ++c) {
+                // gray is replicated to each color channel
+                to.pixels[x * toChannels + c] = from.pixels[x * fromChannels + (fromChannels == 1 ? 0 : c)];
+            }
+        }
+        std::cout << "converted " << fromChannels << " channel(s) to " << toChannels << " channel(s)\n";
+    }
+};
+
+using ConvertDispatch = staticmode::multi_dispatch<ConvertKernel, FormatModes, FormatModes>;
+
+static void convertPixels(const Image& from, Image& to)
+{
+    ConvertDispatch::find(from.formatKey, to.formatKey)(from, to);
+}
+
+struct ChannelCountKernel {
+    template<typename A, typename B>
+    static bool apply() {
+        return channels_(staticmode::get_mode_t<PixelFormat, A, decltype(gray8)>{})
+            == channels_(staticmode::get_mode_t<PixelFormat, B, decltype(gray8)>{});
+    }
+};
+
+using ChannelCountDispatch = staticmode::symmetric_dispatch<ChannelCountKernel, FormatModes>;
+
+static bool sameChannelCount(const Image& a, const Image& b)
+{
+    return ChannelCountDispatch::find(a.formatKey, b.formatKey)();
+}
+
+int main()
+{
+    Image gray = { FormatModes::key(PixelFormat::gray8), 4, { 0, 85, 170, 255 } };
+    Image rgba = { FormatModes::key(PixelFormat::rgba32), 0, {} };
+    Image rgb = { FormatModes::key(PixelFormat::rgb24), 0, {} };
+
+    convertPixels(gray, rgba);
+    convertPixels(rgba, rgb);
+
+    std::cout << "rgb pixel 1: " << int(rgb.pixels[3]) << " " << int(rgb.pixels[4]) << " " << int(rgb.pixels[5]) << "\n";
+
+    std::cout << "ConvertDispatch instantiations: " << ConvertDispatch::size << "\n";
+    std::cout << "ChannelCountDispatch instantiations: " << ChannelCountDispatch::size << "\n";
+    std::cout << "same channel count (gray, rgb): " << sameChannelCount(gray, rgb) << "\n";
+    std::cout << "same channel count (rgb, rgb): " << sameChannelCount(rgb, rgb) << "\n";
+}
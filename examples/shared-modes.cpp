@@ -0,0 +1,167 @@
+//!clang++ -std=c++11 -O2 -Weverything -Wno-c++98-compat -Wno-unused-const-variable shared-modes.cpp -I../include -lrt -o shared-modes.out && ./shared-modes.out
+
+// This example is a multi-process test harness for `shared_mode_config`,
+// which publishes a packed mode key to several processes through POSIX
+// shared memory under a seqlock.
+//
+// The parent process creates the shared configuration and forks worker
+// processes. Each worker maps it by name, polls `version()` in its loop, and
+// rebinds a local `mode_function` only when the version changes. The parent
+// then flips modes at a fixed interval, publishing the time of each change
+// as the stamp. Each worker measures:
+//
+//   - the cost of a `load()` (while the writer is flipping modes)
+//   - the propagation latency: the time from a store to the first poll that
+//     observes it
+//
+// Usage: shared-modes [workers] [milliseconds]
+//
+// Propagation latency depends on the scheduler when there are fewer cores
+// than processes: a worker that isn't running can't observe the change.
+
+#include <chrono>
+#include <cstdint> // uint64_t
+#include <cstdlib> // atoi
+#include <iostream> // cout
+#include <string>
+
+#include <sys/mman.h> // mmap
+#include <sys/wait.h> // waitpid
+#include <unistd.h> // fork, getpid
+
+#include "StaticMode.h"
+#include "StaticModeDispatch.h"
+#include "StaticModeShared.h"
+
+enum class LineStyle { dotted, dashed, solid };
+enum class EndStyle { no_ends, arrows, circles };
+
+using LineStyles = staticmode::ModeCategory<LineStyle, LineStyle::solid, LineStyle::dotted, LineStyle::dashed>;
+using EndStyles = staticmode::ModeCategory<EndStyle, EndStyle::no_ends, EndStyle::arrows, EndStyle::circles>;
+
+struct PainterModes : staticmode::ModeSpace<LineStyles, EndStyles> {};
+
+// A stand-in for real work: returns a value that depends on the modes
+struct WorkKernel {
+    template<typename ModeExpr>
+    static std::size_t apply(std::size_t x) { return x * 3 + ModeExpr::key; }
+};
+
+using WorkFunction = staticmode::mode_function<std::size_t(std::size_t), LineStyles, EndStyles>;
+
+static std::uint64_t nowNs()
+{
+    // steady_clock is CLOCK_MONOTONIC on Linux, which is comparable across processes
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Per-worker results, in an anonymous shared mapping created before fork()
+struct WorkerResult {
+    std::uint64_t loads;
+    std::uint64_t loadNs;
+    std::uint64_t changesSeen;
+    std::uint64_t propagationNsTotal;
+    std::uint64_t propagationNsMax;
+    std::uint64_t checksum;
+};
+
+static int runWorker(const char *name, WorkerResult& result)
+{
+    staticmode::shared_mode_config<PainterModes> config;
+    if (!config.open(name))
+        return 1;
+
+    std::uint64_t cachedVersion = ~std::uint64_t(0);
+    WorkFunction work;
+    std::size_t checksum = 0;
+    std::uint64_t finalVersion = 0;
+
+    for (;;) {
+        // poll: one acquire load, no system call
+        std::uint64_t version = config.version();
+        if (version != cachedVersion) {
+            std::uint64_t seen = nowNs();
+            staticmode::shared_mode_config<PainterModes>::snapshot s = config.load();
+            if (s.stamp == 0) // the writer has finished
+                break;
+
+            if (cachedVersion != ~std::uint64_t(0)) {
+                std::uint64_t latency = (seen > s.stamp) ? seen - s.stamp : 0;
+                ++result.changesSeen;
+                result.propagationNsTotal += latency;
+                if (latency > result.propagationNsMax)
+                    result.propagationNsMax = latency;
+            }
+            cachedVersion = s.version;
+            work = WorkFunction::bind<WorkKernel>(s.key); // resolve to a local dispatch entry
+        }
+
+        checksum += work(checksum);
+
+        // measure load() cost in batches
+        const int batch = 256;
+        std::uint64_t start = nowNs();
+        for (int i = 0; i < batch; ++i)
+            finalVersion += config.load().version;
+        result.loadNs += nowNs() - start;
+        result.loads += batch;
+    }
+
+    result.checksum = checksum + finalVersion;
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const int workers = (argc > 1) ? std::atoi(argv[1]) : 2;
+    const int milliseconds = (argc > 2) ? std::atoi(argv[2]) : 200;
+    const std::string name = "/staticmode-example-" + std::to_string(static_cast<long>(::getpid()));
+
+    staticmode::shared_mode_config<PainterModes> config;
+    if (!config.create(name.c_str())) {
+        std::cout << "shm_open failed\n";
+        return 1;
+    }
+    config.store(PainterModes::key(LineStyle::solid, EndStyle::no_ends), nowNs());
+
+    void *mapping = ::mmap(nullptr, sizeof(WorkerResult) * static_cast<std::size_t>(workers),
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+        return 1;
+    WorkerResult *results = static_cast<WorkerResult*>(mapping); // zero-filled
+
+    for (int i = 0; i < workers; ++i) {
+        pid_t pid = ::fork();
+        if (pid == 0)
+            ::_exit(runWorker(name.c_str(), results[i]));
+    }
+
+    // the writer: flip modes every 1 ms
+    std::uint64_t end = nowNs() + static_cast<std::uint64_t>(milliseconds) * 1000000;
+    std::size_t key = 0;
+    std::uint64_t stores = 0;
+    while (nowNs() < end) {
+        ::usleep(1000);
+        key = (key + 1) % PainterModes::size;
+        config.store(key, nowNs());
+        ++stores;
+    }
+    config.store(0, 0); // stamp 0: stop
+
+    for (int i = 0; i < workers; ++i)
+        ::wait(nullptr);
+
+    std::cout << workers << " workers, " << stores << " mode changes in " << milliseconds << " ms\n";
+    for (int i = 0; i < workers; ++i) {
+        const WorkerResult& r = results[i];
+        std::cout << "worker " << i << ": "
+            << (r.loads ? static_cast<double>(r.loadNs) / static_cast<double>(r.loads) : 0.) << " ns/load, "
+            << r.changesSeen << " changes seen, propagation mean "
+            << (r.changesSeen ? static_cast<double>(r.propagationNsTotal) / static_cast<double>(r.changesSeen) / 1000. : 0.)
+            << " us, max " << static_cast<double>(r.propagationNsMax) / 1000. << " us\n";
+    }
+
+    ::munmap(mapping, sizeof(WorkerResult) * static_cast<std::size_t>(workers));
+    staticmode::shared_mode_config<PainterModes>::unlink(name.c_str());
+}
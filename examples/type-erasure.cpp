@@ -7,11 +7,43 @@
 // `AsciiPainterT` is a template that derives from `Painter` and implements
 // `drawLine`. `AsciiPainterT` implements a family of `drawLine` implementations.
 // The desired implementation is configured at compile time using Modes.
+//
+// `PainterHolder` (a `staticmode::mode_holder`) holds any `AsciiPainterT`
+// configuration in place, in a buffer sized for the largest `AsciiPainterT`
+// over all combinations in `PainterModes`. Unlike `std::unique_ptr<Painter>`
+// it has value semantics and does not allocate.
+//
+// `AsciiPainterT` has no per-object state, so `buildSharedAsciiPainter()`
+// returns a pointer to a single shared, constant-initialized instance per
+// mode combination (a flyweight) instead of allocating a new painter.
+//
+// `buildPainter()` builds a painter from runtime configuration values, and
+// rejects values that are not listed modes.
+// `PainterRegistry` (a `staticmode::mode_registry`) is a compile-time table
+// that maps each packed mode key to a factory function for the corresponding
+// `AsciiPainterT`, so no `if/else` ladder is needed.
+//
+// `PainterVariant` (a `staticmode::mode_variant`) is a closed-world
+// alternative to the `Painter` base class: it holds one `AsciiPainterT` inline
+// and `visit()` dispatches with a switch on a one-byte index, so calls can be
+// inlined.
+//
+// `PainterCollection` (a `staticmode::mode_collection`) stores painters in
+// one contiguous segment per `AsciiPainterT` type. `for_each()` visits them
+// segment by segment with statically resolved (devirtualized) calls.
+//
+// Run with `--benchmark` to compare the cost of calling `renderLine()`
+// through `std::unique_ptr<Painter>`, `PainterHolder`, `PainterVariant` and
+// `PainterCollection`.
 
+#include <chrono>
+#include <cstring> // strcmp
 #include <iostream> // cout
 #include <memory> // unique_ptr
+#include <vector>
 
 #include "StaticMode.h"
+#include "StaticModeErasure.h"
 
 enum class LineStyle { dotted, dashed, solid };
 
@@ -25,6 +57,11 @@ constexpr staticmode::Mode<EndStyle, EndStyle::no_ends> no_ends;
 constexpr staticmode::Mode<EndStyle, EndStyle::arrows> arrows;
 constexpr staticmode::Mode<EndStyle, EndStyle::circles> circles;
 
+using LineStyles = staticmode::ModeCategory<LineStyle, LineStyle::solid, LineStyle::dotted, LineStyle::dashed>;
+using EndStyles = staticmode::ModeCategory<EndStyle, EndStyle::no_ends, EndStyle::arrows, EndStyle::circles>;
+
+struct PainterModes : staticmode::ModeSpace<LineStyles, EndStyles> {};
+
 enum class Fruit { apple, orange, banana }; // not an accepted mode
 
 constexpr staticmode::Mode<Fruit, Fruit::apple> apple;
@@ -37,13 +74,17 @@ public:
     virtual ~Painter();
 
     virtual void drawLine() = 0;
+
+    // renders the line into /out/ (at least maxLineLength chars) and returns its length
+    static constexpr std::size_t maxLineLength = 12;
+    virtual std::size_t renderLine(char *out) = 0;
 };
 
 Painter::~Painter() {}
 
 
 template<typename ModeExpr=staticmode::ModeSet<> > // defaults to empty ModeSet
-class AsciiPainterT : public Painter {
+class AsciiPainterT final : public Painter {
     // Notice that we put type checks at the class-level here:
 
     static_assert(staticmode::is_mode_expr<ModeExpr>::value == true,
@@ -58,24 +99,33 @@ class AsciiPainterT : public Painter {
     using endStyle_t = staticmode::get_mode_t<EndStyle, ModeExpr, /*default:*/decltype(no_ends)>;
 
 private:
-    void drawLine_(decltype(dotted)) { std::cout << ".........."; }
-    void drawLine_(decltype(dashed)) { std::cout << "----------"; }
-    void drawLine_(decltype(solid)) { std::cout << "__________"; }
+    static const char *line_(decltype(dotted)) { return ".........."; }
+    static const char *line_(decltype(dashed)) { return "----------"; }
+    static const char *line_(decltype(solid)) { return "__________"; }
 
-    void drawLeftEnd_(decltype(no_ends)) { std::cout << " "; }
-    void drawLeftEnd_(decltype(arrows)) { std::cout << "<"; }
-    void drawLeftEnd_(decltype(circles)) { std::cout << "o"; }
+    static const char *leftEnd_(decltype(no_ends)) { return " "; }
+    static const char *leftEnd_(decltype(arrows)) { return "<"; }
+    static const char *leftEnd_(decltype(circles)) { return "o"; }
 
-    void drawRightEnd_(decltype(no_ends)) {}
-    void drawRightEnd_(decltype(arrows)) { std::cout << ">"; }
-    void drawRightEnd_(decltype(circles)) { std::cout << "o"; }
+    static const char *rightEnd_(decltype(no_ends)) { return ""; }
+    static const char *rightEnd_(decltype(arrows)) { return ">"; }
+    static const char *rightEnd_(decltype(circles)) { return "o"; }
+
+    static std::size_t append_(char *out, std::size_t n, const char *s) {
+        while (*s)
+            out[n++] = *s++;
+        return n;
+    }
 public:
 
     void drawLine() override {
-        drawLeftEnd_(endStyle_t{});
-        drawLine_(lineStyle_t{});
-        drawRightEnd_(endStyle_t{});
-        std::cout << "\n";
+        std::cout << leftEnd_(endStyle_t{}) << line_(lineStyle_t{}) << rightEnd_(endStyle_t{}) << "\n";
+    }
+
+    std::size_t renderLine(char *out) override {
+        std::size_t n = append_(out, 0, leftEnd_(endStyle_t{}));
+        n = append_(out, n, line_(lineStyle_t{}));
+        return append_(out, n, rightEnd_(endStyle_t{}));
     }
 };
 
@@ -85,8 +135,142 @@ std::unique_ptr<Painter> buildAsciiPainter(ModeExpr /*modes*/={})
     return std::unique_ptr<Painter>(new AsciiPainterT<ModeExpr>());
 }
 
-int main()
+template<typename ModeExpr=staticmode::ModeSet<> >
+staticmode::flyweight_ptr<Painter> buildSharedAsciiPainter(ModeExpr /*modes*/={})
+{
+    // AsciiPainterT is stateless, so this doesn't allocate
+    return staticmode::make_flyweight<Painter, AsciiPainterT<ModeExpr> >();
+}
+
+using PainterHolder = staticmode::mode_holder<Painter, AsciiPainterT, PainterModes>;
+
+struct PainterFactory {
+    template<typename ModeExpr>
+    static PainterHolder make() { return PainterHolder(ModeExpr{}); }
+};
+
+using PainterRegistry = staticmode::mode_registry<PainterModes, PainterFactory>;
+
+// Runtime configuration, e.g. loaded from a file
+struct PainterConfig {
+    LineStyle lineStyle;
+    EndStyle endStyle;
+};
+
+// Returns false if a configuration value is not a listed mode. The values
+// come from outside the program, so look the key up with find(): build()
+// requires a valid key.
+static bool buildPainter(const PainterConfig& config, PainterHolder& result)
+{
+    std::size_t key = PainterModes::key(config.lineStyle, config.endStyle);
+    PainterRegistry::factory_type make = PainterRegistry::find(key);
+    if (!make)
+        return false; // invalid configuration
+    result = make();
+    return true;
+}
+
+using PainterVariant = staticmode::space_variant_t<AsciiPainterT, PainterModes>;
+
+struct RenderLine {
+    char *out;
+
+    template<typename T>
+    std::size_t operator()(T& painter) const { return painter.renderLine(out); }
+};
+
+using PainterCollection = staticmode::mode_collection<AsciiPainterT, PainterModes>;
+
+// Benchmark: render lines with painters of randomly chosen modes
+
+struct UniquePainterFactory {
+    template<typename ModeExpr>
+    static std::unique_ptr<Painter> make() { return buildAsciiPainter(ModeExpr{}); }
+};
+
+template<typename Painters, typename RenderFn>
+static void benchmark(const char *name, Painters& painters, RenderFn render)
+{
+    const int iterations = 2000;
+    char line[Painter::maxLineLength];
+    std::size_t checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        for (auto& p : painters)
+            checksum += render(p, line) + static_cast<unsigned char>(line[0]);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << "  " << name << ": " << ns / (static_cast<double>(iterations) * static_cast<double>(painters.size()))
+        << " ns/call (checksum " << checksum << ")\n";
+}
+
+struct RenderLineChecksum {
+    char *out;
+    std::size_t& checksum;
+
+    template<typename T>
+    void operator()(T& painter) const { checksum += painter.renderLine(out) + static_cast<unsigned char>(out[0]); }
+};
+
+static void benchmarkCollection(const char *name, PainterCollection& painters)
+{
+    const int iterations = 2000;
+    char line[Painter::maxLineLength];
+    std::size_t checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        painters.for_each(RenderLineChecksum{ line, checksum });
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << "  " << name << ": " << ns / (static_cast<double>(iterations) * static_cast<double>(painters.size()))
+        << " ns/call (checksum " << checksum << ")\n";
+}
+
+// /mixed/: each painter has randomly chosen modes, otherwise all painters have the same modes
+static void runBenchmarks(bool mixed)
 {
+    const std::size_t count = 4096;
+
+    std::cout << (mixed ? "mixed modes:\n" : "same modes:\n");
+
+    std::vector<std::unique_ptr<Painter> > uniquePainters;
+    std::vector<PainterHolder> heldPainters;
+    std::vector<PainterVariant> variantPainters;
+    PainterCollection collectedPainters;
+
+    unsigned seed = 1;
+    for (std::size_t i = 0; i < count; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        std::size_t key = mixed ? (seed >> 16) % PainterModes::size : 5;
+
+        uniquePainters.push_back(staticmode::mode_registry<PainterModes, UniquePainterFactory>::build(key));
+        heldPainters.push_back(PainterRegistry::build(key));
+        variantPainters.push_back(PainterVariant::from_index(key));
+        collectedPainters.emplace_key(key);
+    }
+
+    benchmark("std::unique_ptr<Painter>", uniquePainters,
+        [](std::unique_ptr<Painter>& p, char *out) { return p->renderLine(out); });
+    benchmark("PainterHolder", heldPainters,
+        [](PainterHolder& p, char *out) { return p->renderLine(out); });
+    benchmark("PainterVariant", variantPainters,
+        [](PainterVariant& p, char *out) { return p.visit(RenderLine{ out }); });
+    benchmarkCollection("PainterCollection", collectedPainters);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && std::strcmp(argv[1], "--benchmark") == 0) {
+        runBenchmarks(true);
+        runBenchmarks(false);
+        return 0;
+    }
+
     // Example 1: direct instantiation of an AsciiPainterT
     Painter *p1 = new AsciiPainterT<decltype(dashed|arrows)>();
     p1->drawLine();
@@ -102,6 +286,43 @@ int main()
     std::unique_ptr<Painter> p4(buildAsciiPainter());
     p4->drawLine();
 
+    // Example 3: holding painters by value, without heap allocation
+    PainterHolder p5(dashed|circles);
+    p5->drawLine();
+
+    std::vector<PainterHolder> painters(2); // default modes: solid, no_ends
+    painters.push_back(p5);
+    painters[0].emplace(dotted|arrows);
+    for (PainterHolder& p : painters)
+        p->drawLine();
+
+    // Example 4: sharing one instance of each stateless painter
+    staticmode::flyweight_ptr<Painter> p6(buildSharedAsciiPainter(solid|arrows));
+    staticmode::flyweight_ptr<Painter> p7(buildSharedAsciiPainter(solid|arrows)); // same object as p6
+    p6->drawLine();
+    std::cout << "shared: " << (p6.get() == p7.get()) << "\n";
+
+    // Example 5: building a painter from runtime configuration
+    PainterConfig config = { LineStyle::dotted, EndStyle::circles };
+    PainterHolder p8;
+    if (buildPainter(config, p8))
+        p8->drawLine();
+
+    PainterConfig badConfig = { static_cast<LineStyle>(42), EndStyle::no_ends };
+    std::cout << "bad config accepted: " << buildPainter(badConfig, p8) << "\n";
+
+    // Example 6: a closed set of painters without virtual dispatch
+    PainterVariant v1(arrows|dashed);
+    char line[Painter::maxLineLength];
+    std::cout.write(line, static_cast<std::streamsize>(v1.visit(RenderLine{ line }))) << "\n";
+
+    // Example 7: painters stored by type, iterated without virtual calls
+    PainterCollection collection;
+    collection.emplace(dotted|arrows);
+    collection.emplace(solid);
+    collection.emplace_key(PainterModes::key(config.lineStyle, config.endStyle));
+    collection.for_each([](Painter& p) { p.drawLine(); });
+
     // The following are correctly caught as compile errors.
     // Uncomment any of the lines below and you'll get an informative
     // static_assert-based compiler error.
@@ -0,0 +1,146 @@
+//!clang++ -std=c++17 -O2 -Weverything -Wno-c++98-compat -Wno-unused-const-variable variant-dispatch.cpp -I../include -o variant-dispatch.out && ./variant-dispatch.out
+
+// This example demonstrates converting runtime mode values to a `std::variant`
+// of mode types with `to_variant` (C++17), so that mode-specialized code can
+// be selected with `std::visit` and a generic lambda.
+//
+//   - `to_variant<LineStyles>(lineStyle)` returns a
+//     `std::variant<Mode<LineStyle, ...>...>` with one alternative per mode.
+//   - `to_variant<PainterModes>(key)` returns a `std::variant` of the
+//     normalized `ModeSet`s of the space, one alternative per packed key.
+//
+// Run with `--benchmark` to compare the cost of selecting `renderLine()`
+// with `std::visit` against StaticMode's own dispatchers: `dispatch` (a
+// switch on the packed key) and `multi_dispatch` (a table of function
+// pointers).
+
+#include <chrono>
+#include <cstring> // strcmp
+#include <iostream> // cout
+#include <variant>
+#include <vector>
+
+#include "StaticMode.h"
+#include "StaticModeDispatch.h"
+
+enum class LineStyle { dotted, dashed, solid };
+
+constexpr staticmode::Mode<LineStyle, LineStyle::dotted> dotted;
+constexpr staticmode::Mode<LineStyle, LineStyle::dashed> dashed;
+constexpr staticmode::Mode<LineStyle, LineStyle::solid> solid;
+
+enum class EndStyle { no_ends, arrows, circles };
+
+constexpr staticmode::Mode<EndStyle, EndStyle::no_ends> no_ends;
+constexpr staticmode::Mode<EndStyle, EndStyle::arrows> arrows;
+constexpr staticmode::Mode<EndStyle, EndStyle::circles> circles;
+
+using LineStyles = staticmode::ModeCategory<LineStyle, LineStyle::solid, LineStyle::dotted, LineStyle::dashed>;
+using EndStyles = staticmode::ModeCategory<EndStyle, EndStyle::no_ends, EndStyle::arrows, EndStyle::circles>;
+
+struct PainterModes : staticmode::ModeSpace<LineStyles, EndStyles> {};
+
+
+inline char lineChar_(decltype(dotted)) { return '.'; }
+inline char lineChar_(decltype(dashed)) { return '-'; }
+inline char lineChar_(decltype(solid)) { return '_'; }
+
+inline char leftEnd_(decltype(no_ends)) { return ' '; }
+inline char leftEnd_(decltype(arrows)) { return '<'; }
+inline char leftEnd_(decltype(circles)) { return 'o'; }
+
+inline char rightEnd_(decltype(no_ends)) { return ' '; }
+inline char rightEnd_(decltype(arrows)) { return '>'; }
+inline char rightEnd_(decltype(circles)) { return 'o'; }
+
+constexpr std::size_t lineLength = 12;
+
+// Render a line into /out/ (lineLength chars), return the number of non-blank chars
+template<typename ModeExpr>
+std::size_t renderLine(ModeExpr, char *out) {
+    using lineStyle_t = staticmode::get_mode_t<LineStyle, ModeExpr, /*default:*/decltype(solid)>;
+    using endStyle_t = staticmode::get_mode_t<EndStyle, ModeExpr, /*default:*/decltype(no_ends)>;
+
+    out[0] = leftEnd_(endStyle_t{});
+    for (std::size_t i = 1; i < lineLength - 1; ++i)
+        out[i] = lineChar_(lineStyle_t{});
+    out[lineLength - 1] = rightEnd_(endStyle_t{});
+
+    return lineLength - 2 + (out[0] != ' ') + (out[lineLength - 1] != ' ');
+}
+
+// The same, as a kernel for multi_dispatch
+struct RenderLineKernel {
+    template<typename ModeExpr>
+    static std::size_t apply(char *out) { return renderLine(ModeExpr{}, out); }
+};
+
+static void printLine(const char *line) {
+    std::cout.write(line, lineLength);
+    std::cout << "\n";
+}
+
+template<typename Dispatch>
+static void benchmark(const char *name, const std::vector<std::size_t>& keys, Dispatch dispatch)
+{
+    const int iterations = 2000;
+    char line[lineLength];
+    std::size_t checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        for (std::size_t key : keys)
+            checksum += dispatch(key, line) + static_cast<unsigned char>(line[0]);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << "  " << name << ": " << ns / (static_cast<double>(iterations) * static_cast<double>(keys.size()))
+        << " ns/call (checksum " << checksum << ")\n";
+}
+
+// /mixed/: random keys, otherwise all keys are the same
+static void runBenchmarks(bool mixed)
+{
+    const std::size_t count = 4096;
+
+    std::cout << (mixed ? "mixed modes:\n" : "same modes:\n");
+
+    std::vector<std::size_t> keys;
+    unsigned seed = 1;
+    for (std::size_t i = 0; i < count; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        keys.push_back(mixed ? (seed >> 16) % PainterModes::size : 5);
+    }
+
+    benchmark("std::visit(to_variant)", keys, [](std::size_t key, char *out) {
+        return std::visit([out](auto modes) { return renderLine(modes, out); },
+            staticmode::to_variant<PainterModes>(key));
+    });
+    benchmark("dispatch (switch)", keys, [](std::size_t key, char *out) {
+        return staticmode::dispatch<PainterModes>(key, [out](auto modes) { return renderLine(modes, out); });
+    });
+    benchmark("multi_dispatch (table)", keys, [](std::size_t key, char *out) {
+        return staticmode::multi_dispatch<RenderLineKernel, PainterModes>::find(key)(out);
+    });
+}
+
+int main(int argc, char *argv[])
+{
+    char line[lineLength];
+
+    // a single category
+    auto lineStyle = staticmode::to_variant<LineStyles>(LineStyle::dashed);
+    std::visit([&line](auto mode) { renderLine(mode | arrows, line); }, lineStyle);
+    printLine(line);
+
+    // a whole mode space, from runtime values (e.g. from a config file)
+    auto modes = staticmode::to_variant<PainterModes>(PainterModes::key(LineStyle::dotted, EndStyle::circles));
+    std::visit([&line](auto m) { renderLine(m, line); }, modes);
+    printLine(line);
+
+    if (argc > 1 && std::strcmp(argv[1], "--benchmark") == 0) {
+        runBenchmarks(true);
+        runBenchmarks(false);
+    }
+}
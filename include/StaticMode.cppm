@@ -0,0 +1,47 @@
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// C++20 named module interface for StaticMode:
+//
+//   import staticmode;
+//
+// The module is a thin wrapper around StaticMode.h: the standard library
+// headers are included in the global module fragment, and StaticMode.h is
+// included in the module purview inside an export block, so every name it
+// declares is exported. StaticMode.h remains the primary interface, and is all
+// you need with pre-C++20 toolchains.
+//
+// Importing the module saves re-parsing StaticMode.h and <type_traits> in
+// every translation unit. Templates are still instantiated per translation
+// unit for the mode types that each one uses.
+
+module;
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+export module staticmode;
+
+export {
+#include "StaticMode.h"
+}
@@ -22,7 +22,12 @@
 #ifndef INCLUDED_STATICMODE_H
 #define INCLUDED_STATICMODE_H
 
+// NB: StaticMode.cppm includes the same standard headers in its global module
+// fragment. Keep the two lists in sync.
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
 #include <type_traits>
+#include <utility> // declval
 
 namespace staticmode {
 
@@ -83,6 +88,38 @@ struct or_<Cond, Conds...> : std::conditional<Cond::value, std::true_type, or_<C
 
 #endif
 
+// ----------------------------------------------------------------------------
+// index_sequence_<Is...>, make_index_sequence_<N>::type
+// Equivalent to C++14 std::index_sequence and std::make_index_sequence.
+// make_index_sequence_ recurses by halving, so that large N don't exceed
+// the compiler's template instantiation depth.
+
+template<std::size_t... Is>
+struct index_sequence_ {};
+
+template<typename A, typename B>
+struct concat_index_sequence_;
+
+template<std::size_t... As, std::size_t... Bs>
+struct concat_index_sequence_<index_sequence_<As...>, index_sequence_<Bs...> > {
+    using type = index_sequence_<As..., (sizeof...(As) + Bs)...>;
+};
+
+template<std::size_t N>
+struct make_index_sequence_
+    : concat_index_sequence_<typename make_index_sequence_<N / 2>::type,
+        typename make_index_sequence_<N - N / 2>::type> {};
+
+template<>
+struct make_index_sequence_<0> {
+    using type = index_sequence_<>;
+};
+
+template<>
+struct make_index_sequence_<1> {
+    using type = index_sequence_<0>;
+};
+
 // ----------------------------------------------------------------------------
 
 } // end namespace detail
@@ -258,8 +295,26 @@ struct is_mode_set_<ModeSet<Ts...> > : std::true_type {};
 template<typename T>
 using is_mode_set = detail::is_mode_set_<detail::remove_cv_t_<T> >;
 
+// PackedModes<Space, Key> is a compact mode expression (see below)
+
+template<typename Space, std::size_t Key>
+struct PackedModes;
+
+namespace detail {
+
+template<typename T>
+struct is_packed_modes_ : std::false_type {};
+
+template<typename Space, std::size_t Key>
+struct is_packed_modes_<PackedModes<Space, Key> > : std::true_type {};
+
+} // end namespace detail
+
+template<typename T>
+using is_packed_modes = detail::is_packed_modes_<detail::remove_cv_t_<T> >;
+
 template<typename T>
-struct is_mode_expr : detail::or_<is_mode<T>, is_mode_set<T> > {};
+struct is_mode_expr : detail::or_<is_mode<T>, is_mode_set<T>, is_packed_modes<T> > {};
 
 // ModeSets can be constructed by combining Mode values using operator|:
 
@@ -297,6 +352,100 @@ using has_mode = detail::has_type_no_cv<ModeEnumClass, typename ModeExpr::value_
 
 // ............................................................................
 
+// SFINAE-friendly checks
+//
+// is_mode_expr, has_no_other_modes and has_mode are intended for static_assert,
+// and has_no_other_modes and has_mode fail to compile if /ModeExpr/ is not a mode
+// expression. The predicates below are false (rather than ill-formed) for
+// any type, so they can be used to remove overloads from overload resolution.
+
+// accepts_modes<ModeExpr, EnumClasses...>
+// true if /ModeExpr/ is a mode expression that only contains modes from categories /EnumClasses/
+
+namespace detail {
+
+template<bool IsModeExpr, typename ModeExpr, typename... EnumClasses>
+struct accepts_modes_ : std::false_type {};
+
+template<typename ModeExpr, typename... EnumClasses>
+struct accepts_modes_<true, ModeExpr, EnumClasses...>
+    : has_no_other_modes<type_pack<EnumClasses...>, ModeExpr> {};
+
+template<bool IsModeExpr, typename ModeExpr, typename EnumClass>
+struct requires_mode_ : std::false_type {};
+
+template<typename ModeExpr, typename EnumClass>
+struct requires_mode_<true, ModeExpr, EnumClass>
+    : has_mode<EnumClass, ModeExpr> {};
+
+} // end namespace detail
+
+template<typename ModeExpr, typename... EnumClasses>
+struct accepts_modes
+    : detail::accepts_modes_<is_mode_expr<ModeExpr>::value, ModeExpr, EnumClasses...> {};
+
+// requires_mode<ModeExpr, EnumClass>
+// true if /ModeExpr/ is a mode expression that contains a mode from category /EnumClass/
+
+template<typename ModeExpr, typename EnumClass>
+struct requires_mode
+    : detail::requires_mode_<is_mode_expr<ModeExpr>::value, ModeExpr, EnumClass> {};
+
+// enable_if_accepts_modes_t<ModeExpr, EnumClasses...>
+// enable_if_requires_mode_t<ModeExpr, EnumClass>
+//
+// example usage (C++11):
+// template<typename ModeExpr=ModeSet<>, enable_if_accepts_modes_t<ModeExpr, LineStyle, EndStyle> = 0>
+// void drawLine(ModeExpr modes={});
+
+template<typename ModeExpr, typename... EnumClasses>
+using enable_if_accepts_modes_t = typename std::enable_if<accepts_modes<ModeExpr, EnumClasses...>::value, int>::type;
+
+template<typename ModeExpr, typename EnumClass>
+using enable_if_requires_mode_t = typename std::enable_if<requires_mode<ModeExpr, EnumClass>::value, int>::type;
+
+// is_callable_with_modes<F, ModeExpr>
+// true if a function object of type /F/ can be called with a /ModeExpr/ argument.
+// Only the callable's declaration is checked, so if /F/'s call operator
+// is constrained (as above) this can be used to probe whether /F/ accepts /ModeExpr/
+// without instantiating its body (provided its return type is not deduced).
+
+namespace detail {
+
+template<typename F, typename ModeExpr, typename = void>
+struct is_callable_with_modes_ : std::false_type {};
+
+template<typename F, typename ModeExpr>
+struct is_callable_with_modes_<F, ModeExpr,
+        decltype(static_cast<void>(std::declval<F&>()(std::declval<ModeExpr>())))>
+    : std::true_type {};
+
+} // end namespace detail
+
+template<typename F, typename ModeExpr>
+using is_callable_with_modes = detail::is_callable_with_modes_<F, ModeExpr>;
+
+#if defined(__cpp_concepts) && __cpp_concepts >= 201907L
+
+// C++20 concepts equivalent to the above
+//
+// example usage:
+// template<AcceptsModes<LineStyle, EndStyle> M = ModeSet<> >
+// void drawLine(M modes={});
+
+template<typename T>
+concept ModeExpr = is_mode_expr<T>::value;
+
+template<typename T, typename... EnumClasses>
+concept AcceptsModes = accepts_modes<T, EnumClasses...>::value;
+
+template<typename T, typename EnumClass>
+concept RequiresMode = requires_mode<T, EnumClass>::value;
+
+#endif
+
+// ............................................................................
+
 // get_mode<KeyEnumClass, ModeExpr, Default>
 //
 // type parameters:
@@ -371,6 +520,422 @@ using get_mode_t = typename get_mode<KeyEnumClass, detail::remove_cv_t_<ModeExpr
       cv-ness of /Default/ or the contents of the mode set.
 */
 
+///////////////////////////////////////////////////////////////////////////////
+// Mode categories, mode spaces and packed mode keys
+//
+// The templates above never need to know which modes exist in a category.
+// The templates below do: they give every normalized combination of modes
+// a small integer "packed key", so that mode expressions can be mapped to a
+// short canonical type, and so that runtime values can be mapped back
+// to static modes.
+
+// ModeCategory<T, Xs...> lists all of the modes in category /T/ (an enum class).
+// The first listed mode is the category's default mode. A mode's index is its
+// position in the list, not its underlying enum value.
+//
+// example:
+// using LineStyles = ModeCategory<LineStyle, LineStyle::solid, LineStyle::dotted, LineStyle::dashed>;
+
+template<typename T, T... Xs>
+struct ModeCategory {
+    using type = ModeCategory;
+    using value_type = T;
+
+    using modes = type_pack<Mode<T, Xs>...>;
+
+    static constexpr std::size_t size = sizeof...(Xs);
+    static_assert(sizeof...(Xs) > 0, "A ModeCategory must list at least one mode.");
+
+    static constexpr value_type values[sizeof...(Xs)] = { Xs... };
+
+    using default_mode = Mode<T, values[0]>;
+
+    // index_of(x) returns /size/ if /x/ is not listed in the category
+    static constexpr std::size_t index_of(value_type x, std::size_t i = 0) noexcept {
+        return (i == size) ? size : ((values[i] == x) ? i : index_of(x, i + 1));
+    }
+
+    static constexpr value_type value_at(std::size_t i) noexcept { return values[i]; }
+};
+
+template<typename T, T... Xs> constexpr std::size_t ModeCategory<T, Xs...>::size;
+template<typename T, T... Xs> constexpr T ModeCategory<T, Xs...>::values[sizeof...(Xs)];
+
+namespace detail {
+
+// prepend_mode_<M, ModeSet<Ts...> >::type is ModeSet<M, Ts...>
+
+template<typename M, typename ModeSet_>
+struct prepend_mode_;
+
+template<typename M, typename... Ts>
+struct prepend_mode_<M, ModeSet<Ts...> > {
+    using type = ModeSet<M, Ts...>;
+};
+
+// unpack_<Key, Cats...>::type is the normalized ModeSet with packed key /Key/.
+// The first category is the least significant digit of the key.
+
+template<std::size_t Key, typename... Cats>
+struct unpack_ {
+    using type = ModeSet<>;
+};
+
+template<std::size_t Key, typename Cat, typename... Cats>
+struct unpack_<Key, Cat, Cats...> {
+    using type = typename prepend_mode_<
+            Mode<typename Cat::value_type, Cat::value_at(Key % Cat::size)>,
+            typename unpack_<Key / Cat::size, Cats...>::type>::type;
+};
+
+// pack_<Cats...>::key(xs...) packs runtime values into a key.
+// Returns pack_<Cats...>::size if any value is not listed in its category.
+
+template<typename... Cats>
+struct pack_ {
+    static constexpr std::size_t size = 1;
+
+    static constexpr std::size_t key() noexcept { return 0; }
+
+    template<typename T>
+    static constexpr std::size_t index(std::size_t) noexcept { return 0; }
+};
+
+template<typename Cat, typename... Cats>
+struct pack_<Cat, Cats...> {
+    using rest_ = pack_<Cats...>;
+
+    static constexpr std::size_t size = Cat::size * rest_::size;
+
+    static constexpr std::size_t key(typename Cat::value_type x, typename Cats::value_type... xs) noexcept {
+        return key_(Cat::index_of(x), rest_::key(xs...));
+    }
+
+    static constexpr std::size_t key_(std::size_t i, std::size_t restKey) noexcept {
+        return (i == Cat::size || restKey == rest_::size) ? size : i + Cat::size * restKey;
+    }
+
+    // index<T>(key) is the index of the mode of category /T/ in /key/
+    template<typename T>
+    static constexpr std::size_t index(std::size_t key) noexcept {
+        return std::is_same<T, typename Cat::value_type>::value
+            ? key % Cat::size : rest_::template index<T>(key / Cat::size);
+    }
+};
+
+// category_of_<T, Cats...>::type is the ModeCategory in /Cats/ with value_type /T/
+
+template<typename T, typename... Cats>
+struct category_of_ {
+    static_assert(sizeof(T) == 0, "Mode category /T/ (an enum class) is not in this ModeSpace.");
+};
+
+template<typename T, typename Cat, typename... Cats>
+struct category_of_<T, Cat, Cats...>
+    : std::conditional<std::is_same<T, typename Cat::value_type>::value,
+        Cat, category_of_<T, Cats...> >::type {};
+
+} // end namespace detail
+
+// ModeSpace<Cats...> is an ordered list of ModeCategory types. Within a mode
+// space every mode expression is /normalized/ by filling in the default mode
+// of each missing category and ordering modes by category. Each normalized
+// ModeSet has a packed key in [0, size).
+//
+// To keep symbol names short, derive a named struct from ModeSpace, e.g.:
+// struct PainterModes : ModeSpace<LineStyles, EndStyles> {};
+
+template<typename... Cats>
+struct ModeSpace {
+    using categories = type_pack<Cats...>;
+
+    // value_types is the list of enum class types in this mode space
+    using value_types = type_pack<typename Cats::value_type...>;
+
+    static_assert(detail::contains_duplicate_no_cv<value_types>::value == false,
+        "Duplicate mode category detected. A ModeSpace may list each mode category (enum class) at most once.");
+
+    // number of normalized mode sets, also the invalid key value
+    static constexpr std::size_t size = detail::pack_<Cats...>::size;
+
+    // key(xs...) returns the packed key of runtime values /xs/ (one per category,
+    // in category order), or /size/ if any value is not listed in its category.
+    static constexpr std::size_t key(typename Cats::value_type... xs) noexcept {
+        return detail::pack_<Cats...>::key(xs...);
+    }
+
+    // index<T>(key) is the index of the mode of category /T/ in /key/
+    template<typename T>
+    static constexpr std::size_t index(std::size_t key) noexcept {
+        return detail::pack_<Cats...>::template index<typename detail::category_of_<T, Cats...>::value_type>(key);
+    }
+
+    // value<T>(key) is the value of the mode of category /T/ in /key/
+    template<typename T>
+    static constexpr T value(std::size_t key) noexcept {
+        return detail::category_of_<T, Cats...>::value_at(index<T>(key));
+    }
+
+    // key_of<ModeExpr>::value is the packed key of /ModeExpr/
+    template<typename ModeExpr>
+    struct key_of : std::integral_constant<std::size_t,
+            detail::pack_<Cats...>::key(get_mode_t<typename Cats::value_type, ModeExpr, typename Cats::default_mode>::value...)> {
+
+        static_assert(detail::is_subset_no_cv<typename ModeExpr::value_types, value_types>::value,
+            "/ModeExpr/ contains a mode from a category (enum class) that is not in this ModeSpace.");
+
+        static_assert(key_of::value < size, "/ModeExpr/ selects a mode that is not listed in its ModeCategory.");
+    };
+
+    // mode_set_t<Key> is the normalized ModeSet with packed key /Key/
+    template<std::size_t Key>
+    using mode_set_t = typename detail::unpack_<Key, Cats...>::type;
+};
+
+template<typename... Cats> constexpr std::size_t ModeSpace<Cats...>::size;
+
+// PackedModes<Space, Key> is a compact mode expression: it is equivalent to
+// the normalized ModeSet with key /Key/ in /Space/, but its type name
+// (and hence the mangled name of anything templated on it) stays short
+// however many categories the space has.
+
+template<typename Space, std::size_t Key>
+struct PackedModes {
+    using type = PackedModes;
+
+    using space_type = Space;
+
+    static constexpr std::size_t key = Key;
+    static_assert(Key < Space::size, "/Key/ is out of range for /Space/.");
+
+    using mode_set = typename Space::template mode_set_t<Key>;
+
+    // type checking support (see ModeSet::value_types)
+    using value_types = typename mode_set::value_types;
+};
+
+template<typename Space, std::size_t Key> constexpr std::size_t PackedModes<Space, Key>::key;
+
+/// get_mode specialization when ModeExpr is a PackedModes
+
+template <typename KeyEnumClass, typename Space, std::size_t Key, typename Default>
+struct get_mode<KeyEnumClass, PackedModes<Space, Key>, Default>
+    : get_mode<KeyEnumClass, typename PackedModes<Space, Key>::mode_set, Default> {};
+
+// packed_key<Space, ModeExpr>::value is the packed key of /ModeExpr/ in /Space/
+
+template<typename Space, typename ModeExpr>
+using packed_key = typename Space::template key_of<detail::remove_cv_t_<ModeExpr> >;
+
+// normalize_t<Space, ModeExpr> is the normalized ModeSet equivalent to /ModeExpr/
+
+template<typename Space, typename ModeExpr>
+using normalize_t = typename Space::template mode_set_t<packed_key<Space, ModeExpr>::value>;
+
+// compact_t<Space, ModeExpr> is the PackedModes equivalent to /ModeExpr/.
+// All mode expressions that normalize to the same ModeSet have the same compact_t.
+
+template<typename Space, typename ModeExpr>
+using compact_t = PackedModes<Space, packed_key<Space, ModeExpr>::value>;
+
+// compact<Space>(modes) is the value-level version of compact_t
+//
+// example usage:
+// template<typename ModeExpr> void drawLine(ModeExpr modes) { drawLine_(compact<PainterModes>(modes)); }
+
+template<typename Space, typename ModeExpr>
+constexpr compact_t<Space, ModeExpr> compact(ModeExpr) { return {}; }
+
+#if __cplusplus >= 201703L
+// ModeOf<X> is shorthand for Mode<decltype(X), X> using a C++17 auto template parameter.
+// It is an alias, so ModeOf<LineStyle::dashed> and Mode<LineStyle, LineStyle::dashed> are the same type.
+template<auto X>
+using ModeOf = Mode<decltype(X), X>;
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Mode combination rules
+//
+// Rules restrict which normalized mode sets of a ModeSpace are valid.
+// Rules are evaluated on normalized mode sets, so a default mode counts as
+// being present. Given:
+//
+// using PainterRules = ModeRules<PainterModes,
+//     Requires<decltype(circles), decltype(solid)>,   // circles requires solid
+//     Excludes<decltype(dotted), decltype(arrows)> >; // dotted excludes arrows
+//
+// - is_allowed<PainterRules, ModeExpr>::value can be used with static_assert
+//   to reject invalid mode expressions at compile time, and
+// - PainterRules::test(key) validates a runtime packed key with a single bit test.
+
+// Requires<ModeA, ModeB>: if /ModeA/ is present, /ModeB/ must be present
+
+template<typename ModeA, typename ModeB>
+struct Requires {
+    template<typename Space>
+    static constexpr bool allows(std::size_t key) noexcept {
+        return Space::template value<typename ModeA::value_type>(key) != ModeA::value
+            || Space::template value<typename ModeB::value_type>(key) == ModeB::value;
+    }
+};
+
+// Excludes<ModeA, ModeB>: /ModeA/ and /ModeB/ may not both be present
+
+template<typename ModeA, typename ModeB>
+struct Excludes {
+    template<typename Space>
+    static constexpr bool allows(std::size_t key) noexcept {
+        return Space::template value<typename ModeA::value_type>(key) != ModeA::value
+            || Space::template value<typename ModeB::value_type>(key) != ModeB::value;
+    }
+};
+
+namespace detail {
+
+constexpr bool all_() noexcept { return true; }
+
+template<typename... Bs>
+constexpr bool all_(bool b, Bs... bs) noexcept { return b && all_(bs...); }
+
+// key_bitmap_<Pred, Size, index_sequence_<Ws...> > holds one bit per key in
+// [0, /Size/), set if Pred::allows(key). Ws... are the word indices.
+
+template<typename Pred, std::size_t Size, typename WordIndices>
+struct key_bitmap_;
+
+template<typename Pred, std::size_t Size, std::size_t... Ws>
+struct key_bitmap_<Pred, Size, index_sequence_<Ws...> > {
+    using word_type = std::uint64_t;
+    static constexpr std::size_t word_bits = 64;
+
+    static constexpr word_type bit_(std::size_t key, std::size_t bit) noexcept {
+        return (key < Size && Pred::allows(key)) ? (word_type(1) << bit) : word_type(0);
+    }
+
+    static constexpr word_type word_(std::size_t w, std::size_t bit = 0) noexcept {
+        return (bit == word_bits) ? word_type(0) : (bit_(w * word_bits + bit, bit) | word_(w, bit + 1));
+    }
+
+    static constexpr word_type words[sizeof...(Ws)] = { word_(Ws)... };
+
+    static bool test(std::size_t key) noexcept {
+        return key < Size && ((words[key / word_bits] >> (key % word_bits)) & 1u) != 0;
+    }
+};
+
+template<typename Pred, std::size_t Size, std::size_t... Ws>
+constexpr std::uint64_t key_bitmap_<Pred, Size, index_sequence_<Ws...> >::words[sizeof...(Ws)];
+
+} // end namespace detail
+
+// ModeRules<Space, Rules...> combines /Rules/ over the normalized mode sets of /Space/
+
+template<typename Space, typename... Rules>
+struct ModeRules {
+    using space_type = Space;
+
+    static constexpr std::size_t size = Space::size;
+
+    // allows(key) evaluates the rules. It is constexpr, but not intended
+    // to be used at runtime (use test() instead).
+    static constexpr bool allows(std::size_t key) noexcept {
+        return key < Space::size && detail::all_(Rules::template allows<Space>(key)...);
+    }
+
+    using bitmap = detail::key_bitmap_<ModeRules, Space::size,
+        typename detail::make_index_sequence_<(Space::size + 63) / 64>::type>;
+
+    // test(key) is true if /key/ is an allowed packed key. Costs one bit test.
+    static bool test(std::size_t key) noexcept { return bitmap::test(key); }
+};
+
+template<typename Space, typename... Rules> constexpr std::size_t ModeRules<Space, Rules...>::size;
+
+// is_allowed<ModeRules, ModeExpr>::value is true if /ModeExpr/ satisfies /ModeRules/
+//
+// example usage:
+// static_assert(is_allowed<PainterRules, ModeExpr>::value, "/modes/ is not an allowed combination.");
+
+template<typename ModeRules_, typename ModeExpr>
+using is_allowed = std::integral_constant<bool,
+    ModeRules_::allows(packed_key<typename ModeRules_::space_type, ModeExpr>::value)>;
+
+///////////////////////////////////////////////////////////////////////////////
+// Runtime dispatch support
+
+namespace detail {
+
+// dense_switch_<R, N>::call(i, g) calls g(std::integral_constant<std::size_t, i>{})
+// for runtime index /i/ in [0, N), using a switch statement with 16 cases per
+// level, so that the compiler can generate a jump table and inline the call
+// to /g/. /g/ is a function object with an operator() template taking an
+// integral_constant. Calling with i >= N is undefined.
+
+template<typename R, std::size_t N, std::size_t Base = 0>
+struct dense_switch_ {
+    template<std::size_t I, typename G>
+    static R case_(G& g, std::true_type /*I < N*/) { return g(std::integral_constant<std::size_t, I>{}); }
+
+    // unreachable, but must be well-formed
+    template<std::size_t I, typename G>
+    static R case_(G& g, std::false_type /*I < N*/) { return g(std::integral_constant<std::size_t, 0>{}); }
+
+    template<typename G>
+    static R next_(std::size_t i, G& g, std::true_type) { return dense_switch_<R, N, Base + 16>::call(i, g); }
+
+    template<typename G>
+    static R next_(std::size_t, G& g, std::false_type) { return g(std::integral_constant<std::size_t, 0>{}); }
+
+    template<typename G>
+    static R call(std::size_t i, G& g) {
+        switch (i - Base) {
+        case 0: return case_<Base + 0>(g, std::integral_constant<bool, (Base + 0 < N)>{});
+        case 1: return case_<Base + 1>(g, std::integral_constant<bool, (Base + 1 < N)>{});
+        case 2: return case_<Base + 2>(g, std::integral_constant<bool, (Base + 2 < N)>{});
+        case 3: return case_<Base + 3>(g, std::integral_constant<bool, (Base + 3 < N)>{});
+        case 4: return case_<Base + 4>(g, std::integral_constant<bool, (Base + 4 < N)>{});
+        case 5: return case_<Base + 5>(g, std::integral_constant<bool, (Base + 5 < N)>{});
+        case 6: return case_<Base + 6>(g, std::integral_constant<bool, (Base + 6 < N)>{});
+        case 7: return case_<Base + 7>(g, std::integral_constant<bool, (Base + 7 < N)>{});
+        case 8: return case_<Base + 8>(g, std::integral_constant<bool, (Base + 8 < N)>{});
+        case 9: return case_<Base + 9>(g, std::integral_constant<bool, (Base + 9 < N)>{});
+        case 10: return case_<Base + 10>(g, std::integral_constant<bool, (Base + 10 < N)>{});
+        case 11: return case_<Base + 11>(g, std::integral_constant<bool, (Base + 11 < N)>{});
+        case 12: return case_<Base + 12>(g, std::integral_constant<bool, (Base + 12 < N)>{});
+        case 13: return case_<Base + 13>(g, std::integral_constant<bool, (Base + 13 < N)>{});
+        case 14: return case_<Base + 14>(g, std::integral_constant<bool, (Base + 14 < N)>{});
+        case 15: return case_<Base + 15>(g, std::integral_constant<bool, (Base + 15 < N)>{});
+        default: return next_(i, g, std::integral_constant<bool, (Base + 16 < N)>{});
+        }
+    }
+};
+
+// small_index_t_<N> is the smallest unsigned type that holds indices in [0, N), N <= 0x10000
+
+template<std::size_t N>
+using small_index_t_ = typename std::conditional<(N <= 0x100), std::uint8_t, std::uint16_t>::type;
+
+// method_table_<Space, Method>::functions is a constexpr table of pointers to
+// Method::apply<PackedModes<Space, Key>> indexed by /Key/. All instantiations
+// of /Method/'s static member function template apply<> must have the same
+// signature.
+
+template<typename Space, typename Method, typename Keys = typename make_index_sequence_<Space::size>::type>
+struct method_table_;
+
+template<typename Space, typename Method, std::size_t... Ks>
+struct method_table_<Space, Method, index_sequence_<Ks...> > {
+    using function_type = decltype(&Method::template apply<PackedModes<Space, 0> >);
+
+    static constexpr function_type functions[sizeof...(Ks)] = { &Method::template apply<PackedModes<Space, Ks> >... };
+};
+
+template<typename Space, typename Method, std::size_t... Ks>
+constexpr typename method_table_<Space, Method, index_sequence_<Ks...> >::function_type
+    method_table_<Space, Method, index_sequence_<Ks...> >::functions[sizeof...(Ks)];
+
+} // end namespace detail
+
 ///////////////////////////////////////////////////////////////////////////////
 
 } // end namespace staticmode
@@ -0,0 +1,232 @@
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDED_STATICMODEATOMIC_H
+#define INCLUDED_STATICMODEATOMIC_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <memory> // unique_ptr
+#include <type_traits>
+#include <utility> // move
+#include <vector>
+
+#include "StaticMode.h"
+#include "StaticModeDispatch.h"
+
+// Publishing mode configuration changes to real-time threads.
+//
+// A control thread (UI, network, config reload) changes the active modes
+// while a real-time thread (e.g. an audio callback) keeps calling the
+// mode-specialized code. Readers never lock, allocate or wait.
+
+namespace staticmode {
+
+///////////////////////////////////////////////////////////////////////////////
+// atomic_mode_function<R(Args...), Cats...> is an atomically publishable
+// mode_function<R(Args...), Cats...>: the active dispatch entry.
+//
+// It holds one atomic pointer to a static, constant-initialized
+// mode_function entry (one per kernel and key), so publishing a new kernel or
+// key is a single release store, and reading the active entry (packed key and
+// function pointer together, never torn) is a single acquire load. Both are
+// wait-free and never allocate.
+//
+// example usage:
+//
+// using ResampleFunction = mode_function<void(const float*, float*, std::size_t), Interpolations, Filters>;
+// atomic_mode_function<void(const float*, float*, std::size_t), Interpolations, Filters> resample;
+//
+// // control thread
+// resample.store<ResampleKernel>(Interpolation::cubic, Filter::none);
+// if (!resample.try_store<ResampleKernel>(config.interpolation, config.filter))
+//     ... // a value that is not in its category; the previous entry stays active
+//
+// // real-time thread
+// ResampleFunction f = resample.load();
+// f(in, out, count);
+
+template<typename Sig, typename... Cats>
+class atomic_mode_function;
+
+template<typename R, typename... Args, typename... Cats>
+class atomic_mode_function<R(Args...), Cats...> {
+public:
+    using function_type = mode_function<R(Args...), Cats...>;
+    using space_type = typename function_type::space_type;
+
+    // initially unbound: load() returns an unbound mode_function
+    atomic_mode_function() noexcept : entry_(nullptr) {}
+
+    atomic_mode_function(const atomic_mode_function&) = delete;
+    atomic_mode_function& operator=(const atomic_mode_function&) = delete;
+
+    // publish Kernel::apply<PackedModes<space_type, key>>. /key/ must be valid.
+    template<typename Kernel>
+    void store(std::size_t key) noexcept {
+        assert(key < space_type::size);
+        entry_.store(&detail::mode_function_entries_<function_type, Kernel>::entries[key], std::memory_order_release);
+    }
+
+    // publish the kernel for runtime mode values (one per category, in category order)
+    template<typename Kernel>
+    void store(typename Cats::value_type... values) noexcept { store<Kernel>(space_type::key(values...)); }
+
+    // publish the kernel for mode expression /modes/
+    template<typename Kernel, typename ModeExpr, typename std::enable_if<is_mode_expr<ModeExpr>::value, int>::type = 0>
+    void store(ModeExpr) noexcept { store<Kernel>(packed_key<space_type, ModeExpr>::value); }
+
+    // try_store<Kernel>(key) and try_store<Kernel>(values...) are store() for
+    // untrusted input (e.g. a config file): they return false, leaving the
+    // active entry unchanged, if /key/ is invalid or any value is not listed
+    // in its category.
+    template<typename Kernel>
+    bool try_store(std::size_t key) noexcept {
+        if (key >= space_type::size)
+            return false;
+        store<Kernel>(key);
+        return true;
+    }
+
+    template<typename Kernel>
+    bool try_store(typename Cats::value_type... values) noexcept { return try_store<Kernel>(space_type::key(values...)); }
+
+    // the active entry
+    function_type load() const noexcept {
+        const function_type *entry = entry_.load(std::memory_order_acquire);
+        return entry ? *entry : function_type();
+    }
+
+    // call the active entry, which must be bound
+    R operator()(Args... args) const { return load()(std::forward<Args>(args)...); }
+
+    static constexpr bool is_always_lock_free = (ATOMIC_POINTER_LOCK_FREE == 2);
+
+private:
+    std::atomic<const function_type*> entry_;
+};
+
+template<typename R, typename... Args, typename... Cats>
+constexpr bool atomic_mode_function<R(Args...), Cats...>::is_always_lock_free;
+
+///////////////////////////////////////////////////////////////////////////////
+// hot_swap<T> publishes heap-allocated objects (e.g. a stateful per-mode
+// implementation, built with a mode_registry) from a control thread to one
+// real-time reader thread, with real-time safe reclamation.
+//
+// Reader (the real-time thread):
+//   - get() returns the current object: one acquire load.
+//   - quiescent() must be called regularly at a point where the reader holds
+//     no pointer obtained from get(), e.g. at the end of each audio callback:
+//     one load and one store.
+//
+// Writer (a single control thread):
+//   - publish(p) swaps in a new object and retires the previous one.
+//   - collect() deletes retired objects that the reader can no longer be
+//     using, i.e. retired before the reader's last quiescent().
+//     publish() calls collect().
+//
+// The reader never waits, allocates or deletes. Objects are always deleted
+// on the writer thread (quiescent-state based reclamation). If the reader
+// stops calling quiescent(), retired objects accumulate until it resumes.
+// The destructor deletes every object: the reader must have stopped.
+//
+// example usage:
+//
+// hot_swap<Resampler> resampler(ResamplerRegistry::build(key));
+//
+// // control thread
+// resampler.publish(ResamplerRegistry::build(newKey));
+//
+// // real-time thread, once per block
+// resampler.get()->process(in, out, count);
+// resampler.quiescent();
+
+template<typename T>
+class hot_swap {
+public:
+    explicit hot_swap(std::unique_ptr<T> initial = std::unique_ptr<T>()) noexcept
+        : current_(initial.release()), epoch_(0), readerEpoch_(0) {}
+
+    hot_swap(const hot_swap&) = delete;
+    hot_swap& operator=(const hot_swap&) = delete;
+
+    ~hot_swap() {
+        delete current_.load(std::memory_order_relaxed);
+        for (const retired_object_& r : retired_)
+            delete r.object;
+    }
+
+    // Reader: the current object (may be null)
+    T *get() const noexcept { return current_.load(std::memory_order_acquire); }
+
+    // Reader: declare that no pointer from get() is in use
+    void quiescent() noexcept {
+        readerEpoch_.store(epoch_.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    // Writer: make /p/ the current object, retire the previous one
+    void publish(std::unique_ptr<T> p) {
+        if (retired_.size() == retired_.capacity())
+            retired_.reserve(2 * retired_.size() + 1); // push_back() below must not fail after the exchange
+        T *old = current_.exchange(p.release(), std::memory_order_acq_rel);
+        std::uint64_t epoch = epoch_.fetch_add(1, std::memory_order_acq_rel) + 1;
+        if (old) {
+            retired_object_ r = { old, epoch };
+            retired_.push_back(r);
+        }
+        collect();
+    }
+
+    // Writer: delete retired objects that are no longer in use.
+    // Returns the number of retired objects that are still pending.
+    std::size_t collect() {
+        std::uint64_t readerEpoch = readerEpoch_.load(std::memory_order_acquire);
+        std::size_t pending = 0;
+        for (std::size_t i = 0; i < retired_.size(); ++i) {
+            if (retired_[i].epoch <= readerEpoch)
+                delete retired_[i].object;
+            else
+                retired_[pending++] = retired_[i];
+        }
+        retired_.resize(pending);
+        return pending;
+    }
+
+private:
+    struct retired_object_ {
+        T *object;
+        std::uint64_t epoch; // the writer epoch at which /object/ was unpublished
+    };
+
+    std::atomic<T*> current_;
+    std::atomic<std::uint64_t> epoch_;
+    std::atomic<std::uint64_t> readerEpoch_;
+    std::vector<retired_object_> retired_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // end namespace staticmode
+
+#endif /* INCLUDED_STATICMODEATOMIC_H */
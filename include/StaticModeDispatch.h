@@ -0,0 +1,645 @@
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef INCLUDED_STATICMODEDISPATCH_H
+#define INCLUDED_STATICMODEDISPATCH_H
+
+#include <cassert>
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t
+#include <type_traits>
+#include <utility> // forward
+#include <vector>
+
+#if __cplusplus >= 201703L
+#include <variant>
+#endif
+
+#include "StaticMode.h"
+
+// Runtime-to-static dispatch: calling code that is specialized on mode
+// expressions, given runtime mode values or packed keys.
+//
+// A /kernel/ is a class with a static member function template
+//
+//   template<typename ModeExpr> static R apply(Args... args);
+//
+// that is instantiated for the normalized mode sets (PackedModes) of a mode space.
+
+namespace staticmode {
+
+///////////////////////////////////////////////////////////////////////////////
+// dispatch<Space>(key, f) calls f(PackedModes<Space, key>{}) for runtime
+// packed key /key/, with a switch on the key. /f/ is a function object with
+// an operator() template, called with the concrete PackedModes type. All
+// calls must return the same type. /key/ must be valid.
+//
+// example usage:
+//
+// struct DrawLine {
+//     template<typename ModeExpr> void operator()(ModeExpr modes) const { drawLine(modes); }
+// };
+//
+// dispatch<PainterModes>(PainterModes::key(config.lineStyle, config.endStyle), DrawLine{});
+
+namespace detail {
+
+template<typename Space, typename F, typename R>
+struct packed_modes_caller_ {
+    F& f;
+
+    template<std::size_t K>
+    R operator()(std::integral_constant<std::size_t, K>) const { return f(PackedModes<Space, K>{}); }
+};
+
+} // end namespace detail
+
+template<typename Space, typename F>
+auto dispatch(std::size_t key, F&& f) -> decltype(f(PackedModes<Space, 0>{})) {
+    assert(key < Space::size);
+    detail::packed_modes_caller_<Space, F, decltype(f(PackedModes<Space, 0>{}))> g = { f };
+    return detail::dense_switch_<decltype(f(PackedModes<Space, 0>{})), Space::size>::call(key, g);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// mode_function<R(Args...), Cats...> is a lightweight replacement for a
+// std::function wrapping a switch over runtime modes. It holds the packed
+// key of a combination of modes from categories /Cats/ and a pointer to the
+// kernel instantiation for that key, resolved when the function is bound.
+// It is trivially copyable, never allocates, and invoking it costs one
+// indirect call.
+//
+// example usage:
+//
+// struct DrawLineKernel {
+//     template<typename ModeExpr>
+//     static void apply(Canvas& canvas) { ... }
+// };
+//
+// using DrawLineFunction = mode_function<void(Canvas&), LineStyles, EndStyles>;
+//
+// DrawLineFunction f = DrawLineFunction::try_bind<DrawLineKernel>(config.lineStyle, config.endStyle);
+// if (!f)
+//     ... // a value that is not in its category
+// f(canvas);
+
+template<typename Sig, typename... Cats>
+class mode_function;
+
+namespace detail {
+
+// mode_function_entries_<Function, Kernel>::entries[key] is a static mode_function
+// bound to Kernel for /key/, for publishing by address (see StaticModeAtomic.h)
+
+template<typename Function, typename Kernel,
+    typename Keys = typename make_index_sequence_<Function::space_type::size>::type>
+struct mode_function_entries_;
+
+template<typename Function, typename Kernel, std::size_t... Ks>
+struct mode_function_entries_<Function, Kernel, index_sequence_<Ks...> > {
+    static constexpr Function entries[sizeof...(Ks)] = {
+        Function(&Kernel::template apply<PackedModes<typename Function::space_type, Ks> >, Ks)... };
+};
+
+template<typename Function, typename Kernel, std::size_t... Ks>
+constexpr Function mode_function_entries_<Function, Kernel, index_sequence_<Ks...> >::entries[sizeof...(Ks)];
+
+} // end namespace detail
+
+template<typename R, typename... Args, typename... Cats>
+class mode_function<R(Args...), Cats...> {
+public:
+    using space_type = ModeSpace<Cats...>;
+    using function_type = R (*)(Args...);
+    using key_type = detail::small_index_t_<space_type::size>;
+
+    static_assert(space_type::size <= 0x10000, "Too many combinations: the key must fit in key_type.");
+
+    // an unbound mode_function. Calling it is undefined.
+    constexpr mode_function() noexcept : fn_(nullptr), key_(0) {}
+
+    // bind<Kernel>(key) binds Kernel::apply<PackedModes<space_type, key>>. /key/ must be valid.
+    template<typename Kernel>
+    static mode_function bind(std::size_t key) noexcept {
+        static_assert(std::is_same<typename detail::method_table_<space_type, Kernel>::function_type, function_type>::value,
+            "/Kernel/::apply<> must have signature R(Args...).");
+        assert(key < space_type::size);
+        return mode_function(detail::method_table_<space_type, Kernel>::functions[key], key);
+    }
+
+    // bind<Kernel>(values...) binds the kernel for runtime mode values (one per category, in category order)
+    template<typename Kernel>
+    static mode_function bind(typename Cats::value_type... values) noexcept {
+        return bind<Kernel>(space_type::key(values...));
+    }
+
+    // bind<Kernel>(modes) binds the kernel for mode expression /modes/
+    template<typename Kernel, typename ModeExpr, typename std::enable_if<is_mode_expr<ModeExpr>::value, int>::type = 0>
+    static mode_function bind(ModeExpr) noexcept {
+        return bind<Kernel>(packed_key<space_type, ModeExpr>::value);
+    }
+
+    // try_bind<Kernel>(key) and try_bind<Kernel>(values...) are bind() for
+    // untrusted input (e.g. a config file): they return an unbound
+    // mode_function if /key/ is invalid or any value is not listed in its
+    // category.
+    template<typename Kernel>
+    static mode_function try_bind(std::size_t key) noexcept {
+        return (key < space_type::size) ? bind<Kernel>(key) : mode_function();
+    }
+
+    template<typename Kernel>
+    static mode_function try_bind(typename Cats::value_type... values) noexcept {
+        return try_bind<Kernel>(space_type::key(values...));
+    }
+
+    R operator()(Args... args) const { return fn_(std::forward<Args>(args)...); }
+
+    explicit operator bool() const noexcept { return fn_ != nullptr; }
+
+    // the packed key of the bound modes
+    std::size_t key() const noexcept { return key_; }
+
+    function_type target() const noexcept { return fn_; }
+
+private:
+    template<typename Function, typename Kernel, typename Keys>
+    friend struct detail::mode_function_entries_;
+
+    constexpr mode_function(function_type fn, std::size_t key) noexcept : fn_(fn), key_(static_cast<key_type>(key)) {}
+
+    function_type fn_;
+    key_type key_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Multiple dispatch on the modes of several objects
+//
+// multi_dispatch<Kernel, Spaces...> is a single constexpr table of the
+// instantiations Kernel::apply<PackedModes<Spaces, Keys>...> for every
+// combination of keys, one key per space. find(keys...) maps runtime packed
+// keys to a kernel instantiation with one table lookup, instead of nested
+// switches or nested virtual calls.
+//
+// example usage:
+//
+// struct ConvertKernel {
+//     template<typename FromModes, typename ToModes>
+//     static void apply(const Image& from, Image& to) { ... }
+// };
+//
+// using ConvertDispatch = multi_dispatch<ConvertKernel, FormatModes, FormatModes>;
+//
+// ConvertDispatch::find(from.formatKey(), to.formatKey())(from, to);
+//
+// symmetric_dispatch<Kernel, Space> is for kernels on two operands of the
+// same space whose result does not depend on the order of their modes, i.e.
+// Kernel::apply<A, B> is equivalent to Kernel::apply<B, A>. Only apply<A, B>
+// with key(A) <= key(B) is instantiated: n * (n + 1) / 2 instantiations and
+// table entries instead of n * n.
+
+namespace detail {
+
+// mixed_radix_<Ns...> indexes tuples of digits (d0, d1, ...) with d0 < N0, d1 < N1, ...
+// The first digit is the least significant.
+
+template<std::size_t... Ns>
+struct mixed_radix_ {
+    static constexpr std::size_t size = 1;
+    static constexpr std::size_t index() noexcept { return 0; }
+    static constexpr bool valid() noexcept { return true; }
+    static constexpr std::size_t digit(std::size_t, std::size_t) noexcept { return 0; }
+};
+
+template<std::size_t N, std::size_t... Ns>
+struct mixed_radix_<N, Ns...> {
+    using rest_ = mixed_radix_<Ns...>;
+
+    static constexpr std::size_t size = N * rest_::size;
+
+    template<typename... Ks>
+    static constexpr std::size_t index(std::size_t k, Ks... ks) noexcept { return k + N * rest_::index(ks...); }
+
+    template<typename... Ks>
+    static constexpr bool valid(std::size_t k, Ks... ks) noexcept { return k < N && rest_::valid(ks...); }
+
+    // digit(i, j) is digit /j/ of index /i/
+    static constexpr std::size_t digit(std::size_t i, std::size_t j) noexcept {
+        return (j == 0) ? i % N : rest_::digit(i / N, j - 1);
+    }
+};
+
+template<typename T>
+using key_param_ = std::size_t;
+
+template<typename Kernel, typename Spaces, typename SpaceIndices, typename Entries>
+struct multi_table_;
+
+template<typename Kernel, typename... Spaces, std::size_t... Js, std::size_t... Is>
+struct multi_table_<Kernel, type_pack<Spaces...>, index_sequence_<Js...>, index_sequence_<Is...> > {
+    using radix = mixed_radix_<Spaces::size...>;
+    using function_type = decltype(&Kernel::template apply<PackedModes<Spaces, 0>...>);
+
+    template<std::size_t I>
+    static constexpr function_type entry_() noexcept {
+        return &Kernel::template apply<PackedModes<Spaces, radix::digit(I, Js)>...>;
+    }
+
+    static constexpr function_type functions[sizeof...(Is)] = { entry_<Is>()... };
+};
+
+template<typename Kernel, typename... Spaces, std::size_t... Js, std::size_t... Is>
+constexpr typename multi_table_<Kernel, type_pack<Spaces...>, index_sequence_<Js...>, index_sequence_<Is...> >::function_type
+    multi_table_<Kernel, type_pack<Spaces...>, index_sequence_<Js...>, index_sequence_<Is...> >::functions[sizeof...(Is)];
+
+// triangle_row_(i) is the largest b with b * (b + 1) / 2 <= i
+
+constexpr std::size_t triangle_row_(std::size_t i, std::size_t b = 0) noexcept {
+    return ((b + 1) * (b + 2) / 2 > i) ? b : triangle_row_(i, b + 1);
+}
+
+template<typename Kernel, typename Space, typename Entries>
+struct symmetric_table_;
+
+template<typename Kernel, typename Space, std::size_t... Is>
+struct symmetric_table_<Kernel, Space, index_sequence_<Is...> > {
+    using function_type = decltype(&Kernel::template apply<PackedModes<Space, 0>, PackedModes<Space, 0> >);
+
+    template<std::size_t I>
+    static constexpr function_type entry_() noexcept {
+        return &Kernel::template apply<
+            PackedModes<Space, I - triangle_row_(I) * (triangle_row_(I) + 1) / 2>, PackedModes<Space, triangle_row_(I)> >;
+    }
+
+    static constexpr function_type functions[sizeof...(Is)] = { entry_<Is>()... };
+};
+
+template<typename Kernel, typename Space, std::size_t... Is>
+constexpr typename symmetric_table_<Kernel, Space, index_sequence_<Is...> >::function_type
+    symmetric_table_<Kernel, Space, index_sequence_<Is...> >::functions[sizeof...(Is)];
+
+} // end namespace detail
+
+template<typename Kernel, typename... Spaces>
+struct multi_dispatch {
+    static_assert(sizeof...(Spaces) > 0, "multi_dispatch requires at least one mode space.");
+
+    using table_ = detail::multi_table_<Kernel, type_pack<Spaces...>,
+        typename detail::make_index_sequence_<sizeof...(Spaces)>::type,
+        typename detail::make_index_sequence_<detail::mixed_radix_<Spaces::size...>::size>::type>;
+
+    using function_type = typename table_::function_type;
+
+    // number of table entries (and kernel instantiations)
+    static constexpr std::size_t size = detail::mixed_radix_<Spaces::size...>::size;
+
+    // find(keys...) returns the kernel instantiation for packed keys /keys/
+    // (one per space, in order), or nullptr if any key is invalid
+    static function_type find(detail::key_param_<Spaces>... keys) noexcept {
+        return detail::mixed_radix_<Spaces::size...>::valid(keys...)
+            ? table_::functions[detail::mixed_radix_<Spaces::size...>::index(keys...)] : nullptr;
+    }
+};
+
+template<typename Kernel, typename... Spaces>
+constexpr std::size_t multi_dispatch<Kernel, Spaces...>::size;
+
+template<typename Kernel, typename Space>
+struct symmetric_dispatch {
+    // number of table entries (and kernel instantiations)
+    static constexpr std::size_t size = Space::size * (Space::size + 1) / 2;
+
+    using table_ = detail::symmetric_table_<Kernel, Space, typename detail::make_index_sequence_<size>::type>;
+
+    using function_type = typename table_::function_type;
+
+    // find(a, b) returns Kernel::apply<PackedModes<Space, min(a, b)>, PackedModes<Space, max(a, b)>>,
+    // or nullptr if either key is invalid
+    static function_type find(std::size_t a, std::size_t b) noexcept {
+        if (a > b) {
+            std::size_t t = a;
+            a = b;
+            b = t;
+        }
+        return (b < Space::size) ? table_::functions[b * (b + 1) / 2 + a] : nullptr;
+    }
+};
+
+template<typename Kernel, typename Space>
+constexpr std::size_t symmetric_dispatch<Kernel, Space>::size;
+
+///////////////////////////////////////////////////////////////////////////////
+// mode_batch<Space> partitions a batch of items that each carry their own
+// packed mode key into one bucket per key, so that a kernel can be called
+// once per bucket instead of dispatching per item.
+//
+// partition(count, keyOf) is a stable counting sort of item indices
+// [0, count) by keyOf(i). keyOf is called once per item. Afterwards,
+// order()[j] is the original index of the j-th item in bucket order, and the
+// items with key /k/ occupy positions [bucket_begin(k), bucket_end(k)).
+//
+// Keys come from runtime data, so partition() checks them: an item whose key
+// is not less than Space::size is rejected. Rejected items are placed, in
+// order, in a reject bucket after the last bucket, positions
+// [rejected_begin(), size()), which for_each_bucket() skips. partition()
+// returns the number of rejected items.
+//
+// gather(src, dst) copies per-item data into bucket order, so that each
+// bucket is contiguous in /dst/. scatter(src, dst) copies per-item results
+// in bucket order back to the original order.
+//
+// for_each_bucket<Kernel>(args...) calls
+// Kernel::apply<PackedModes<Space, k>>(first, last, args...) once for each
+// non-empty bucket /k/, where [first, last) are its positions in bucket
+// order. /args/ are passed to each call as lvalues.
+//
+// The buffers are retained between batches: after the first few batches,
+// partition() does not allocate.
+//
+// example usage:
+//
+// struct ShadeKernel {
+//     template<typename ModeExpr>
+//     static void apply(std::size_t first, std::size_t last, const Pixel *in, Pixel *out) {
+//         for (std::size_t i = first; i < last; ++i)
+//             out[i] = shade(ModeExpr{}, in[i]);
+//     }
+// };
+//
+// mode_batch<ShadeModes> batch;
+// batch.partition(count, [&](std::size_t i) { return records[i].modeKey; });
+// batch.gather(pixels, sortedPixels);
+// batch.for_each_bucket<ShadeKernel>(sortedPixels, sortedResults);
+// batch.scatter(sortedResults, results);
+
+template<typename Space>
+class mode_batch {
+public:
+    using space_type = Space;
+
+    template<typename KeyFn>
+    std::size_t partition(std::size_t count, KeyFn keyOf) {
+        keys_.resize(count);
+        order_.resize(count);
+
+        // count bucket sizes in offsets_[k + 1], then accumulate so that offsets_[k] is the start of bucket /k/.
+        // Bucket Space::size is the reject bucket.
+        offsets_.assign(Space::size + 2, 0);
+        bool uniform = true;
+        for (std::size_t i = 0; i < count; ++i) {
+            std::size_t key = static_cast<std::size_t>(keyOf(i));
+            if (key > Space::size)
+                key = Space::size;
+            keys_[i] = static_cast<key_type_>(key);
+            ++offsets_[key + 1];
+            uniform &= (keys_[i] == keys_[0]);
+        }
+        for (std::size_t k = 0; k <= Space::size; ++k)
+            offsets_[k + 1] += offsets_[k];
+
+        const std::size_t rejected = count - offsets_[Space::size];
+
+        if (uniform) { // a single bucket: the order is unchanged
+            for (std::size_t i = 0; i < count; ++i)
+                order_[i] = i;
+            return rejected;
+        }
+
+        // place items using offsets_[k] as the next free position in bucket /k/,
+        // which leaves offsets_[k] == the end of bucket /k/. Then shift back.
+        for (std::size_t i = 0; i < count; ++i)
+            order_[offsets_[keys_[i]]++] = i;
+        for (std::size_t k = Space::size + 1; k > 0; --k)
+            offsets_[k] = offsets_[k - 1];
+        offsets_[0] = 0;
+        return rejected;
+    }
+
+    // number of items in the batch
+    std::size_t size() const noexcept { return order_.size(); }
+
+    std::size_t bucket_begin(std::size_t key) const noexcept { assert(key < Space::size); return offsets_[key]; }
+    std::size_t bucket_end(std::size_t key) const noexcept { assert(key < Space::size); return offsets_[key + 1]; }
+    std::size_t bucket_size(std::size_t key) const noexcept { return bucket_end(key) - bucket_begin(key); }
+
+    // the start of the reject bucket, which ends at size()
+    std::size_t rejected_begin() const noexcept { return offsets_[Space::size]; }
+
+    // the permutation from bucket order to original order
+    const std::size_t* order() const noexcept { return order_.data(); }
+
+    // dst[j] = src[order()[j]], for j in [0, size())
+    template<typename T>
+    void gather(const T *src, T *dst) const {
+        for (std::size_t j = 0; j < order_.size(); ++j)
+            dst[j] = src[order_[j]];
+    }
+
+    // dst[order()[j]] = src[j], for j in [0, size())
+    template<typename T>
+    void scatter(const T *src, T *dst) const {
+        for (std::size_t j = 0; j < order_.size(); ++j)
+            dst[order_[j]] = src[j];
+    }
+
+    template<typename Kernel, typename... Args>
+    void for_each_bucket(Args&&... args) const {
+        using table_ = detail::method_table_<Space, Kernel>;
+        for (std::size_t k = 0; k < Space::size; ++k) {
+            if (offsets_[k] != offsets_[k + 1])
+                table_::functions[k](offsets_[k], offsets_[k + 1], args...);
+        }
+    }
+
+private:
+    static_assert(Space::size <= 0x10000, "Too many combinations.");
+
+    // holds keys in [0, Space::size], Space::size marking a rejected item
+    using key_type_ = typename std::conditional<(Space::size < 0x10000),
+        detail::small_index_t_<Space::size + 1>, std::uint32_t>::type;
+
+    std::vector<key_type_> keys_;
+    std::vector<std::size_t> order_;
+    std::vector<std::size_t> offsets_ = std::vector<std::size_t>(Space::size + 2, 0); // bucket starts, then the end
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// dispatch_block<Space, Kernel>(key, data, count, args...) runs a block
+// kernel over a block of elements whose modes are fixed for the whole block:
+//
+//   Kernel::apply<PackedModes<Space, key>>(data, count, args...)
+//
+// The runtime key is resolved once per block, and the kernel is instantiated
+// for each combination of modes. The kernel owns the loop, so it can take
+// block parameters (gains, coefficients, an output buffer), carry state from
+// one element to the next, and tile or hand-vectorize its loop. /args/ are
+// forwarded, so state can be passed by reference.
+//
+// dispatch_elements<Space, Kernel>(key, in, out, count) is a convenience
+// adapter for a per-element kernel, which sees one element and nothing else:
+//
+//   out[i] = Kernel::apply<PackedModes<Space, key>>(in[i]), for i in [0, count)
+//
+// dispatch_elements<Space, Kernel>(key, data, count) is the in-place form,
+// which calls Kernel::apply<PackedModes<Space, key>>(data[i]) with data[i] by
+// reference. Both run a loop that is instantiated for each combination of
+// modes, so the kernel is inlined into a loop that the compiler can
+// vectorize for that combination. Compare with calling a per-element
+// function that switches on runtime modes.
+//
+// example usage:
+//
+// struct GainBlock {
+//     template<typename ModeExpr>
+//     static void apply(const float *in, std::size_t count, float *out, float gain, float& state) {
+//         for (std::size_t i = 0; i < count; ++i)
+//             out[i] = state = smooth_(curve_t<ModeExpr>{}, state, gain * in[i]);
+//     }
+// };
+//
+// dispatch_block<GainModes, GainBlock>(GainModes::key(config.curve, config.clip), input, blockSize, output, gain, state);
+//
+// struct GainSample {
+//     template<typename ModeExpr>
+//     static float apply(float x) { return curve_(curve_t<ModeExpr>{}, x); }
+// };
+//
+// dispatch_elements<GainModes, GainSample>(GainModes::key(config.curve, config.clip), input, output, blockSize);
+
+template<typename Space, typename Kernel, typename T, typename... Args>
+void dispatch_block(std::size_t key, T *data, std::size_t count, Args&&... args) {
+    assert(key < Space::size);
+    detail::method_table_<Space, Kernel>::functions[key](data, count, std::forward<Args>(args)...);
+}
+
+namespace detail {
+
+// block kernels that apply a per-element kernel to each element
+
+template<typename Kernel, typename In, typename Out>
+struct element_loop_ {
+    template<typename ModeExpr>
+    static void apply(const In *in, std::size_t count, Out *out) {
+        for (std::size_t i = 0; i < count; ++i)
+            out[i] = Kernel::template apply<ModeExpr>(in[i]);
+    }
+};
+
+template<typename Kernel, typename T>
+struct element_loop_in_place_ {
+    template<typename ModeExpr>
+    static void apply(T *data, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i)
+            Kernel::template apply<ModeExpr>(data[i]);
+    }
+};
+
+} // end namespace detail
+
+template<typename Space, typename Kernel, typename In, typename Out>
+void dispatch_elements(std::size_t key, const In *in, Out *out, std::size_t count) {
+    dispatch_block<Space, detail::element_loop_<Kernel, In, Out> >(key, in, count, out);
+}
+
+template<typename Space, typename Kernel, typename T>
+void dispatch_elements(std::size_t key, T *data, std::size_t count) {
+    dispatch_block<Space, detail::element_loop_in_place_<Kernel, T> >(key, data, count);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Conversion to std::variant (C++17)
+//
+// to_variant<LineStyles>(x) converts runtime value /x/ of ModeCategory
+// /LineStyles/ to a std::variant<Mode<LineStyle, ...>...> with one
+// alternative per mode of the category, in category order.
+//
+// to_variant<PainterModes>(key) converts packed key /key/ of ModeSpace
+// /PainterModes/ to a std::variant of its normalized ModeSets, with
+// alternative index == key.
+//
+// to_variant_t<X> is the variant type. The argument must be valid (a listed
+// value or a key < size).
+//
+// example usage:
+//
+// std::visit([](auto modes) { drawLine(modes); }, to_variant<PainterModes>(key));
+
+#if __cplusplus >= 201703L
+
+namespace detail {
+
+template<typename X, typename = void>
+struct std_variant_of_ {};
+
+template<typename T, T... Xs>
+struct std_variant_of_<ModeCategory<T, Xs...>, void> {
+    using type = std::variant<Mode<T, Xs>...>;
+    static constexpr std::size_t size = sizeof...(Xs);
+};
+
+template<typename Space, typename Keys>
+struct space_std_variant_;
+
+template<typename Space, std::size_t... Ks>
+struct space_std_variant_<Space, index_sequence_<Ks...> > {
+    using type = std::variant<typename Space::template mode_set_t<Ks>...>;
+};
+
+template<typename Space>
+struct std_variant_of_<Space, std::void_t<typename Space::categories> > {
+    using type = typename space_std_variant_<Space, typename make_index_sequence_<Space::size>::type>::type;
+    static constexpr std::size_t size = Space::size;
+};
+
+template<typename Variant>
+struct make_std_variant_ {
+    template<std::size_t I>
+    Variant operator()(std::integral_constant<std::size_t, I>) const { return Variant(std::in_place_index<I>); }
+};
+
+} // end namespace detail
+
+template<typename X>
+using to_variant_t = typename detail::std_variant_of_<X>::type;
+
+template<typename Cat>
+to_variant_t<Cat> to_variant(typename Cat::value_type x) {
+    std::size_t i = Cat::index_of(x);
+    assert(i < Cat::size);
+    detail::make_std_variant_<to_variant_t<Cat> > g;
+    return detail::dense_switch_<to_variant_t<Cat>, Cat::size>::call(i, g);
+}
+
+template<typename Space, typename = typename Space::categories>
+to_variant_t<Space> to_variant(std::size_t key) {
+    assert(key < Space::size);
+    detail::make_std_variant_<to_variant_t<Space> > g;
+    return detail::dense_switch_<to_variant_t<Space>, Space::size>::call(key, g);
+}
+
+#endif /* __cplusplus >= 201703L */
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // end namespace staticmode
+
+#endif /* INCLUDED_STATICMODEDISPATCH_H */
@@ -0,0 +1,874 @@
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDED_STATICMODEERASURE_H
+#define INCLUDED_STATICMODEERASURE_H
+
+#include <cassert>
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t, uint16_t
+#include <memory> // unique_ptr
+#include <new> // placement new
+#include <tuple>
+#include <type_traits>
+#include <utility> // move, forward
+#include <vector>
+
+#include "StaticMode.h"
+
+// Type erasure support for mode-configured implementations.
+//
+// A mode-configured implementation is a class template /Impl/ that takes a
+// mode expression, e.g. `template<typename ModeExpr> class AsciiPainterT`
+// (see examples/type-erasure.cpp). The facilities below are instantiated over
+// every normalized mode set of a ModeSpace, i.e. over
+// Impl<PackedModes<Space, 0>> ... Impl<PackedModes<Space, Space::size - 1>>.
+
+namespace staticmode {
+
+namespace detail {
+
+constexpr std::size_t max_(std::size_t a) noexcept { return a; }
+
+template<typename... Ns>
+constexpr std::size_t max_(std::size_t a, std::size_t b, Ns... ns) noexcept {
+    return max_((a < b) ? b : a, ns...);
+}
+
+// impl_storage_<Impl, Space>: size and alignment of the largest /Impl/ instantiation over /Space/
+
+template<template<typename> class Impl, typename Space,
+    typename Keys = typename make_index_sequence_<Space::size>::type>
+struct impl_storage_;
+
+template<template<typename> class Impl, typename Space, std::size_t... Ks>
+struct impl_storage_<Impl, Space, index_sequence_<Ks...> > {
+    static constexpr std::size_t size = max_(sizeof(Impl<PackedModes<Space, Ks> >)...);
+    static constexpr std::size_t align = max_(alignof(Impl<PackedModes<Space, Ks> >)...);
+};
+
+// holder_ops_<Base>: per-type copy/move/destroy operations used by mode_holder.
+// copy and move construct into /dst/ and return the Base subobject of the new object.
+
+template<typename Base>
+struct holder_ops_ {
+    Base *(*copy)(void *dst, const void *src);
+    Base *(*move)(void *dst, void *src);
+    void (*destroy)(void *p);
+};
+
+template<typename Base, typename T>
+struct holder_ops_for_ {
+    static Base *copy(void *dst, const void *src) { return ::new (dst) T(*static_cast<const T*>(src)); }
+    static Base *move(void *dst, void *src) { return ::new (dst) T(std::move(*static_cast<T*>(src))); }
+    static void destroy(void *p) { static_cast<T*>(p)->~T(); }
+
+    static constexpr holder_ops_<Base> ops = { &copy, &move, &destroy };
+};
+
+template<typename Base, typename T>
+constexpr holder_ops_<Base> holder_ops_for_<Base, T>::ops;
+
+} // end namespace detail
+
+///////////////////////////////////////////////////////////////////////////////
+// mode_holder<Base, Impl, Space> holds one object derived from /Base/ in place,
+// without heap allocation. Its buffer is sized and aligned for the largest
+// Impl<PackedModes<Space, Key>> over all keys of /Space/.
+//
+// mode_holder has value semantics: copying a holder copies the held object.
+// A holder is never empty: a default-constructed holder holds the
+// implementation for the default modes (key 0).
+//
+// example usage:
+//
+// using PainterHolder = mode_holder<Painter, AsciiPainterT, PainterModes>;
+// PainterHolder p(dashed|arrows); // holds an AsciiPainterT<compact_t<PainterModes, decltype(dashed|arrows)>>
+// p->drawLine();
+//
+// Held types must be copy constructible and nothrow move constructible.
+// Assignment and emplace() give the strong exception guarantee: the new
+// object is constructed in a temporary holder (on the stack) and then moved in.
+
+template<typename Base, template<typename> class Impl, typename Space>
+class mode_holder {
+    using storage_ = detail::impl_storage_<Impl, Space>;
+
+    template<typename T>
+    struct in_place_ {};
+
+public:
+    using base_type = Base;
+    using space_type = Space;
+
+    // impl_t<ModeExpr> is the held type for mode expression /ModeExpr/
+    template<typename ModeExpr>
+    using impl_t = Impl<compact_t<Space, ModeExpr> >;
+
+private:
+    // SFINAE-friendly impl_t: no /type/ member if /ModeExpr/ is not a mode expression
+    template<typename ModeExpr, bool = is_mode_expr<ModeExpr>::value>
+    struct impl_of_ {};
+
+    template<typename ModeExpr>
+    struct impl_of_<ModeExpr, true> { using type = impl_t<ModeExpr>; };
+
+public:
+    static constexpr std::size_t capacity = storage_::size;
+    static constexpr std::size_t alignment = storage_::align;
+
+    mode_holder() : mode_holder(in_place_<Impl<PackedModes<Space, 0> > >{}) {}
+
+    // construct an impl_t<ModeExpr>
+    template<typename ModeExpr, typename std::enable_if<is_mode_expr<ModeExpr>::value, int>::type = 0>
+    explicit mode_holder(ModeExpr) : mode_holder(in_place_<impl_t<ModeExpr> >{}) {}
+
+    mode_holder(const mode_holder& rhs)
+        : ops_(rhs.ops_), base_(ops_->copy(&storage_bytes_, &rhs.storage_bytes_)) {}
+
+    // NB: /rhs/ continues to hold its (moved-from) object
+    mode_holder(mode_holder&& rhs) noexcept
+        : ops_(rhs.ops_), base_(ops_->move(&storage_bytes_, &rhs.storage_bytes_)) {}
+
+    ~mode_holder() { ops_->destroy(&storage_bytes_); }
+
+    mode_holder& operator=(const mode_holder& rhs) {
+        if (this != &rhs) {
+            mode_holder temp(rhs);
+            *this = std::move(temp);
+        }
+        return *this;
+    }
+
+    mode_holder& operator=(mode_holder&& rhs) noexcept {
+        if (this != &rhs) {
+            ops_->destroy(&storage_bytes_);
+            ops_ = rhs.ops_;
+            base_ = ops_->move(&storage_bytes_, &rhs.storage_bytes_);
+        }
+        return *this;
+    }
+
+    // replace the held object with a T constructed from /args/
+    template<typename T, typename... Args>
+    T& emplace(Args&&... args) {
+        mode_holder temp(in_place_<T>{}, std::forward<Args>(args)...);
+        *this = std::move(temp);
+        return *static_cast<T*>(base_);
+    }
+
+    // replace the held object with an impl_t<ModeExpr>
+    template<typename ModeExpr>
+    typename impl_of_<ModeExpr>::type& emplace(ModeExpr) { return emplace<impl_t<ModeExpr> >(); }
+
+    Base *get() noexcept { return base_; }
+    const Base *get() const noexcept { return base_; }
+
+    Base *operator->() noexcept { return base_; }
+    const Base *operator->() const noexcept { return base_; }
+
+    Base& operator*() noexcept { return *base_; }
+    const Base& operator*() const noexcept { return *base_; }
+
+private:
+    template<typename T, typename... Args>
+    explicit mode_holder(in_place_<T>, Args&&... args)
+        : ops_(&detail::holder_ops_for_<Base, T>::ops)
+        , base_(::new (&storage_bytes_) T(std::forward<Args>(args)...))
+    {
+        static_assert(std::is_base_of<Base, T>::value, "/T/ must derive from /Base/.");
+        static_assert(sizeof(T) <= capacity, "/T/ is too large for this mode_holder.");
+        static_assert(alignof(T) <= alignment, "/T/ is over-aligned for this mode_holder.");
+        static_assert(std::is_nothrow_move_constructible<T>::value, "/T/ must be nothrow move constructible.");
+    }
+
+    const detail::holder_ops_<Base> *ops_;
+    Base *base_;
+    typename std::aligned_storage<capacity, alignment>::type storage_bytes_;
+};
+
+template<typename Base, template<typename> class Impl, typename Space>
+constexpr std::size_t mode_holder<Base, Impl, Space>::capacity;
+
+template<typename Base, template<typename> class Impl, typename Space>
+constexpr std::size_t mode_holder<Base, Impl, Space>::alignment;
+
+///////////////////////////////////////////////////////////////////////////////
+// Flyweights for stateless implementations
+//
+// A mode-configured implementation often has no per-object state: all of its
+// behavior is determined by its modes. For such types there is no need to
+// construct more than one object per combination.
+//
+// is_stateless<T>::value is true if /T/ has no data members, i.e. /T/ is
+// empty or /T/ is polymorphic and consists only of a vtable pointer.
+// Specialize is_stateless to override the detection, e.g. for a type that
+// is the size of a pointer but holds state.
+
+template<typename T>
+struct is_stateless : std::integral_constant<bool,
+    std::is_class<T>::value && std::is_default_constructible<T>::value
+    && (std::is_empty<T>::value || (std::is_polymorphic<T>::value && sizeof(T) == sizeof(void*)))> {};
+
+namespace detail {
+
+// flyweight_storage_<T> holds the shared instance of /T/. It is never
+// destroyed, so it remains valid during static destruction.
+//
+// Under C++20 it is a namespace scope variable declared constinit, so /T/'s
+// default constructor must be constexpr (as the implicit default constructor
+// of a class without data members is): the instance is ready before any
+// dynamic initialization runs. Before C++20 that can't be checked, so it is a
+// function local static instead: constant-initialized if /T/'s default
+// constructor is constexpr, otherwise initialized on first use. Either way
+// there is no static initialization order problem.
+
+template<typename T>
+union flyweight_storage_ {
+    constexpr flyweight_storage_() : value() {}
+    ~flyweight_storage_() {}
+
+    T value;
+};
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wexit-time-destructors" // the destructor is empty
+#pragma clang diagnostic ignored "-Wglobal-constructors" // constant-initialized
+#endif
+
+#if defined(__cpp_constinit) && __cpp_constinit >= 201907L
+
+template<typename T>
+struct flyweight_instance_ {
+    static flyweight_storage_<T> storage;
+
+    static T& get() noexcept { return storage.value; }
+};
+
+template<typename T>
+constinit flyweight_storage_<T> flyweight_instance_<T>::storage;
+
+#else
+
+template<typename T>
+struct flyweight_instance_ {
+    static T& get() noexcept {
+        static flyweight_storage_<T> storage;
+        return storage.value;
+    }
+};
+
+#endif
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif
+
+} // end namespace detail
+
+// flyweight<T>() returns the single shared instance of stateless type /T/
+
+template<typename T>
+T& flyweight() noexcept {
+    static_assert(is_stateless<T>::value, "/T/ is not stateless. Use new or mode_holder instead.");
+    return detail::flyweight_instance_<T>::get();
+}
+
+// flyweight_deleter deletes owned objects and ignores shared flyweights
+
+struct flyweight_deleter {
+    bool owned;
+
+    template<typename T>
+    void operator()(T *p) const noexcept {
+        if (owned)
+            delete p;
+    }
+};
+
+// flyweight_ptr<Base> points to either a shared flyweight or an owned object
+
+template<typename Base>
+using flyweight_ptr = std::unique_ptr<Base, flyweight_deleter>;
+
+// make_flyweight<Base, T>(args...) returns a flyweight_ptr<Base> to
+// flyweight<T>() if /T/ is stateless (no allocation), otherwise to a
+// new T(args...).
+//
+// example usage:
+//
+// template<typename ModeExpr>
+// flyweight_ptr<Painter> buildAsciiPainter(ModeExpr) { return make_flyweight<Painter, AsciiPainterT<ModeExpr>>(); }
+
+namespace detail {
+
+template<typename Base, typename T>
+flyweight_ptr<Base> make_flyweight_(std::true_type /*stateless*/) {
+    return flyweight_ptr<Base>(&flyweight<T>(), flyweight_deleter{false});
+}
+
+template<typename Base, typename T, typename... Args>
+flyweight_ptr<Base> make_flyweight_(std::false_type /*stateless*/, Args&&... args) {
+    return flyweight_ptr<Base>(new T(std::forward<Args>(args)...), flyweight_deleter{true});
+}
+
+} // end namespace detail
+
+template<typename Base, typename T, typename... Args>
+flyweight_ptr<Base> make_flyweight(Args&&... args) {
+    static_assert(std::is_base_of<Base, T>::value, "/T/ must derive from /Base/.");
+    // (arguments are only accepted by stateful types)
+    return detail::make_flyweight_<Base, T>(
+        std::integral_constant<bool, is_stateless<T>::value && sizeof...(Args) == 0>{}, std::forward<Args>(args)...);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// mode_registry<Space, Factory> maps each packed key of /Space/ to a factory
+// function. /Factory/ is a class with a static member function template
+//
+//   template<typename ModeExpr> static R make(Args... args);
+//
+// which is instantiated for each PackedModes<Space, Key>. The table of
+// function pointers is a constexpr array, so it is built at compile time:
+// there are no registration constructors, nothing runs at startup and
+// lookup is a single array index.
+//
+// example usage:
+//
+// struct PainterFactory {
+//     template<typename ModeExpr>
+//     static PainterHolder make() { return PainterHolder(ModeExpr{}); }
+// };
+//
+// using PainterRegistry = mode_registry<PainterModes, PainterFactory>;
+//
+// PainterHolder p = PainterRegistry::build(PainterModes::key(lineStyle, endStyle)); // valid key
+//
+// For keys from outside the program, use find(), which returns nullptr for
+// an invalid key: build() only asserts.
+
+template<typename Space, typename Factory,
+    typename Keys = typename detail::make_index_sequence_<Space::size>::type>
+struct mode_registry;
+
+template<typename Space, typename Factory, std::size_t... Ks>
+struct mode_registry<Space, Factory, detail::index_sequence_<Ks...> > {
+    using space_type = Space;
+
+    // pointer to factory function type (all instantiations of make<> must have the same signature)
+    using factory_type = decltype(&Factory::template make<PackedModes<Space, 0> >);
+
+    static constexpr std::size_t size = Space::size;
+
+    static constexpr factory_type factories[sizeof...(Ks)] = { &Factory::template make<PackedModes<Space, Ks> >... };
+
+    // find(key) returns the factory for /key/, or nullptr if /key/ is invalid
+    static constexpr factory_type find(std::size_t key) noexcept {
+        return (key < size) ? factories[key] : nullptr;
+    }
+
+    // build(key, args...) calls the factory for /key/. /key/ must be valid.
+    template<typename... Args>
+    static auto build(std::size_t key, Args&&... args) -> decltype(factories[0](std::forward<Args>(args)...)) {
+        assert(key < size);
+        return factories[key](std::forward<Args>(args)...);
+    }
+};
+
+template<typename Space, typename Factory, std::size_t... Ks>
+constexpr std::size_t mode_registry<Space, Factory, detail::index_sequence_<Ks...> >::size;
+
+template<typename Space, typename Factory, std::size_t... Ks>
+constexpr typename mode_registry<Space, Factory, detail::index_sequence_<Ks...> >::factory_type
+    mode_registry<Space, Factory, detail::index_sequence_<Ks...> >::factories[sizeof...(Ks)];
+
+///////////////////////////////////////////////////////////////////////////////
+// mode_variant<Impl, Combinations...> holds exactly one of
+// Impl<Combinations>... inline, with a small index identifying which one.
+// It is a closed-world alternative to a Painter base class with virtual
+// functions: visit() dispatches with a dense switch on the index and calls
+// its function object with the concrete static type, so the call can be
+// inlined.
+//
+// example usage:
+//
+// using PainterVariant = mode_variant<AsciiPainterT, decltype(dashed|arrows), decltype(dotted)>;
+// PainterVariant v(arrows|dashed); // the alternative for dashed|arrows
+// v.visit(DrawLine{}); // DrawLine::operator() is a template, called with an AsciiPainterT<decltype(dotted)>&
+//
+// space_variant_t<Impl, Space> is a mode_variant over every PackedModes of
+// /Space/, for which index() is the packed key. It is constructed from any
+// mode expression of /Space/, as mode_holder is.
+//
+// Every alternative must be nothrow move constructible.
+
+namespace detail {
+
+template<std::size_t I, typename... Ts>
+struct type_at_;
+
+template<typename T, typename... Ts>
+struct type_at_<0, T, Ts...> { using type = T; };
+
+template<std::size_t I, typename T, typename... Ts>
+struct type_at_<I, T, Ts...> : type_at_<I - 1, Ts...> {};
+
+// same_combination_<ModeExpr, Alternative>::value is true if /ModeExpr/
+// selects mode_variant alternative /Alternative/: the same modes in any
+// order, or, for a PackedModes alternative, the same normalized modes
+// (so that defaults may be omitted).
+
+template<typename T>
+struct as_mode_set_ { using type = T; };
+
+template<typename T, T X>
+struct as_mode_set_<Mode<T, X> > { using type = ModeSet<Mode<T, X> >; };
+
+template<typename A, typename B>
+struct same_mode_set_ : std::is_same<A, B> {};
+
+template<typename... As, typename... Bs>
+struct same_mode_set_<ModeSet<As...>, ModeSet<Bs...> > : std::integral_constant<bool,
+    sizeof...(As) == sizeof...(Bs) && and_<has_type_no_cv<As, type_pack<Bs...> >...>::value> {};
+
+template<typename ModeExpr, typename Alternative>
+struct same_combination_
+    : same_mode_set_<typename as_mode_set_<ModeExpr>::type, typename as_mode_set_<Alternative>::type> {};
+
+template<typename ModeExpr, typename Space, std::size_t Key>
+struct same_combination_<ModeExpr, PackedModes<Space, Key> >
+    : std::is_same<compact_t<Space, ModeExpr>, PackedModes<Space, Key> > {};
+
+// index_of_combination_<ModeExpr, Ts...>::value is the index of the first
+// /Ts/ that /ModeExpr/ selects, or sizeof...(Ts) if there is none
+
+template<typename ModeExpr, typename... Ts>
+struct index_of_combination_ : std::integral_constant<std::size_t, 0> {};
+
+template<typename ModeExpr, typename T, typename... Ts>
+struct index_of_combination_<ModeExpr, T, Ts...> : std::integral_constant<std::size_t,
+    same_combination_<ModeExpr, T>::value ? 0 : 1 + index_of_combination_<ModeExpr, Ts...>::value> {};
+
+// visitors used to implement mode_variant's special member functions
+
+template<typename Variant, typename Storage>
+struct variant_copy_ {
+    Storage *dst;
+    const Storage *src;
+
+    template<std::size_t I>
+    void operator()(std::integral_constant<std::size_t, I>) const {
+        using T = typename Variant::template alternative_t<I>;
+        ::new (static_cast<void*>(dst)) T(*reinterpret_cast<const T*>(src));
+    }
+};
+
+template<typename Variant, typename Storage>
+struct variant_move_ {
+    Storage *dst;
+    Storage *src;
+
+    template<std::size_t I>
+    void operator()(std::integral_constant<std::size_t, I>) const {
+        using T = typename Variant::template alternative_t<I>;
+        ::new (static_cast<void*>(dst)) T(std::move(*reinterpret_cast<T*>(src)));
+    }
+};
+
+template<typename Variant, typename Storage>
+struct variant_destroy_ {
+    Storage *p;
+
+    template<std::size_t I>
+    void operator()(std::integral_constant<std::size_t, I>) const {
+        using T = typename Variant::template alternative_t<I>;
+        reinterpret_cast<T*>(p)->~T();
+    }
+};
+
+template<typename Variant, typename Storage>
+struct variant_construct_ {
+    Storage *p;
+
+    template<std::size_t I>
+    void operator()(std::integral_constant<std::size_t, I>) const {
+        using T = typename Variant::template alternative_t<I>;
+        ::new (static_cast<void*>(p)) T();
+    }
+};
+
+template<typename T, typename Storage, typename F, typename R>
+struct variant_visit_ {
+    Storage *p;
+    F& f;
+
+    template<std::size_t I>
+    R operator()(std::integral_constant<std::size_t, I>) const {
+        using alternative_t = typename T::template alternative_t<I>;
+        using pointer_t = typename std::conditional<std::is_const<Storage>::value,
+            const alternative_t*, alternative_t*>::type;
+        return f(*reinterpret_cast<pointer_t>(p));
+    }
+};
+
+} // end namespace detail
+
+template<template<typename> class Impl, typename... Combinations>
+class mode_variant {
+    static_assert(sizeof...(Combinations) > 0, "mode_variant requires at least one combination.");
+    static_assert(sizeof...(Combinations) <= 0xFFFF, "Too many combinations.");
+    static_assert(detail::and_<std::is_nothrow_move_constructible<Impl<detail::remove_cv_t_<Combinations> > >...>::value,
+        "Every alternative must be nothrow move constructible.");
+
+public:
+    static constexpr std::size_t size = sizeof...(Combinations);
+
+    using index_type = detail::small_index_t_<size>;
+
+    // alternative_t<I> is the type of alternative /I/
+    template<std::size_t I>
+    using alternative_t = Impl<detail::remove_cv_t_<typename detail::type_at_<I, Combinations...>::type> >;
+
+    // index_of<ModeExpr>::value is the index of the alternative for /ModeExpr/:
+    // the combination with the same modes, in any order. For PackedModes
+    // combinations (e.g. space_variant_t), the combination that /ModeExpr/
+    // normalizes to, so modes with default values may be omitted.
+    template<typename ModeExpr>
+    struct index_of : detail::index_of_combination_<detail::remove_cv_t_<ModeExpr>, detail::remove_cv_t_<Combinations>...> {
+        static_assert(index_of::value < size,
+            "/ModeExpr/ is not one of this mode_variant's combinations.");
+    };
+
+private:
+    using storage_type = typename std::aligned_storage<
+        detail::max_(sizeof(Impl<detail::remove_cv_t_<Combinations> >)...),
+        detail::max_(alignof(Impl<detail::remove_cv_t_<Combinations> >)...)>::type;
+
+    template<typename T, typename R, typename F, typename Storage>
+    static R visit_(std::size_t index, Storage *p, F& f) {
+        detail::variant_visit_<T, Storage, F, R> g = { p, f };
+        return detail::dense_switch_<R, size>::call(index, g);
+    }
+
+    template<typename G>
+    void apply_(G g) { detail::dense_switch_<void, size>::call(index_, g); }
+
+public:
+    // holds alternative 0
+    mode_variant() : index_(0) { ::new (static_cast<void*>(&storage_)) alternative_t<0>(); }
+
+    // holds the alternative for /ModeExpr/
+    template<typename ModeExpr, typename std::enable_if<is_mode_expr<ModeExpr>::value, int>::type = 0>
+    explicit mode_variant(ModeExpr) : index_(static_cast<index_type>(index_of<ModeExpr>::value)) {
+        ::new (static_cast<void*>(&storage_)) alternative_t<index_of<ModeExpr>::value>();
+    }
+
+    // from_index(i) returns a variant holding a default-constructed alternative /i/. /i/ must be < size.
+    static mode_variant from_index(std::size_t i) {
+        assert(i < size);
+        return mode_variant(i, 0);
+    }
+
+    mode_variant(const mode_variant& rhs) : index_(rhs.index_) {
+        apply_(detail::variant_copy_<mode_variant, storage_type>{ &storage_, &rhs.storage_ });
+    }
+
+    mode_variant(mode_variant&& rhs) noexcept : index_(rhs.index_) {
+        apply_(detail::variant_move_<mode_variant, storage_type>{ &storage_, &rhs.storage_ });
+    }
+
+    ~mode_variant() { apply_(detail::variant_destroy_<mode_variant, storage_type>{ &storage_ }); }
+
+    mode_variant& operator=(const mode_variant& rhs) {
+        if (this != &rhs) {
+            mode_variant temp(rhs);
+            *this = std::move(temp);
+        }
+        return *this;
+    }
+
+    mode_variant& operator=(mode_variant&& rhs) noexcept {
+        if (this != &rhs) {
+            apply_(detail::variant_destroy_<mode_variant, storage_type>{ &storage_ });
+            index_ = rhs.index_;
+            apply_(detail::variant_move_<mode_variant, storage_type>{ &storage_, &rhs.storage_ });
+        }
+        return *this;
+    }
+
+    std::size_t index() const noexcept { return index_; }
+
+    // visit(f) calls f(alternative) with the held alternative's concrete type.
+    // All calls must return the same type.
+    template<typename F>
+    auto visit(F&& f) -> decltype(f(std::declval<alternative_t<0>&>())) {
+        return visit_<mode_variant, decltype(f(std::declval<alternative_t<0>&>()))>(index_, &storage_, f);
+    }
+
+    template<typename F>
+    auto visit(F&& f) const -> decltype(f(std::declval<const alternative_t<0>&>())) {
+        return visit_<mode_variant, decltype(f(std::declval<const alternative_t<0>&>()))>(index_, &storage_, f);
+    }
+
+private:
+    mode_variant(std::size_t i, int) : index_(static_cast<index_type>(i)) {
+        apply_(detail::variant_construct_<mode_variant, storage_type>{ &storage_ });
+    }
+
+    index_type index_;
+    storage_type storage_;
+};
+
+template<template<typename> class Impl, typename... Combinations>
+constexpr std::size_t mode_variant<Impl, Combinations...>::size;
+
+// visit(f, v) is equivalent to v.visit(f)
+
+template<typename F, template<typename> class Impl, typename... Combinations>
+auto visit(F&& f, mode_variant<Impl, Combinations...>& v) -> decltype(v.visit(std::forward<F>(f))) {
+    return v.visit(std::forward<F>(f));
+}
+
+template<typename F, template<typename> class Impl, typename... Combinations>
+auto visit(F&& f, const mode_variant<Impl, Combinations...>& v) -> decltype(v.visit(std::forward<F>(f))) {
+    return v.visit(std::forward<F>(f));
+}
+
+namespace detail {
+
+template<template<typename> class Impl, typename Space, typename Keys = typename make_index_sequence_<Space::size>::type>
+struct space_variant_;
+
+template<template<typename> class Impl, typename Space, std::size_t... Ks>
+struct space_variant_<Impl, Space, index_sequence_<Ks...> > {
+    using type = mode_variant<Impl, PackedModes<Space, Ks>...>;
+};
+
+} // end namespace detail
+
+template<template<typename> class Impl, typename Space>
+using space_variant_t = typename detail::space_variant_<Impl, Space>::type;
+
+///////////////////////////////////////////////////////////////////////////////
+// mode_collection<Impl, Space> is a segmented container, in the style of
+// boost::poly_collection, for objects of the types Impl<PackedModes<Space, K>>.
+// Objects of each type are stored contiguously in their own segment (a
+// std::vector), in insertion order. There is no base class, no vtable and no
+// per-object allocation.
+//
+// for_each(f) visits the segments in key order, calling a function object
+// /f/ whose operator() is a template with each object's concrete type. Each
+// call is statically resolved, so it can be inlined, and one segment is a
+// single loop over contiguous storage.
+//
+// example usage:
+//
+// mode_collection<AsciiPainterT, PainterModes> painters;
+// painters.emplace(dashed|arrows);                     // an AsciiPainterT<compact_t<PainterModes, decltype(dashed|arrows)>>
+// painters.emplace_key(PainterModes::key(config.lineStyle, config.endStyle)); // from runtime values
+// painters.for_each(DrawLine{});                       // DrawLine::operator() is a template
+//
+// Pointers and references to elements are invalidated when their segment
+// grows, as for std::vector.
+
+template<template<typename> class Impl, typename Space,
+    typename Keys = typename detail::make_index_sequence_<Space::size>::type>
+class mode_collection;
+
+template<template<typename> class Impl, typename Space, std::size_t... Ks>
+class mode_collection<Impl, Space, detail::index_sequence_<Ks...> > {
+public:
+    using space_type = Space;
+
+    // impl_t<ModeExpr> is the stored type for mode expression /ModeExpr/
+    template<typename ModeExpr>
+    using impl_t = Impl<compact_t<Space, ModeExpr> >;
+
+    // segment_t<K> is the segment for packed key /K/
+    template<std::size_t K>
+    using segment_t = std::vector<Impl<PackedModes<Space, K> > >;
+
+    template<std::size_t K>
+    segment_t<K>& segment() noexcept { return std::get<K>(segments_); }
+
+    template<std::size_t K>
+    const segment_t<K>& segment() const noexcept { return std::get<K>(segments_); }
+
+    // append an impl_t<ModeExpr> constructed from /args/ to its segment
+    template<typename ModeExpr, typename... Args, typename std::enable_if<is_mode_expr<ModeExpr>::value, int>::type = 0>
+    impl_t<ModeExpr>& emplace(ModeExpr, Args&&... args) {
+        segment_t<packed_key<Space, ModeExpr>::value>& s = segment<packed_key<Space, ModeExpr>::value>();
+        s.emplace_back(std::forward<Args>(args)...);
+        return s.back();
+    }
+
+    // append an Impl<PackedModes<Space, key>> constructed from /args/ for
+    // runtime packed key /key/. /key/ must be valid. Impl must be
+    // constructible from /args/ for every key.
+    template<typename... Args>
+    void emplace_key(std::size_t key, Args&&... args) {
+        assert(key < Space::size);
+        detail::method_table_<Space, emplace_method_<Args...> >::functions[key](*this, std::forward<Args>(args)...);
+    }
+
+    // insert a copy (or move) of /x/ into its segment
+    template<std::size_t K>
+    void insert(const Impl<PackedModes<Space, K> >& x) { segment<K>().push_back(x); }
+
+    template<std::size_t K>
+    void insert(Impl<PackedModes<Space, K> >&& x) { segment<K>().push_back(std::move(x)); }
+
+    // total number of objects
+    std::size_t size() const noexcept {
+        const std::size_t sizes[] = { segment<Ks>().size()... };
+        std::size_t result = 0;
+        for (std::size_t n : sizes)
+            result += n;
+        return result;
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+
+    void clear() noexcept {
+        const int expand[] = { (segment<Ks>().clear(), 0)... };
+        (void)expand;
+    }
+
+    // call f(x) for each object /x/, segment by segment in key order
+    template<typename F>
+    void for_each(F&& f) {
+        const int expand[] = { (for_each_in_<Ks>(*this, f), 0)... };
+        (void)expand;
+    }
+
+    template<typename F>
+    void for_each(F&& f) const {
+        const int expand[] = { (for_each_in_<Ks>(*this, f), 0)... };
+        (void)expand;
+    }
+
+private:
+    // the Method of emplace_key()'s method_table_
+    template<typename... Args>
+    struct emplace_method_ {
+        template<typename ModeExpr>
+        static void apply(mode_collection& c, Args&&... args) {
+            c.segment<ModeExpr::key>().emplace_back(std::forward<Args>(args)...);
+        }
+    };
+
+    template<std::size_t K, typename Collection, typename F>
+    static void for_each_in_(Collection& c, F& f) {
+        for (auto& x : c.template segment<K>())
+            f(x);
+    }
+
+    std::tuple<segment_t<Ks>...> segments_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// mode_keyed<Derived, Space> is a CRTP base class for objects that store
+// their packed mode key in a uint8_t (or uint16_t for spaces with more than
+// 256 keys) instead of a vtable pointer. Member functions dispatch through a
+// per-class constexpr table of function pointers indexed by the key, so
+// dispatch stays O(1) while each object is only as large as its data plus
+// the key.
+//
+// Each dispatched member function is a /Method/ struct with a static member
+// function template
+//
+//   template<typename ModeExpr> static R apply(Derived& self, Args... args);
+//
+// example usage:
+//
+// class KeyedPainter : public mode_keyed<KeyedPainter, PainterModes> {
+//     struct RenderLine {
+//         template<typename ModeExpr>
+//         static std::size_t apply(KeyedPainter& self, char *out) { ... }
+//     };
+// public:
+//     explicit KeyedPainter(std::size_t key) : mode_keyed(key) {}
+//     std::size_t renderLine(char *out) { return dispatch<RenderLine>(out); }
+// };
+//
+// sizeof(KeyedPainter) == 1, whereas a class with virtual functions is at
+// least the size of a pointer.
+
+template<typename Derived, typename Space>
+class mode_keyed {
+public:
+    using space_type = Space;
+    using key_type = detail::small_index_t_<Space::size>;
+
+    static_assert(Space::size <= 0x10000, "Too many combinations: the key must fit in key_type.");
+
+    // the packed key of this object's modes
+    std::size_t mode_key() const noexcept { return key_; }
+
+    // whether /key/ is a valid key of /Space/. Check keys from outside the
+    // program (e.g. Space::key() of configuration values, which is
+    // Space::size for an unlisted value) before constructing an object.
+    static constexpr bool valid_key(std::size_t key) noexcept { return key < Space::size; }
+
+protected:
+    // /key/ must be a valid key of /Space/ (see valid_key())
+    explicit mode_keyed(std::size_t key) noexcept : key_(static_cast<key_type>(key)) { assert(key < Space::size); }
+
+    // construct with the key of mode expression /modes/
+    template<typename ModeExpr, typename std::enable_if<is_mode_expr<ModeExpr>::value, int>::type = 0>
+    explicit mode_keyed(ModeExpr) noexcept : key_(static_cast<key_type>(packed_key<Space, ModeExpr>::value)) {}
+
+    // change this object's modes (the derived object's data is unaffected)
+    void set_mode_key(std::size_t key) noexcept { assert(key < Space::size); key_ = static_cast<key_type>(key); }
+
+    // set_mode_key(key) if /key/ is valid, otherwise leave the modes unchanged and return false
+    bool try_set_mode_key(std::size_t key) noexcept {
+        if (!valid_key(key))
+            return false;
+        key_ = static_cast<key_type>(key);
+        return true;
+    }
+
+    // dispatch<Method>(args...) calls Method::apply<PackedModes<Space, mode_key()>>(derived, args...)
+    template<typename Method, typename... Args>
+    auto dispatch(Args&&... args)
+        -> decltype(detail::method_table_<Space, Method>::functions[0](std::declval<Derived&>(), std::forward<Args>(args)...))
+    {
+        return detail::method_table_<Space, Method>::functions[key_](static_cast<Derived&>(*this), std::forward<Args>(args)...);
+    }
+
+    template<typename Method, typename... Args>
+    auto dispatch(Args&&... args) const
+        -> decltype(detail::method_table_<Space, Method>::functions[0](std::declval<const Derived&>(), std::forward<Args>(args)...))
+    {
+        return detail::method_table_<Space, Method>::functions[key_](static_cast<const Derived&>(*this), std::forward<Args>(args)...);
+    }
+
+private:
+    key_type key_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // end namespace staticmode
+
+#endif /* INCLUDED_STATICMODEERASURE_H */
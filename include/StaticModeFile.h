@@ -0,0 +1,83 @@
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef INCLUDED_STATICMODEFILE_H
+#define INCLUDED_STATICMODEFILE_H
+
+#include <atomic>
+#include <cstdio> // rename, remove
+#include <sstream>
+#include <string>
+
+#if defined(_WIN32)
+#include <process.h> // _getpid
+
+// MoveFileExA, declared here rather than by including <windows.h>, which
+// would give every includer the min/max macros and the whole Win32 API.
+// The declaration matches the one in <winbase.h> (BOOL WINAPI MoveFileExA(
+// LPCSTR, LPCSTR, DWORD)), so the two can be seen together.
+extern "C" __declspec(dllimport) int __stdcall MoveFileExA(const char *existingFileName,
+    const char *newFileName, unsigned long flags);
+#else
+#include <unistd.h> // getpid
+#endif
+
+// Internal file helpers shared by StaticModeTune.h and StaticModeInstrument.h.
+// Both write a new file under a temporary name and then rename it over the
+// destination, so readers never see a partial file.
+//
+// replace_file_(temp, path) renames /temp/ over /path/. std::rename fails on
+// Windows if /path/ exists, so MoveFileExA is used there instead. On
+// failure /temp/ is removed and false is returned.
+
+namespace staticmode {
+namespace detail {
+
+// a temporary file name next to /path/, unique to this process and call
+inline std::string temp_file_name_(const std::string& path) {
+    static std::atomic<unsigned> counter(0);
+#if defined(_WIN32)
+    const long pid = static_cast<long>(::_getpid());
+#else
+    const long pid = static_cast<long>(::getpid());
+#endif
+    std::ostringstream name;
+    name << path << ".tmp." << pid << '.' << counter.fetch_add(1, std::memory_order_relaxed);
+    return name.str();
+}
+
+inline bool replace_file_(const std::string& temp, const std::string& path) {
+#if defined(_WIN32)
+    const unsigned long moveFileReplaceExisting = 0x1; // MOVEFILE_REPLACE_EXISTING
+    const bool replaced = ::MoveFileExA(temp.c_str(), path.c_str(), moveFileReplaceExisting) != 0;
+#else
+    const bool replaced = std::rename(temp.c_str(), path.c_str()) == 0;
+#endif
+    if (!replaced)
+        std::remove(temp.c_str());
+    return replaced;
+}
+
+} // end namespace detail
+} // end namespace staticmode
+
+#endif /* INCLUDED_STATICMODEFILE_H */
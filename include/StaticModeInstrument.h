@@ -0,0 +1,363 @@
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDED_STATICMODEINSTRUMENT_H
+#define INCLUDED_STATICMODEINSTRUMENT_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <cstdio> // remove
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility> // forward
+#include <vector>
+
+#include "StaticMode.h"
+#include "StaticModeFile.h" // detail::temp_file_name_, detail::replace_file_
+#include "StaticModeIsa.h" // STATICMODE_ISA_X86_GNU_, STATICMODE_ISA_X86_MSVC_
+
+// Dispatch instrumentation: how often each combination of modes runs, and
+// how long each call takes.
+//
+// instrument_t<Kernel, Space, BuildModes> is a kernel (see
+// StaticModeDispatch.h) that counts and times the calls to /Kernel/ per
+// packed key of /Space/, when /BuildModes/ (a mode expression) has the mode
+// instrumented_t. Otherwise, and by default, it is /Kernel/ itself, so the
+// uninstrumented build adds no instructions at all:
+//
+// using BuildModes = decltype(instrumented);   // or uninstrumented, e.g. per build configuration
+// using Resample = instrument_t<ResampleKernel, ResampleModes, BuildModes>;
+//
+// ResampleFunction f = ResampleFunction::try_bind<Resample>(config.interpolation, config.channels);
+// ...
+// dump_dispatch_stats("resample.stats", collect_dispatch_stats<Resample>(), &to_string<ResampleModes>);
+//
+// Each thread counts into its own block of counters, so calls never
+// contend. collect_dispatch_stats() merges the blocks on demand.
+
+namespace staticmode {
+
+// Instrumentation is a mode category
+enum class Instrumentation { off, on };
+
+using Instrumentations = ModeCategory<Instrumentation, Instrumentation::off, Instrumentation::on>;
+
+using uninstrumented_t = Mode<Instrumentation, Instrumentation::off>;
+using instrumented_t = Mode<Instrumentation, Instrumentation::on>;
+
+constexpr uninstrumented_t uninstrumented;
+constexpr instrumented_t instrumented;
+
+///////////////////////////////////////////////////////////////////////////////
+// Clocks: the latency unit. A clock has
+//
+//   static std::uint64_t now() noexcept;   // a timestamp
+//   static const char *unit() noexcept;    // the unit of timestamp differences
+//
+// steady_clock_ticks: std::chrono::steady_clock, in nanoseconds.
+// tsc_ticks: the x86 time stamp counter (rdtsc), in reference cycles. It is
+// cheaper to read than steady_clock, but isn't serializing: very short calls
+// are measured imprecisely. On other targets it is steady_clock_ticks.
+
+struct steady_clock_ticks {
+    static std::uint64_t now() noexcept {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+    static const char *unit() noexcept { return "ns"; }
+};
+
+#if defined(STATICMODE_ISA_X86_GNU_) || defined(STATICMODE_ISA_X86_MSVC_)
+struct tsc_ticks {
+    static std::uint64_t now() noexcept {
+#if defined(STATICMODE_ISA_X86_GNU_)
+        return __builtin_ia32_rdtsc();
+#else
+        return __rdtsc();
+#endif
+    }
+    static const char *unit() noexcept { return "cycles"; }
+};
+#else
+struct tsc_ticks : steady_clock_ticks {};
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Merged statistics
+//
+// Latencies are counted in a log2 histogram: bucket 0 counts latencies of
+// 0, and bucket b > 0 counts latencies in [2^(b-1), 2^b).
+
+constexpr std::size_t dispatch_histogram_size = 65;
+
+struct dispatch_key_stats {
+    std::size_t key;
+    std::uint64_t calls;
+    std::uint64_t total;    // sum of latencies
+    std::uint64_t max;      // largest latency
+    std::uint64_t histogram[dispatch_histogram_size];
+};
+
+struct dispatch_stats {
+    const char *unit;                       // the clock's unit, or "" if not instrumented
+    std::vector<dispatch_key_stats> keys;   // indexed by key; empty if not instrumented
+};
+
+// the upper bound of the bucket that holds the /p/-th percentile (0 < p <= 100) latency
+inline std::uint64_t dispatch_percentile(const dispatch_key_stats& s, double p) noexcept {
+    const double target = static_cast<double>(s.calls) * p / 100.;
+    std::uint64_t count = 0;
+    for (std::size_t b = 0; b < dispatch_histogram_size; ++b) {
+        count += s.histogram[b];
+        if (count > 0 && static_cast<double>(count) >= target)
+            return (b == 0) ? 0 : (b == 64) ? ~std::uint64_t(0) : (std::uint64_t(1) << b) - 1;
+    }
+    return s.max;
+}
+
+namespace detail {
+
+// the number of significant bits of /x/: its histogram bucket
+inline std::size_t bit_length_(std::uint64_t x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    return (x == 0) ? 0 : static_cast<std::size_t>(64 - __builtin_clzll(x));
+#else
+    std::size_t n = 0;
+    for (; x != 0; x >>= 1)
+        ++n;
+    return n;
+#endif
+}
+
+// The counters of one key in one thread. Only the owning thread writes
+// them, with relaxed loads and stores (no read-modify-write), so that
+// collect_dispatch_stats() can read them from another thread without a data
+// race, and counting costs the same as with plain integers.
+
+struct dispatch_counters_ {
+    std::atomic<std::uint64_t> calls;
+    std::atomic<std::uint64_t> total;
+    std::atomic<std::uint64_t> max;
+    std::atomic<std::uint64_t> histogram[dispatch_histogram_size];
+};
+
+inline void add_relaxed_(std::atomic<std::uint64_t>& a, std::uint64_t x) noexcept {
+    a.store(a.load(std::memory_order_relaxed) + x, std::memory_order_relaxed);
+}
+
+inline void count_call_(dispatch_counters_& c, std::uint64_t latency) noexcept {
+    add_relaxed_(c.calls, 1);
+    add_relaxed_(c.total, latency);
+    if (latency > c.max.load(std::memory_order_relaxed))
+        c.max.store(latency, std::memory_order_relaxed);
+    add_relaxed_(c.histogram[bit_length_(latency)], 1);
+}
+
+// The blocks of counters of every thread that has called an instrumented
+// kernel. A block is allocated on a thread's first call and is never freed,
+// so the counts of threads that have exited are kept.
+
+struct dispatch_registry_ {
+    std::mutex mutex;
+    std::vector<dispatch_counters_*> blocks;
+};
+
+template<typename Kernel, typename Space, typename Clock,
+    typename Function = decltype(&Kernel::template apply<PackedModes<Space, 0> >)>
+struct instrumented_kernel_;
+
+template<typename Kernel, typename Space, typename Clock, typename R, typename... Args>
+struct instrumented_kernel_<Kernel, Space, Clock, R (*)(Args...)> {
+    using kernel_type = Kernel;
+    using space_type = Space;
+    using clock_type = Clock;
+
+    // never destroyed, so that it outlives every thread
+    static dispatch_registry_& registry() {
+        static dispatch_registry_ *r = new dispatch_registry_;
+        return *r;
+    }
+
+    // this thread's block: Space::size counters
+    static dispatch_counters_ *counters() {
+        static thread_local dispatch_counters_ *block = nullptr;
+        if (!block) {
+            dispatch_counters_ *b = new dispatch_counters_[Space::size];
+            for (std::size_t key = 0; key < Space::size; ++key) {
+                b[key].calls.store(0, std::memory_order_relaxed);
+                b[key].total.store(0, std::memory_order_relaxed);
+                b[key].max.store(0, std::memory_order_relaxed);
+                for (std::atomic<std::uint64_t>& h : b[key].histogram)
+                    h.store(0, std::memory_order_relaxed);
+            }
+            dispatch_registry_& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.blocks.push_back(b);
+            block = b;
+        }
+        return block;
+    }
+
+    // counts the call when it returns or throws
+    struct timer_ {
+        dispatch_counters_& counters;
+        std::uint64_t start;
+
+        ~timer_() { count_call_(counters, Clock::now() - start); }
+    };
+
+    template<typename ModeExpr>
+    static R apply(Args... args) {
+        timer_ t = { counters()[packed_key<Space, ModeExpr>::value], Clock::now() };
+        return Kernel::template apply<ModeExpr>(std::forward<Args>(args)...);
+    }
+};
+
+template<typename Kernel>
+struct dispatch_stats_of_ {
+    static dispatch_stats collect() {
+        dispatch_stats result = { "", std::vector<dispatch_key_stats>() };
+        return result;
+    }
+};
+
+template<typename Kernel, typename Space, typename Clock, typename Function>
+struct dispatch_stats_of_<instrumented_kernel_<Kernel, Space, Clock, Function> > {
+    static dispatch_stats collect() {
+        dispatch_stats result = { Clock::unit(), std::vector<dispatch_key_stats>(Space::size) };
+        for (std::size_t key = 0; key < Space::size; ++key) {
+            dispatch_key_stats& s = result.keys[key];
+            s = dispatch_key_stats();
+            s.key = key;
+        }
+
+        dispatch_registry_& r = instrumented_kernel_<Kernel, Space, Clock, Function>::registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (const dispatch_counters_ *block : r.blocks) {
+            for (std::size_t key = 0; key < Space::size; ++key) {
+                const dispatch_counters_& c = block[key];
+                dispatch_key_stats& s = result.keys[key];
+                s.calls += c.calls.load(std::memory_order_relaxed);
+                s.total += c.total.load(std::memory_order_relaxed);
+                const std::uint64_t max = c.max.load(std::memory_order_relaxed);
+                if (max > s.max)
+                    s.max = max;
+                for (std::size_t b = 0; b < dispatch_histogram_size; ++b)
+                    s.histogram[b] += c.histogram[b].load(std::memory_order_relaxed);
+            }
+        }
+        return result;
+    }
+};
+
+} // end namespace detail
+
+///////////////////////////////////////////////////////////////////////////////
+// instrument_t<Kernel, Space, BuildModes, Clock> is /Kernel/ if /BuildModes/
+// doesn't have the mode instrumented_t, otherwise a kernel that forwards to
+// /Kernel/ and counts each call, and its latency measured with /Clock/, per
+// packed key of /Space/. Its apply<> has the same signature as /Kernel/'s.
+//
+// The first call on each thread allocates that thread's counters (about 550
+// bytes per key of /Space/), which are kept for the life of the process.
+// Later calls don't allocate, lock or contend.
+
+template<typename Kernel, typename Space, typename BuildModes = uninstrumented_t, typename Clock = steady_clock_ticks>
+using instrument_t = typename std::conditional<
+    get_mode_t<Instrumentation, BuildModes, uninstrumented_t>::value == Instrumentation::on,
+    detail::instrumented_kernel_<Kernel, Space, Clock>, Kernel>::type;
+
+// collect_dispatch_stats<K>() merges the counters of every thread for
+// instrumented kernel /K/ (an instrument_t). If /K/ is not instrumented, the
+// result has no keys. Counts taken while other threads are calling /K/ are
+// approximate: a concurrent call may be partly counted.
+
+template<typename InstrumentedKernel>
+dispatch_stats collect_dispatch_stats() {
+    return detail::dispatch_stats_of_<InstrumentedKernel>::collect();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Reports
+//
+// write_dispatch_stats(os, stats, describe) writes a plain text report: a
+// line per combination that was called, and a line with its non-empty
+// histogram buckets, each as <upper bound>:<count>. /describe/ formats a key
+// for the "modes" field, e.g. &to_string<ResampleModes> (see
+// StaticModeNames.h). If it is null, the field is "-".
+//
+//   # staticmode dispatch stats
+//   # unit ns
+//   # combination <key> <calls> <total> <mean> <max> <modes>
+//   combination 5 1200 4567800 3806.5 12000 interpolation=cubic,channels=stereo
+//   histogram 5 2047:17 4095:900 8191:280 16383:3
+//
+// dump_dispatch_stats(file, stats, describe) writes the report to a new file,
+// named uniquely per process and call, then replaces /file/ with it, so
+// concurrent dumps to the same /file/ never mix. Returns false if the file
+// can't be written.
+
+inline void write_dispatch_stats(std::ostream& os, const dispatch_stats& stats,
+        std::string (*describe)(std::size_t) = nullptr) {
+    os << "# staticmode dispatch stats\n";
+    os << "# unit " << stats.unit << '\n';
+    os << "# combination <key> <calls> <total> <mean> <max> <modes>\n";
+    for (const dispatch_key_stats& s : stats.keys) {
+        if (s.calls == 0)
+            continue;
+        std::string modes = describe ? describe(s.key) : std::string();
+        os << "combination " << s.key << ' ' << s.calls << ' ' << s.total << ' '
+            << static_cast<double>(s.total) / static_cast<double>(s.calls) << ' ' << s.max << ' '
+            << (modes.empty() ? std::string("-") : modes) << '\n';
+        os << "histogram " << s.key;
+        for (std::size_t b = 0; b < dispatch_histogram_size; ++b) {
+            if (s.histogram[b] != 0) {
+                const std::uint64_t upper = (b == 0) ? 0 : (b == 64) ? ~std::uint64_t(0) : (std::uint64_t(1) << b) - 1;
+                os << ' ' << upper << ':' << s.histogram[b];
+            }
+        }
+        os << '\n';
+    }
+}
+
+inline bool dump_dispatch_stats(const std::string& file, const dispatch_stats& stats,
+        std::string (*describe)(std::size_t) = nullptr) {
+    const std::string temp = detail::temp_file_name_(file);
+    std::ofstream out(temp.c_str(), std::ios::trunc);
+    write_dispatch_stats(out, stats, describe);
+    out.close();
+    if (!out) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return detail::replace_file_(temp, file);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // end namespace staticmode
+
+#endif /* INCLUDED_STATICMODEINSTRUMENT_H */
@@ -0,0 +1,216 @@
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDED_STATICMODEISA_H
+#define INCLUDED_STATICMODEISA_H
+
+#include <cstdlib> // getenv
+#include <cstring> // strcmp
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#define STATICMODE_ISA_X86_GNU_ 1
+#elif (defined(_M_X64) || defined(_M_IX86)) && defined(_MSC_VER)
+#include <intrin.h>
+#define STATICMODE_ISA_X86_MSVC_ 1
+#endif
+
+#include "StaticMode.h"
+
+// STATICMODE_ISA_NS is a namespace name unique to the level (e.g. isa_avx2).
+// staticmode_isa_objects() defines it; otherwise it is derived from
+// STATICMODE_ISA.
+#ifdef STATICMODE_ISA
+#ifndef STATICMODE_ISA_NS
+#define STATICMODE_ISA_CONCAT2_(a, b) a ## b
+#define STATICMODE_ISA_CONCAT_(a, b) STATICMODE_ISA_CONCAT2_(a, b)
+#define STATICMODE_ISA_NS STATICMODE_ISA_CONCAT_(isa_, STATICMODE_ISA)
+#endif
+#define STATICMODE_ISA_NAMESPACE_BEGIN namespace STATICMODE_ISA_NS {
+#define STATICMODE_ISA_NAMESPACE_END }
+#endif
+
+// The SIMD instruction set level as a mode category.
+//
+// Kernels are overloaded on Mode<Isa, Isa::...>, with each overload compiled
+// for its instruction set, usually by compiling the same source file once per
+// level (see staticmode_isa_objects() in cmake/StaticModeIsa.cmake), or with
+// __attribute__((target("avx2"))). At startup, runtime_isa() detects the best
+// level that the CPU and OS support, once, and a mode_function (or any other
+// runtime-to-static dispatcher) is bound to that level:
+//
+// // kernels.h
+// float sum(Mode<Isa, Isa::scalar>, const float *x, std::size_t n); // defined in kernels.cpp, compiled per level
+// float sum(Mode<Isa, Isa::sse2>, const float *x, std::size_t n);
+// float sum(Mode<Isa, Isa::avx2>, const float *x, std::size_t n);
+// float sum(Mode<Isa, Isa::avx512>, const float *x, std::size_t n);
+//
+// struct SumKernel {
+//     template<typename ModeExpr>
+//     static float apply(const float *x, std::size_t n) { return sum(get_mode_t<Isa, ModeExpr, Mode<Isa, Isa::scalar> >{}, x, n); }
+// };
+//
+// // kernels.cpp, compiled once per level with -DSTATICMODE_ISA=<level>
+// STATICMODE_ISA_NAMESPACE_BEGIN
+// template<typename T> T accumulate(const T *x, std::size_t n) { ... }
+// STATICMODE_ISA_NAMESPACE_END
+//
+// float sum(compiled_isa_t, const float *x, std::size_t n) { return STATICMODE_ISA_NS::accumulate(x, n); }
+//
+// A source that is compiled once per level must not define inline functions
+// or templates with external linkage outside STATICMODE_ISA_NAMESPACE_BEGIN /
+// END (a namespace per level) or an anonymous namespace. Each object would
+// emit its own copy, compiled for its level, and the linker would keep only
+// one of them: possibly the avx512 copy, on every CPU. The same applies to
+// inline functions of other headers (including the standard library) that
+// are instantiated with the same arguments at several levels. Keep per-level
+// sources to loops, intrinsics and per-level helpers.
+//
+// // startup
+// using SumFunction = mode_function<float(const float*, std::size_t), Isas>;
+// SumFunction sumFn = SumFunction::bind<SumKernel>(runtime_isa());
+
+namespace staticmode {
+
+// Levels are ordered: each level implies the ones before it.
+enum class Isa { scalar, sse2, avx2, avx512 };
+
+using Isas = ModeCategory<Isa, Isa::scalar, Isa::sse2, Isa::avx2, Isa::avx512>;
+
+#ifdef STATICMODE_ISA
+// compiled_isa_t is the Isa mode that this translation unit is compiled for,
+// when it is compiled with -DSTATICMODE_ISA=<level> (scalar, sse2, avx2 or avx512)
+using compiled_isa_t = Mode<Isa, Isa::STATICMODE_ISA>;
+#endif
+
+namespace detail {
+
+#if defined(STATICMODE_ISA_X86_GNU_) || defined(STATICMODE_ISA_X86_MSVC_)
+
+// cpuid leaf /leaf/, subleaf /subleaf/: regs = { eax, ebx, ecx, edx }
+inline bool cpuid_(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#if defined(STATICMODE_ISA_X86_GNU_)
+    return __get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3]) != 0;
+#else
+    int r[4];
+    __cpuid(r, 0);
+    if (static_cast<unsigned>(r[0]) < leaf)
+        return false;
+    __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i)
+        regs[i] = static_cast<unsigned>(r[i]);
+    return true;
+#endif
+}
+
+// XCR0: the register state that the OS saves on context switch
+inline unsigned long long xcr0_() {
+#if defined(STATICMODE_ISA_X86_GNU_)
+    unsigned eax, edx;
+    __asm__ volatile ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+#else
+    return _xgetbv(0);
+#endif
+}
+
+inline Isa detect_isa_() {
+    unsigned r1[4] = {};
+    if (!cpuid_(1, 0, r1))
+        return Isa::scalar;
+
+    const bool sse2 = (r1[3] >> 26) & 1;
+    if (!sse2)
+        return Isa::scalar;
+
+    // AVX state must be enabled by the OS (OSXSAVE, and XCR0 saves XMM and YMM)
+    const bool osxsave = (r1[2] >> 27) & 1;
+    const bool avx = (r1[2] >> 28) & 1;
+    const bool fma = (r1[2] >> 12) & 1;
+    if (!(osxsave && avx && fma) || (xcr0_() & 0x6) != 0x6)
+        return Isa::sse2;
+
+    unsigned r7[4] = {};
+    if (!cpuid_(7, 0, r7))
+        return Isa::sse2;
+
+    const bool avx2 = (r7[1] >> 5) & 1;
+    if (!avx2)
+        return Isa::sse2;
+
+    // AVX-512: F, plus opmask and ZMM state saved by the OS
+    const bool avx512f = (r7[1] >> 16) & 1;
+    if (!avx512f || (xcr0_() & 0xe6) != 0xe6)
+        return Isa::avx2;
+
+    return Isa::avx512;
+}
+
+#else
+
+inline Isa detect_isa_() { return Isa::scalar; }
+
+#endif
+
+} // end namespace detail
+
+// The best level supported by this CPU and OS. Detected once, on first call.
+inline Isa detected_isa() {
+    static const Isa isa = detail::detect_isa_();
+    return isa;
+}
+
+inline bool isa_supported(Isa isa) { return static_cast<int>(isa) <= static_cast<int>(detected_isa()); }
+
+// parse_isa("avx2", isa) sets /isa/ from a level name, returns false if /s/ isn't a level name
+inline bool parse_isa(const char *s, Isa& isa) {
+    static const char *const names[] = { "scalar", "sse2", "avx2", "avx512" };
+    for (int i = 0; i < 4; ++i) {
+        if (std::strcmp(s, names[i]) == 0) {
+            isa = static_cast<Isa>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// The level to bind kernels to: detected_isa(), lowered to the value of the
+// STATICMODE_ISA environment variable if it is set to a lower level name
+// (e.g. STATICMODE_ISA=sse2, to test or benchmark the fallbacks).
+// Read once, on first call.
+inline Isa runtime_isa() {
+    struct init_ {
+        static Isa get() {
+            Isa isa = detected_isa();
+            const char *limit = std::getenv("STATICMODE_ISA");
+            Isa forced;
+            if (limit && parse_isa(limit, forced) && static_cast<int>(forced) < static_cast<int>(isa))
+                isa = forced;
+            return isa;
+        }
+    };
+    static const Isa isa = init_::get();
+    return isa;
+}
+
+} // end namespace staticmode
+
+#endif /* INCLUDED_STATICMODEISA_H */
@@ -0,0 +1,264 @@
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDED_STATICMODEMANIFEST_H
+#define INCLUDED_STATICMODEMANIFEST_H
+
+#include <algorithm> // find
+#include <cstddef> // size_t
+#include <cstdint> // int32_t, uint32_t, uint64_t
+#include <vector>
+
+#include "StaticMode.h"
+#include "StaticModeNames.h"
+
+// An instantiation manifest: which mode combinations are compiled into a
+// binary, and where their code is.
+//
+// STATICMODE_MANIFEST(Space, ModeExpr); in the body of a function template
+// (typically a kernel's apply<ModeExpr>()) records the combination in the
+// binary: its canonical mode string (the normalized mode set of /Space/, e.g.
+// "line=dashed,end=arrows", see StaticModeNames.h), the string's hash, its
+// packed key, and the address of the code that it was compiled into. Every
+// category of /Space/ must have names (STATICMODE_MODE_NAMES).
+//
+// struct DrawLineKernel {
+//     template<typename ModeExpr>
+//     static void apply(Canvas& c, const Line& l) {
+//         STATICMODE_MANIFEST(PainterModes, ModeExpr);
+//         ...
+//     }
+// };
+//
+// The record is written by the compiler and the linker: the macro adds no
+// instructions, and doesn't stop the compiler from moving or vectorizing the
+// code around it. It works in executables and in shared libraries
+// (position-independent code). Each copy of the function body that the compiler emits
+// (including copies inlined into callers) adds an 8-byte entry to the ELF
+// section "staticmode_manifest". An entry holds the offsets of the record (a
+// constant, one per combination) and of the code. Copies that the linker
+// discards (duplicate template instantiations) take their entries with them,
+// so the section lists what is actually in the binary.
+//
+// tools/manifest-report.py reads the section and the symbol table of a
+// binary, and reports the code size of each combination and of each mode of
+// each category. manifest_records() lists the combinations in the running
+// program.
+//
+// The manifest requires an ELF target and GCC or Clang. Elsewhere, or if
+// STATICMODE_NO_MANIFEST is defined, STATICMODE_MANIFEST() has no effect and
+// manifest_records() returns no records.
+
+#if defined(__ELF__) && (defined(__GNUC__) || defined(__clang__)) && !defined(STATICMODE_NO_MANIFEST)
+#define STATICMODE_MANIFEST_ENABLED 1
+#endif
+
+namespace staticmode {
+
+namespace detail {
+
+// A manifest record, one per combination
+
+constexpr std::uint32_t manifest_magic_ = 0x464d4d53; // "SMMF"
+constexpr std::uint32_t manifest_version_ = 1;
+
+template<std::size_t N>
+struct manifest_record_ {
+    std::uint32_t magic;        // manifest_magic_
+    std::uint32_t version;      // manifest_version_
+    std::uint64_t hash;         // 64-bit FNV-1a hash of /name/ (without the NUL)
+    std::uint32_t key;          // packed key
+    std::uint32_t name_size;    // sizeof(name): the string, a NUL, and padding
+    char name[N];               // the canonical mode string
+};
+
+constexpr std::size_t manifest_name_size_(std::size_t length) noexcept { return (length + 1 + 7) / 8 * 8; }
+
+// An entry of the "staticmode_manifest" section, one per emitted copy of a
+// function that uses STATICMODE_MANIFEST(): offsets from the fields
+// themselves, so that they need no relocation at load time.
+
+struct manifest_section_entry_ {
+    std::int32_t record_offset; // to the manifest_record_
+    std::int32_t code_offset;   // to the code
+};
+
+// manifest_name_<Space, Key, Cats...>: the canonical mode string of key
+// /Key/ of /Space/ (as to_string<Space>(Key)), char by char
+
+template<typename Space, std::size_t Key, typename... Cats>
+struct manifest_name_;
+
+template<typename Space, std::size_t Key>
+struct manifest_name_<Space, Key> {
+    static constexpr std::size_t length = 0;
+    static constexpr char at(std::size_t) noexcept { return '\0'; }
+};
+
+template<typename Space, std::size_t Key, typename Cat, typename... Cats>
+struct manifest_name_<Space, Key, Cat, Cats...> {
+    using value_type = typename Cat::value_type;
+    using rest_type = manifest_name_<Space, Key, Cats...>;
+
+    static constexpr const char *category() noexcept { return ModeNames<value_type>::category(); }
+    static constexpr const char *mode() noexcept {
+        return ModeNames<value_type>::mode(static_cast<std::size_t>(Space::template value<value_type>(Key)));
+    }
+
+    // "category=mode"
+    static constexpr std::size_t own = strlen_(ModeNames<value_type>::category()) + 1
+        + strlen_(ModeNames<value_type>::mode(static_cast<std::size_t>(Space::template value<value_type>(Key))));
+
+    static constexpr std::size_t length = own + ((sizeof...(Cats) == 0) ? 0 : 1 + rest_type::length);
+
+    static constexpr char at(std::size_t i) noexcept {
+        return (i < strlen_(category())) ? category()[i]
+            : (i == strlen_(category())) ? '='
+            : (i < own) ? mode()[i - strlen_(category()) - 1]
+            : (i == own && sizeof...(Cats) != 0) ? ','
+            : (i < length) ? rest_type::at(i - own - 1)
+            : '\0';
+    }
+};
+
+template<typename Space, std::size_t Key, typename Categories>
+struct manifest_space_name_;
+
+template<typename Space, std::size_t Key, typename... Cats>
+struct manifest_space_name_<Space, Key, type_pack<Cats...> > : manifest_name_<Space, Key, Cats...> {};
+
+template<typename Name>
+constexpr std::uint64_t manifest_hash_(std::size_t i = 0, std::uint64_t h = 14695981039346656037ull) noexcept {
+    return (i == Name::length) ? h
+        : manifest_hash_<Name>(i + 1, (h ^ static_cast<unsigned char>(Name::at(i))) * 1099511628211ull);
+}
+
+template<typename Name, std::size_t Key, std::size_t... Is>
+constexpr manifest_record_<sizeof...(Is)> make_manifest_record_(index_sequence_<Is...>) noexcept {
+    return { manifest_magic_, manifest_version_, manifest_hash_<Name>(), static_cast<std::uint32_t>(Key),
+        static_cast<std::uint32_t>(sizeof...(Is)), { Name::at(Is)... } };
+}
+
+// manifest_entry_<Space, ModeExpr>::record is the record of one combination.
+// emit() adds a section entry for the code that it is inlined into.
+//
+// The entry is written with asm directives because GCC ignores section
+// attributes on template instantiations. Pushing the section with the "?"
+// flag puts the entry in the section group (if any) of the function's code,
+// so that the linker keeps or discards them together.
+//
+// The asm has no outputs and no "memory" clobber, so it is not a compiler
+// barrier: code can move across it, and loops around it can be vectorized.
+// (GCC still treats an asm without outputs as volatile, so it is never
+// deleted.) The "i" operand is the record's address as a link-time constant.
+// The record has hidden visibility and the entry holds a PC-relative offset,
+// so this also assembles and links in position-independent code (see
+// StaticModeManifest_shared.cpp).
+
+template<typename Space, typename ModeExpr>
+struct manifest_entry_ {
+    static constexpr std::size_t key = packed_key<Space, ModeExpr>::value;
+    using name_type = manifest_space_name_<Space, key, typename Space::categories>;
+    static constexpr std::size_t name_size = manifest_name_size_(name_type::length);
+    using record_type = manifest_record_<name_size>;
+
+#if defined(STATICMODE_MANIFEST_ENABLED)
+    __attribute__((visibility("hidden"))) static const record_type record;
+
+    __attribute__((always_inline)) static inline void emit() noexcept {
+        __asm__ (
+            ".Lstaticmode_manifest_code%=:\n"
+            ".pushsection staticmode_manifest,\"a?\"\n"
+            ".balign 4\n"
+            ".long %c0 - .\n"
+            ".long .Lstaticmode_manifest_code%= - .\n"
+            ".popsection\n"
+            : : "i"(&record));
+    }
+#else
+    static void emit() noexcept {}
+#endif
+};
+
+#if defined(STATICMODE_MANIFEST_ENABLED)
+template<typename Space, typename ModeExpr>
+const typename manifest_entry_<Space, ModeExpr>::record_type manifest_entry_<Space, ModeExpr>::record =
+    make_manifest_record_<typename manifest_entry_<Space, ModeExpr>::name_type, manifest_entry_<Space, ModeExpr>::key>(
+        typename make_index_sequence_<manifest_entry_<Space, ModeExpr>::name_size>::type());
+#endif
+
+} // end namespace detail
+
+///////////////////////////////////////////////////////////////////////////////
+// STATICMODE_MANIFEST(Space, ModeExpr) records combination /ModeExpr/ of
+// /Space/ in the manifest. Use it as a statement.
+
+#define STATICMODE_MANIFEST(Space, ...) \
+    ::staticmode::detail::manifest_entry_<Space, __VA_ARGS__>::emit()
+
+///////////////////////////////////////////////////////////////////////////////
+// manifest_records() returns the combinations recorded in the running
+// executable (or, when called from a shared library, in that library), one
+// record per combination, in no particular order.
+
+struct manifest_record {
+    const char *name;       // canonical mode string
+    std::uint64_t hash;     // 64-bit FNV-1a hash of /name/
+    std::size_t key;        // packed key
+};
+
+#if defined(STATICMODE_MANIFEST_ENABLED)
+// defined by the linker for sections whose names are C identifiers
+extern "C" const char __start_staticmode_manifest[] __attribute__((weak, visibility("hidden")));
+extern "C" const char __stop_staticmode_manifest[] __attribute__((weak, visibility("hidden")));
+#endif
+
+#if defined(STATICMODE_MANIFEST_ENABLED)
+// hidden, so that each module keeps its own copy: otherwise the dynamic
+// linker would resolve a shared library's calls to the executable's copy
+__attribute__((visibility("hidden")))
+#endif
+inline std::vector<manifest_record> manifest_records() {
+    std::vector<manifest_record> result;
+#if defined(STATICMODE_MANIFEST_ENABLED)
+    using header_type = detail::manifest_record_<8>;
+    std::vector<const header_type*> seen;
+    for (const char *p = __start_staticmode_manifest; p && p < __stop_staticmode_manifest;
+            p += sizeof(detail::manifest_section_entry_)) {
+        const detail::manifest_section_entry_ *entry = reinterpret_cast<const detail::manifest_section_entry_*>(p);
+        const header_type *r = reinterpret_cast<const header_type*>(p + entry->record_offset);
+        if (r->magic != detail::manifest_magic_ || r->version != detail::manifest_version_)
+            continue;
+        if (std::find(seen.begin(), seen.end(), r) != seen.end())
+            continue; // another copy of the same code
+        seen.push_back(r);
+        manifest_record record = { r->name, r->hash, r->key };
+        result.push_back(record);
+    }
+#endif
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // end namespace staticmode
+
+#endif /* INCLUDED_STATICMODEMANIFEST_H */
@@ -0,0 +1,568 @@
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDED_STATICMODENAMES_H
+#define INCLUDED_STATICMODENAMES_H
+
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t
+#include <cstring> // memcmp
+#include <string>
+#include <type_traits>
+
+#include "StaticMode.h"
+
+// Mode names, to_string() and parsing of mode strings.
+//
+// Names are attached to a mode category (enum class) with the
+// STATICMODE_MODE_NAMES macro, which must be used at global namespace scope:
+//
+// STATICMODE_MODE_NAMES(LineStyle, "line", "dotted", "dashed", "solid")
+//
+// The first string names the category. The remaining strings name the modes,
+// in order of the enum's underlying values, starting at 0. Names may not
+// contain ',' or '='.
+//
+// A mode string lists category=mode pairs separated by commas,
+// e.g. "line=dashed,end=arrows".
+
+namespace staticmode {
+
+///////////////////////////////////////////////////////////////////////////////
+// ModeNames<T> holds the names of mode category /T/ (an enum class).
+// Specialize it with STATICMODE_MODE_NAMES, or by hand with members:
+//
+//   static constexpr const char *category() noexcept;     // category name
+//   static constexpr std::size_t size() noexcept;         // number of mode names
+//   static constexpr const char *mode(std::size_t i) noexcept; // name of mode with underlying value i
+
+template<typename T>
+struct ModeNames;
+
+namespace detail {
+
+// ----------------------------------------------------------------------------
+// constexpr string utilities
+
+constexpr std::size_t count_names_() noexcept { return 0; }
+
+template<typename... Ss>
+constexpr std::size_t count_names_(const char *, Ss... ss) noexcept { return 1 + count_names_(ss...); }
+
+constexpr const char *nth_name_(std::size_t) noexcept { return nullptr; }
+
+template<typename... Ss>
+constexpr const char *nth_name_(std::size_t i, const char *s, Ss... ss) noexcept {
+    return (i == 0) ? s : nth_name_(i - 1, ss...);
+}
+
+constexpr std::size_t strlen_(const char *s, std::size_t n = 0) noexcept {
+    return (s[n] == '\0') ? n : strlen_(s, n + 1);
+}
+
+// FNV-1a hash of /n/ chars at /s/, starting from /h/
+constexpr std::uint32_t fnv_hash_(std::uint32_t h, const char *s, std::size_t n) noexcept {
+    return (n == 0) ? h : fnv_hash_((h ^ static_cast<unsigned char>(*s)) * 16777619u, s + 1, n - 1);
+}
+
+// prefix_sample_(s, p) packs the chars of a name at positions p % 8 and
+// p / 8, which must both be less than the name's length
+constexpr std::uint32_t prefix_sample_(const char *s, std::size_t p) noexcept {
+    return static_cast<std::uint32_t>(static_cast<unsigned char>(s[p % 8]))
+        | (static_cast<std::uint32_t>(static_cast<unsigned char>(s[p / 8])) << 8);
+}
+
+// sample_(s, n) packs the length and the first, middle and last chars of a name
+constexpr std::uint32_t sample_(const char *s, std::size_t n) noexcept {
+    return (n == 0) ? 0u : (static_cast<std::uint32_t>(static_cast<unsigned char>(s[0]))
+        | (static_cast<std::uint32_t>(static_cast<unsigned char>(s[n / 2])) << 8)
+        | (static_cast<std::uint32_t>(static_cast<unsigned char>(s[n - 1])) << 16)
+        | (static_cast<std::uint32_t>(n & 0xff) << 24));
+}
+
+// seeded_hash_<Kind>(seed, p, s, n), cheapest first:
+// hash_kind_::prefix: multiplicative hash of prefix_sample_(s, p). Doesn't
+//   depend on /n/, so a name can be looked up before its end is found. Only
+//   usable if all names in a list differ at two positions within the
+//   shortest name.
+// hash_kind_::sampled: multiplicative hash of sample_(s, n). Only usable if
+//   all names in a list have distinct samples.
+// hash_kind_::full: FNV-1a hash of all chars.
+
+enum class hash_kind_ { prefix, sampled, full };
+
+template<hash_kind_ Kind>
+constexpr std::uint32_t seeded_hash_(std::uint32_t seed, std::size_t p, const char *s, std::size_t n) noexcept {
+    return (Kind == hash_kind_::prefix) ? ((prefix_sample_(s, p) * (0x9e3779b1u + 2u * seed)) >> 16)
+        : (Kind == hash_kind_::sampled) ? ((sample_(s, n) * (0x9e3779b1u + 2u * seed)) >> 16)
+        : fnv_hash_(2166136261u ^ (seed * 0x9e3779b9u), s, n);
+}
+
+template<typename U>
+U load_(const char *s) noexcept {
+    U x;
+    std::memcpy(&x, s, sizeof(U));
+    return x;
+}
+
+// equal_(a, b, n) is true if the /n/ chars at /a/ and /b/ are equal. Names up
+// to 16 chars are compared with two overlapping loads, which costs much less
+// than a call to memcmp.
+inline bool equal_(const char *a, const char *b, std::size_t n) noexcept {
+    return (n >= 8) ? ((n <= 16) ? (load_<std::uint64_t>(a) == load_<std::uint64_t>(b)
+                && load_<std::uint64_t>(a + n - 8) == load_<std::uint64_t>(b + n - 8))
+            : std::memcmp(a, b, n) == 0)
+        : (n >= 4) ? (load_<std::uint32_t>(a) == load_<std::uint32_t>(b)
+            && load_<std::uint32_t>(a + n - 4) == load_<std::uint32_t>(b + n - 4))
+        : (n >= 2) ? (load_<std::uint16_t>(a) == load_<std::uint16_t>(b)
+            && load_<std::uint16_t>(a + n - 2) == load_<std::uint16_t>(b + n - 2))
+        : (n == 0 || *a == *b);
+}
+
+constexpr std::size_t next_pow2_(std::size_t x, std::size_t p = 1) noexcept {
+    return (p >= x) ? p : next_pow2_(x, p * 2);
+}
+
+// ----------------------------------------------------------------------------
+// name lists
+//
+// A name list type provides:
+//   static constexpr std::size_t count;
+//   static constexpr const char *names[count];
+//   static constexpr std::size_t lengths[count];
+
+// mode_names_<T>: the mode names of category /T/, indexed by underlying value
+
+template<typename T, typename Is = typename make_index_sequence_<ModeNames<T>::size()>::type>
+struct mode_names_;
+
+template<typename T, std::size_t... Is>
+struct mode_names_<T, index_sequence_<Is...> > {
+    static constexpr std::size_t count = sizeof...(Is);
+    static constexpr const char *names[sizeof...(Is)] = { ModeNames<T>::mode(Is)... };
+    static constexpr std::size_t lengths[sizeof...(Is)] = { strlen_(ModeNames<T>::mode(Is))... };
+};
+
+template<typename T, std::size_t... Is>
+constexpr std::size_t mode_names_<T, index_sequence_<Is...> >::count;
+
+template<typename T, std::size_t... Is>
+constexpr const char *mode_names_<T, index_sequence_<Is...> >::names[sizeof...(Is)];
+
+template<typename T, std::size_t... Is>
+constexpr std::size_t mode_names_<T, index_sequence_<Is...> >::lengths[sizeof...(Is)];
+
+// category_names_<Cats...>: the category names of ModeCategory types /Cats/
+
+template<typename... Cats>
+struct category_names_ {
+    static constexpr std::size_t count = sizeof...(Cats);
+    static constexpr const char *names[sizeof...(Cats)] = { ModeNames<typename Cats::value_type>::category()... };
+    static constexpr std::size_t lengths[sizeof...(Cats)] = { strlen_(ModeNames<typename Cats::value_type>::category())... };
+};
+
+template<typename... Cats>
+constexpr std::size_t category_names_<Cats...>::count;
+
+template<typename... Cats>
+constexpr const char *category_names_<Cats...>::names[sizeof...(Cats)];
+
+template<typename... Cats>
+constexpr std::size_t category_names_<Cats...>::lengths[sizeof...(Cats)];
+
+// ----------------------------------------------------------------------------
+// perfect_hash_<Names> maps each name in name list /Names/ to its index,
+// using a collision-free hash table computed at compile time.
+//
+// The table has at least count^2 slots, so a collision-free seed is usually
+// found within the first few candidates. The cheapest hash kind that has a
+// collision-free seed is used: the prefix hash if the names can be told
+// apart by two of their first 8 chars (ignoring chars beyond the shortest
+// name), otherwise the sampled hash, otherwise the full FNV-1a hash.
+//
+// find_token() is the lookup used by the parser. With the prefix hash it
+// costs one table load and a compare against the stored name, and the end
+// of the token is never searched for: the table entry holds the name's
+// length, which tells where the delimiter must be. With the other kinds,
+// the token is first scanned for its delimiter.
+
+template<typename Names,
+    typename Slots = typename make_index_sequence_<next_pow2_(Names::count * Names::count < 2 ? 2 : Names::count * Names::count)>::type>
+struct perfect_hash_;
+
+template<typename Names, std::size_t... Ss>
+struct perfect_hash_<Names, index_sequence_<Ss...> > {
+    static constexpr std::size_t count = Names::count;
+    static constexpr std::size_t slots = sizeof...(Ss);
+    static constexpr std::uint32_t max_seeds = 64;
+    static constexpr std::size_t max_positions = 64; // number of prefix_sample_ position pairs
+
+    static_assert(count < 255, "perfect_hash_ supports at most 254 names.");
+
+    static constexpr std::size_t min_length_(std::size_t i = 0, std::size_t m = std::size_t(-1)) noexcept {
+        return (i == count) ? m : min_length_(i + 1, (Names::lengths[i] < m) ? Names::lengths[i] : m);
+    }
+
+    // no name is shorter than min_length
+    static constexpr std::size_t min_length = min_length_();
+
+    // true if names /i/ and /j/ have the same chars at the positions /p/
+    static constexpr bool same_prefix_sample_(std::size_t p, std::size_t i, std::size_t j) noexcept {
+        return prefix_sample_(Names::names[i], p) == prefix_sample_(Names::names[j], p);
+    }
+
+    // true if name /i/ has the same prefix sample as any name in [j, count)
+    static constexpr bool prefix_sample_shared_with_(std::size_t p, std::size_t i, std::size_t j) noexcept {
+        return (j < count) && (same_prefix_sample_(p, i, j) || prefix_sample_shared_with_(p, i, j + 1));
+    }
+
+    static constexpr bool prefix_samples_distinct_(std::size_t p, std::size_t i = 0) noexcept {
+        return (i == count) || (!prefix_sample_shared_with_(p, i, i + 1) && prefix_samples_distinct_(p, i + 1));
+    }
+
+    // find_positions_() is the first /p/ whose positions are within every
+    // name and tell all names apart, or max_positions if there is none
+    static constexpr std::size_t find_positions_(std::size_t p = 0) noexcept {
+        return (p == max_positions) ? p
+            : (p % 8 < min_length && p / 8 < min_length && prefix_samples_distinct_(p))
+                ? p : find_positions_(p + 1);
+    }
+
+    // the positions sampled by the prefix hash
+    static constexpr std::size_t positions = find_positions_();
+
+    template<hash_kind_ Kind>
+    static constexpr std::size_t slot_(std::uint32_t seed, std::size_t i) noexcept {
+        return seeded_hash_<Kind>(seed, positions, Names::names[i], Names::lengths[i]) & (slots - 1);
+    }
+
+    // true if name /i/ collides with any name in [j, count)
+    template<hash_kind_ Kind>
+    static constexpr bool collides_with_(std::uint32_t seed, std::size_t i, std::size_t j) noexcept {
+        return (j < count) && (slot_<Kind>(seed, i) == slot_<Kind>(seed, j) || collides_with_<Kind>(seed, i, j + 1));
+    }
+
+    template<hash_kind_ Kind>
+    static constexpr bool collides_(std::uint32_t seed, std::size_t i = 0) noexcept {
+        return (i < count) && (collides_with_<Kind>(seed, i, i + 1) || collides_<Kind>(seed, i + 1));
+    }
+
+    template<hash_kind_ Kind>
+    static constexpr std::uint32_t find_seed_(std::uint32_t seed = 0) noexcept {
+        return (seed == max_seeds || !collides_<Kind>(seed)) ? seed : find_seed_<Kind>(seed + 1);
+    }
+
+    static constexpr hash_kind_ kind =
+        (positions != max_positions && find_seed_<hash_kind_::prefix>() != max_seeds) ? hash_kind_::prefix
+        : (find_seed_<hash_kind_::sampled>() != max_seeds) ? hash_kind_::sampled
+        : hash_kind_::full;
+    static constexpr std::uint32_t seed = find_seed_<kind>();
+    static_assert(seed != max_seeds, "No collision-free hash seed found. Are two names the same?");
+
+    // entry_(s) is the index of the name in slot /s/ in the low 8 bits and its
+    // length above them, or /count/ if the slot is empty. Keeping the length
+    // in the table saves a dependent load per lookup.
+    static constexpr std::uint32_t entry_(std::size_t s, std::size_t i = 0) noexcept {
+        return (i == count) ? static_cast<std::uint32_t>(count)
+            : (slot_<kind>(seed, i) == s) ? static_cast<std::uint32_t>(i | (Names::lengths[i] << 8))
+            : entry_(s, i + 1);
+    }
+
+    static constexpr std::uint32_t table[sizeof...(Ss)] = { entry_(Ss)... };
+
+    // find(s, n) returns the index of the /n/ char name at /s/, or /count/ if not found
+    static std::size_t find(const char *s, std::size_t n) noexcept {
+        if (n < min_length)
+            return count; // also keeps the prefix hash within /s/
+        std::uint32_t e = table[seeded_hash_<kind>(seed, positions, s, n) & (slots - 1)];
+        std::size_t i = e & 0xff;
+        return (i != count && (e >> 8) == n && equal_(Names::names[i], s, n)) ? i : count;
+    }
+
+    // find_token(s, end, delimiter) looks up the name at /s/, which must be
+    // followed by /delimiter/ or by /end/. Returns its index and advances /s/
+    // past the name, or returns /count/ if not found.
+    static std::size_t find_token(const char *&s, const char *end, char delimiter) noexcept {
+        return find_token_(s, end, delimiter, std::integral_constant<bool, kind == hash_kind_::prefix>());
+    }
+
+    static std::size_t find_token_(const char *&s, const char *end, char delimiter, std::true_type /*prefix*/) noexcept {
+        const std::size_t n = static_cast<std::size_t>(end - s);
+        if (n < min_length)
+            return count; // also keeps the prefix hash within /s/
+        std::uint32_t e = table[seeded_hash_<hash_kind_::prefix>(seed, positions, s, n) & (slots - 1)];
+        std::size_t i = e & 0xff, length = e >> 8;
+        if (i == count || length > n || (length != n && s[length] != delimiter) || !equal_(Names::names[i], s, length))
+            return count;
+        s += length;
+        return i;
+    }
+
+    static std::size_t find_token_(const char *&s, const char *end, char delimiter, std::false_type /*prefix*/) noexcept {
+        const char *t = s;
+        while (t != end && *t != delimiter)
+            ++t;
+        std::size_t i = find(s, static_cast<std::size_t>(t - s));
+        if (i != count)
+            s = t;
+        return i;
+    }
+};
+
+template<typename Names, std::size_t... Ss>
+constexpr std::size_t perfect_hash_<Names, index_sequence_<Ss...> >::positions;
+
+template<typename Names, std::size_t... Ss>
+constexpr std::size_t perfect_hash_<Names, index_sequence_<Ss...> >::min_length;
+
+template<typename Names, std::size_t... Ss>
+constexpr hash_kind_ perfect_hash_<Names, index_sequence_<Ss...> >::kind;
+
+template<typename Names, std::size_t... Ss>
+constexpr std::uint32_t perfect_hash_<Names, index_sequence_<Ss...> >::seed;
+
+template<typename Names, std::size_t... Ss>
+constexpr std::uint32_t perfect_hash_<Names, index_sequence_<Ss...> >::table[sizeof...(Ss)];
+
+// ----------------------------------------------------------------------------
+// mode_parser_<type_pack<Cats...> >::parse() parses mode strings into packed keys
+
+// parse_mode_index_<Cat>(s, end) looks up the mode name at /s/, which must
+// be followed by ',' or /end/. Returns its index in /Cat/ and advances /s/
+// past the name, or returns Cat::size if there is no such mode in /Cat/.
+template<typename Cat>
+std::size_t parse_mode_index_(const char *&s, const char *end) noexcept {
+    using value_type = typename Cat::value_type;
+    using names_type = mode_names_<value_type>;
+    std::size_t i = perfect_hash_<names_type>::find_token(s, end, ',');
+    return (i == names_type::count) ? Cat::size : Cat::index_of(static_cast<value_type>(i));
+}
+
+template<typename Categories, typename Is>
+struct mode_parser_impl_;
+
+template<typename... Cats, std::size_t... Is>
+struct mode_parser_impl_<type_pack<Cats...>, index_sequence_<Is...> > {
+    static_assert(sizeof...(Cats) <= 64, "mode_parser_ supports at most 64 mode categories.");
+
+    using category_hash_ = perfect_hash_<category_names_<Cats...> >;
+
+    using parse_fn = std::size_t (*)(const char *&, const char *);
+
+    static constexpr std::size_t invalid_key = pack_<Cats...>::size;
+
+    static constexpr parse_fn parsers[sizeof...(Cats)] = { &parse_mode_index_<Cats>... };
+    static constexpr std::size_t sizes[sizeof...(Cats)] = { Cats::size... };
+
+    static constexpr std::size_t stride_(std::size_t c) noexcept {
+        return (c == 0) ? 1 : sizes[c - 1] * stride_(c - 1);
+    }
+
+    static constexpr std::size_t strides[sizeof...(Cats)] = { stride_(Is)... };
+
+    static std::size_t parse(const char *s, std::size_t n) noexcept {
+        std::size_t key = 0; // all categories default to index 0
+        std::uint64_t seen = 0; // bit c is set once category c has been parsed
+        const char *end = s + n;
+
+        if (s == end)
+            return key; // "" is valid
+
+        for (;;) {
+            // category name, followed by '='
+            std::size_t c = category_hash_::find_token(s, end, '=');
+            if (c == sizeof...(Cats) || (seen & (std::uint64_t(1) << c)))
+                return invalid_key;
+            seen |= std::uint64_t(1) << c;
+            if (s == end)
+                return invalid_key; // no '='
+            ++s;
+
+            // mode name, followed by ',' or the end
+            std::size_t i = parsers[c](s, end);
+            if (i == sizes[c])
+                return invalid_key;
+            key += i * strides[c];
+
+            if (s == end)
+                return key;
+            if (++s == end)
+                return invalid_key; // trailing ','
+        }
+    }
+};
+
+template<typename... Cats, std::size_t... Is>
+constexpr typename mode_parser_impl_<type_pack<Cats...>, index_sequence_<Is...> >::parse_fn
+    mode_parser_impl_<type_pack<Cats...>, index_sequence_<Is...> >::parsers[sizeof...(Cats)];
+
+template<typename... Cats, std::size_t... Is>
+constexpr std::size_t mode_parser_impl_<type_pack<Cats...>, index_sequence_<Is...> >::sizes[sizeof...(Cats)];
+
+template<typename... Cats, std::size_t... Is>
+constexpr std::size_t mode_parser_impl_<type_pack<Cats...>, index_sequence_<Is...> >::strides[sizeof...(Cats)];
+
+template<typename Categories>
+struct mode_parser_;
+
+template<typename... Cats>
+struct mode_parser_<type_pack<Cats...> >
+    : mode_parser_impl_<type_pack<Cats...>, typename make_index_sequence_<sizeof...(Cats)>::type> {};
+
+// ----------------------------------------------------------------------------
+// to_string support
+
+template<typename T>
+void append_mode_(std::string& result, T x) {
+    if (!result.empty())
+        result += ',';
+    result += ModeNames<T>::category();
+    result += '=';
+    std::size_t i = static_cast<std::size_t>(x);
+    result += (i < mode_names_<T>::count) ? mode_names_<T>::names[i] : "?";
+}
+
+template<typename ModeSet_>
+struct mode_set_to_string_;
+
+template<typename... Ms>
+struct mode_set_to_string_<ModeSet<Ms...> > {
+    static std::string to_string() {
+        std::string result;
+        int expand[] = { 0, (append_mode_(result, Ms::value), 0)... };
+        (void)expand;
+        return result;
+    }
+};
+
+template<typename Categories>
+struct key_to_string_;
+
+template<typename... Cats>
+struct key_to_string_<type_pack<Cats...> > {
+    template<typename Space>
+    static std::string to_string(std::size_t key) {
+        std::string result;
+        int expand[] = { 0, (append_mode_(result, Space::template value<typename Cats::value_type>(key)), 0)... };
+        (void)expand;
+        return result;
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+} // end namespace detail
+
+///////////////////////////////////////////////////////////////////////////////
+// Names
+
+// category_name<T>() is the name of mode category /T/
+
+template<typename T>
+constexpr const char *category_name() noexcept { return ModeNames<T>::category(); }
+
+// mode_name(Mode<T,X>) is the name of the mode (constexpr)
+
+template<typename T, T X>
+constexpr const char *mode_name(Mode<T, X>) noexcept {
+    return ModeNames<T>::mode(static_cast<std::size_t>(X));
+}
+
+// mode_name(x) is the name of runtime mode value /x/, or nullptr if /x/ has no name
+
+template<typename T>
+const char *mode_name(T x) noexcept {
+    std::size_t i = static_cast<std::size_t>(x);
+    return (i < detail::mode_names_<T>::count) ? detail::mode_names_<T>::names[i] : nullptr;
+}
+
+// to_string(modes) formats a mode expression as a mode string,
+// e.g. to_string(dashed|arrows) == "line=dashed,end=arrows".
+// Modes are listed in the order they appear in /modes/.
+
+template<typename T, T X>
+std::string to_string(Mode<T, X>) {
+    return detail::mode_set_to_string_<ModeSet<Mode<T, X> > >::to_string();
+}
+
+template<typename... Ts>
+std::string to_string(ModeSet<Ts...>) {
+    return detail::mode_set_to_string_<ModeSet<Ts...> >::to_string();
+}
+
+template<typename Space, std::size_t Key>
+std::string to_string(PackedModes<Space, Key>) {
+    return detail::mode_set_to_string_<typename PackedModes<Space, Key>::mode_set>::to_string();
+}
+
+// to_string<Space>(key) formats the normalized mode set with packed key /key/
+// (which must be less than Space::size). Every category of /Space/ is listed,
+// in category order.
+
+template<typename Space>
+std::string to_string(std::size_t key) {
+    return detail::key_to_string_<typename Space::categories>::template to_string<Space>(key);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Parsing
+
+// parse_modes<Space>(s, n) parses the /n/ char mode string at /s/
+// (e.g. "line=dashed,end=arrows") and returns its packed key in /Space/.
+// Missing categories take their default modes, so "" parses to key 0.
+// Returns Space::size if the string is malformed, names an unknown
+// category or mode, or names a category twice.
+//
+// Names are looked up with compile-time perfect hash tables. Parsing does
+// not allocate.
+
+template<typename Space>
+std::size_t parse_modes(const char *s, std::size_t n) noexcept {
+    return detail::mode_parser_<typename Space::categories>::parse(s, n);
+}
+
+template<typename Space>
+std::size_t parse_modes(const char *s) noexcept {
+    return parse_modes<Space>(s, std::strlen(s));
+}
+
+template<typename Space>
+std::size_t parse_modes(const std::string& s) noexcept {
+    return parse_modes<Space>(s.data(), s.size());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // end namespace staticmode
+
+// STATICMODE_MODE_NAMES(EnumClass, CategoryName, ModeNames...)
+// Specializes staticmode::ModeNames<EnumClass>. Use at global namespace scope.
+
+#define STATICMODE_MODE_NAMES(EnumClass, CategoryName, ...) \
+    namespace staticmode { \
+    template<> struct ModeNames<EnumClass> { \
+        static constexpr const char *category() noexcept { return CategoryName; } \
+        static constexpr std::size_t size() noexcept { return detail::count_names_(__VA_ARGS__); } \
+        static constexpr const char *mode(std::size_t i) noexcept { return detail::nth_name_(i, __VA_ARGS__); } \
+    }; \
+    }
+
+#endif /* INCLUDED_STATICMODENAMES_H */
@@ -0,0 +1,311 @@
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDED_STATICMODESHARED_H
+#define INCLUDED_STATICMODESHARED_H
+
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t, uint64_t
+
+#include <fcntl.h> // O_* constants
+#include <sys/mman.h> // shm_open, mmap
+#include <sys/stat.h> // fstat
+#include <unistd.h> // ftruncate, close
+
+#include "StaticMode.h"
+
+// Sharing the current mode configuration between processes (POSIX only).
+//
+// shared_mode_config<Space> maps a small POSIX shared memory object
+// (shm_open + mmap) that holds a packed key of /Space/ under a seqlock.
+// Any number of processes map the same object by name. A store() is visible
+// to every process. A load() is a few loads from the mapping, with no system
+// call, so readers can poll it on every block and resolve the key to a local
+// dispatch entry (e.g. mode_function::bind(), or a table lookup) only when
+// version() changes.
+
+namespace staticmode {
+
+namespace detail {
+
+// The shared memory layout. Atomics in shared memory must be lock-free
+// (and therefore address-free) to work across processes.
+
+struct shared_mode_block_ {
+    static constexpr std::uint32_t magic_value = 0x444f4d53; // "SMOD"
+    static constexpr std::uint32_t layout_version = 1;
+
+    std::atomic<std::uint32_t> magic;       // magic_value once initialized
+    std::uint32_t layout;                   // layout_version
+    std::uint64_t space_size;               // Space::size, to detect mismatched spaces
+    std::atomic<std::uint64_t> sequence;    // seqlock sequence: odd while a store is in progress
+    std::atomic<std::uint64_t> key;
+    std::atomic<std::uint64_t> stamp;
+};
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+    "shared_mode_config requires lock-free 32- and 64-bit atomics.");
+
+} // end namespace detail
+
+///////////////////////////////////////////////////////////////////////////////
+// shared_mode_config<Space> is a handle to a shared mode configuration.
+//
+// create(name) creates (or re-initializes) the shared memory object /name/
+// (e.g. "/painter-modes") holding key 0. Re-initializing an existing object
+// counts as a store of key 0: the version keeps increasing, so processes that
+// have the object mapped see the change. open(name) maps an existing object;
+// it fails if the object was created for a space of a different size.
+// Both return false on failure, leaving errno set by the failing call.
+// unlink(name) removes the name; existing mappings stay valid.
+//
+// store(key, stamp) publishes /key/ and increments the version. Concurrent
+// stores from several threads or processes are serialized by the seqlock.
+// /stamp/ is 64 bits of user data published with the key, e.g. the time of
+// the change (see examples/shared-modes.cpp).
+//
+// load() returns a consistent snapshot {key, version, stamp}. It retries
+// while a store is in progress, so it is lock-free, not wait-free: a store
+// that stalls mid-update stalls readers. try_load(s, spins) gives up after
+// /spins/ retries and returns false, leaving /s/ unchanged.
+//
+// A writer must not die (or be killed) during store(): the sequence stays
+// odd, so every later load() spins forever, every later store() blocks, and
+// try_load() always fails. The only recovery is to create() the object
+// again. Don't store() from processes that may be killed asynchronously.
+//
+// example usage:
+//
+// // control process
+// shared_mode_config<PainterModes> config;
+// config.create("/painter-modes");
+// config.store(PainterModes::key(LineStyle::dashed, EndStyle::arrows));
+//
+// // worker process
+// shared_mode_config<PainterModes> config;
+// config.open("/painter-modes");
+// if (config.version() != cachedVersion) {
+//     shared_mode_config<PainterModes>::snapshot s = config.load();
+//     cachedVersion = s.version;
+//     drawLine = DrawLineFunction::bind<DrawLineKernel>(s.key);
+// }
+
+template<typename Space>
+class shared_mode_config {
+public:
+    using space_type = Space;
+
+    struct snapshot {
+        std::size_t key;
+        std::uint64_t version;   // number of stores (and re-initializing create()s) since the object was created
+        std::uint64_t stamp;
+    };
+
+    shared_mode_config() noexcept : block_(nullptr) {}
+
+    shared_mode_config(const shared_mode_config&) = delete;
+    shared_mode_config& operator=(const shared_mode_config&) = delete;
+
+    shared_mode_config(shared_mode_config&& rhs) noexcept : block_(rhs.block_) { rhs.block_ = nullptr; }
+
+    shared_mode_config& operator=(shared_mode_config&& rhs) noexcept {
+        if (this != &rhs) {
+            close();
+            block_ = rhs.block_;
+            rhs.block_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~shared_mode_config() { close(); }
+
+    bool create(const char *name) {
+        close();
+        if (!map_(name, O_RDWR | O_CREAT, true))
+            return false;
+
+        if (block_->magic.load(std::memory_order_acquire) != detail::shared_mode_block_::magic_value
+                || block_->layout != detail::shared_mode_block_::layout_version) {
+            // a new object: nobody else can be using it
+            block_->magic.store(0, std::memory_order_relaxed);
+            block_->layout = detail::shared_mode_block_::layout_version;
+            block_->space_size = Space::size;
+            block_->sequence.store(0, std::memory_order_relaxed);
+            block_->key.store(0, std::memory_order_relaxed);
+            block_->stamp.store(0, std::memory_order_relaxed);
+            block_->magic.store(detail::shared_mode_block_::magic_value, std::memory_order_release);
+            return true;
+        }
+
+        // re-initializing an object that other processes may have mapped:
+        // keep the sequence increasing, so that their version() changes and a
+        // load() in progress retries. An odd sequence is taken over: that is
+        // how a writer that died mid-store is recovered from.
+        std::uint64_t seq = block_->sequence.load(std::memory_order_relaxed) | 1;
+        block_->sequence.store(seq, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release); // the odd sequence is visible before the data
+
+        block_->space_size = Space::size;
+        block_->key.store(0, std::memory_order_relaxed);
+        block_->stamp.store(0, std::memory_order_relaxed);
+
+        block_->sequence.store(seq + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool open(const char *name) {
+        close();
+        if (!map_(name, O_RDWR, false))
+            return false;
+
+        if (block_->magic.load(std::memory_order_acquire) != detail::shared_mode_block_::magic_value
+                || block_->layout != detail::shared_mode_block_::layout_version
+                || block_->space_size != Space::size) {
+            close();
+            errno = EINVAL;
+            return false;
+        }
+        return true;
+    }
+
+    static bool unlink(const char *name) { return ::shm_unlink(name) == 0; }
+
+    void close() noexcept {
+        if (block_) {
+            ::munmap(block_, sizeof(detail::shared_mode_block_));
+            block_ = nullptr;
+        }
+    }
+
+    bool is_open() const noexcept { return block_ != nullptr; }
+
+    void store(std::size_t key, std::uint64_t stamp = 0) noexcept {
+        assert(block_ && key < Space::size);
+
+        // acquire the seqlock: make the sequence odd. Acquire ordering on
+        // success orders this store after the previous writer's release.
+        std::uint64_t seq = block_->sequence.load(std::memory_order_relaxed);
+        for (;;) {
+            if ((seq & 1) == 0 && block_->sequence.compare_exchange_weak(seq, seq + 1,
+                    std::memory_order_acquire, std::memory_order_relaxed))
+                break;
+            seq = block_->sequence.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release); // the odd sequence is visible before the data
+
+        block_->key.store(key, std::memory_order_relaxed);
+        block_->stamp.store(stamp, std::memory_order_relaxed);
+
+        block_->sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    snapshot load() const noexcept {
+        snapshot result;
+        while (!read_(result)) {}
+        return result;
+    }
+
+    bool try_load(snapshot& result, std::size_t spins) const noexcept {
+        for (std::size_t i = 0; i <= spins; ++i) {
+            if (read_(result))
+                return true;
+        }
+        return false;
+    }
+
+    // the current version: a single acquire load, for cheap change detection.
+    // An odd sequence (a store in progress) reports the previous version.
+    std::uint64_t version() const noexcept {
+        assert(block_);
+        return block_->sequence.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    // one attempt to read a consistent snapshot
+    bool read_(snapshot& result) const noexcept {
+        assert(block_);
+        std::uint64_t seq = block_->sequence.load(std::memory_order_acquire);
+        if (seq & 1)
+            return false; // a store is in progress
+
+        std::uint64_t key = block_->key.load(std::memory_order_relaxed);
+        std::uint64_t stamp = block_->stamp.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire); // the data is read before the sequence is re-checked
+
+        if (block_->sequence.load(std::memory_order_relaxed) != seq)
+            return false;
+        result.key = static_cast<std::size_t>(key);
+        result.version = seq / 2;
+        result.stamp = stamp;
+        return true;
+    }
+
+    bool map_(const char *name, int flags, bool resize) {
+        int fd = ::shm_open(name, flags, 0600);
+        if (fd == -1)
+            return false;
+
+        if (resize) {
+            if (::ftruncate(fd, static_cast<off_t>(sizeof(detail::shared_mode_block_))) != 0) {
+                int error = errno;
+                ::close(fd);
+                errno = error;
+                return false;
+            }
+        } else {
+            // don't map an object that is too small: accessing it would raise SIGBUS
+            struct stat st;
+            if (::fstat(fd, &st) != 0) {
+                int error = errno;
+                ::close(fd);
+                errno = error;
+                return false;
+            }
+            if (static_cast<std::size_t>(st.st_size) < sizeof(detail::shared_mode_block_)) {
+                ::close(fd);
+                errno = EINVAL;
+                return false;
+            }
+        }
+
+        void *p = ::mmap(nullptr, sizeof(detail::shared_mode_block_), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        int error = errno;
+        ::close(fd); // the mapping stays valid
+        if (p == MAP_FAILED) {
+            errno = error;
+            return false;
+        }
+
+        block_ = static_cast<detail::shared_mode_block_*>(p);
+        return true;
+    }
+
+    detail::shared_mode_block_ *block_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // end namespace staticmode
+
+#endif /* INCLUDED_STATICMODESHARED_H */
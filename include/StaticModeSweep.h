@@ -0,0 +1,238 @@
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDED_STATICMODESWEEP_H
+#define INCLUDED_STATICMODESWEEP_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <cstdio> // snprintf
+#include <exception> // exception_ptr
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "StaticMode.h"
+
+// Sweeping every mode combination: running a kernel once per normalized mode
+// set of a ModeSpace (i.e. every instantiation), in parallel, and reporting
+// the time and an output checksum of each. Use it to exercise all
+// instantiations in CI, to check that combinations that should be equivalent
+// produce the same output, and to find slow combinations.
+//
+// The kernel protocol is the one used by mode_function (see
+// StaticModeDispatch.h), with the checksum as the result:
+//
+// struct RenderCheck {
+//     template<typename ModeExpr>
+//     static std::uint64_t apply(const Scene& scene) { ... render with ModeExpr, return a hash of the output ... }
+// };
+//
+// std::vector<sweep_result> results = sweep<PainterModes, RenderCheck>(0, 3, scene);
+// write_sweep_csv(std::cout, results, &to_string<PainterModes>); // see StaticModeNames.h
+
+namespace staticmode {
+
+///////////////////////////////////////////////////////////////////////////////
+// sweep_result: the outcome for one packed key
+
+struct sweep_result {
+    std::size_t key;
+    bool ran;               // false if the key was skipped (see sweep_allowed)
+    double seconds;         // minimum time of the timed calls
+    std::uint64_t checksum; // the kernel's result (from the last call)
+};
+
+namespace detail {
+
+template<typename Space, typename Kernel, typename... Args>
+std::vector<sweep_result> sweep_(unsigned threads, unsigned repetitions, bool (*allowed)(std::size_t), const Args&... args) {
+    using table_ = method_table_<Space, Kernel>;
+
+    std::vector<sweep_result> results(Space::size);
+    for (std::size_t key = 0; key < Space::size; ++key) {
+        sweep_result r = { key, false, 0., 0 };
+        results[key] = r;
+    }
+
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+    if (threads > Space::size)
+        threads = static_cast<unsigned>(Space::size);
+
+    // workers take the next key from a shared counter, so a slow
+    // combination doesn't hold up a statically assigned range
+    std::atomic<std::size_t> next(0);
+    std::atomic<bool> failed(false);
+    std::vector<std::exception_ptr> errors(threads);
+
+    auto worker = [&](unsigned index) {
+        try {
+            for (std::size_t key = next.fetch_add(1); key < Space::size && !failed.load(); key = next.fetch_add(1)) {
+                if (allowed && !allowed(key))
+                    continue;
+
+                sweep_result& r = results[key];
+                for (unsigned i = 0; i < repetitions || i == 0; ++i) {
+                    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                    r.checksum = static_cast<std::uint64_t>(table_::functions[key](args...));
+                    double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                    if (i == 0 || t < r.seconds)
+                        r.seconds = t;
+                }
+                r.ran = true;
+            }
+        } catch (...) {
+            errors[index] = std::current_exception();
+            failed.store(true);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    try {
+        for (unsigned i = 1; i < threads; ++i)
+            pool.emplace_back(worker, i);
+    } catch (...) {
+        // a joinable std::thread must not be destroyed: stop and join the
+        // workers that did start before rethrowing
+        failed.store(true);
+        for (std::thread& t : pool)
+            t.join();
+        throw;
+    }
+    worker(0); // the calling thread is worker 0
+    for (std::thread& t : pool)
+        t.join();
+
+    for (const std::exception_ptr& e : errors) {
+        if (e)
+            std::rethrow_exception(e);
+    }
+    return results;
+}
+
+template<typename Rules>
+bool sweep_allows_(std::size_t key) { return Rules::test(key); }
+
+} // end namespace detail
+
+///////////////////////////////////////////////////////////////////////////////
+// sweep<Space, Kernel>(threads, repetitions, args...) calls
+// Kernel::apply<PackedModes<Space, key>>(args...) for every key of /Space/,
+// on /threads/ threads (0: one per hardware thread, including the calling
+// thread). Each key is called /repetitions/ times (at least once). Returns
+// one sweep_result per key, indexed by key.
+//
+// sweep_allowed<Rules, Kernel>(threads, repetitions, args...) sweeps the
+// keys of Rules::space_type that ModeRules /Rules/ allows. The other
+// results have ran == false.
+//
+// /args/ are shared by all threads, as const lvalues, so the kernel must
+// only read them. If a kernel throws, the sweep stops early and the
+// exception is rethrown on the calling thread.
+//
+// Timings taken in parallel include contention between threads (shared
+// caches, memory bandwidth, frequency scaling). They are good for finding
+// outliers; use threads = 1 for benchmark-quality numbers.
+
+template<typename Space, typename Kernel, typename... Args>
+std::vector<sweep_result> sweep(unsigned threads, unsigned repetitions, const Args&... args) {
+    return detail::sweep_<Space, Kernel>(threads, repetitions, nullptr, args...);
+}
+
+template<typename Rules, typename Kernel, typename... Args>
+std::vector<sweep_result> sweep_allowed(unsigned threads, unsigned repetitions, const Args&... args) {
+    return detail::sweep_<typename Rules::space_type, Kernel>(threads, repetitions, &detail::sweep_allows_<Rules>, args...);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Reports
+//
+// write_sweep_csv(os, results, describe) writes a CSV report:
+//
+//   key,modes,ran,seconds,checksum
+//   0,"line=solid,end=no_ends",1,1.2e-05,0x5e1f0a3c2b9d4e71
+//
+// write_sweep_json(os, results, describe) writes the same as a JSON array
+// of objects. /describe/ formats a key for the "modes" field, e.g.
+// &to_string<PainterModes> (see StaticModeNames.h). If it is null, the
+// field is empty. Checksums are written in hex: JSON numbers can't hold
+// every 64-bit value.
+
+namespace detail {
+
+inline std::string sweep_hex_(std::uint64_t x) {
+    char s[19];
+    std::snprintf(s, sizeof(s), "0x%016llx", static_cast<unsigned long long>(x));
+    return s;
+}
+
+inline std::string sweep_quoted_(const std::string& s, bool json) {
+    std::string result = "\"";
+    for (char c : s) {
+        if (c == '"')
+            result += json ? "\\\"" : "\"\"";
+        else if (json && c == '\\')
+            result += "\\\\";
+        else if (json && static_cast<unsigned char>(c) < 0x20)
+            result += ' ';
+        else
+            result += c;
+    }
+    return result + "\"";
+}
+
+} // end namespace detail
+
+inline void write_sweep_csv(std::ostream& os, const std::vector<sweep_result>& results,
+        std::string (*describe)(std::size_t) = nullptr) {
+    os << "key,modes,ran,seconds,checksum\n";
+    for (const sweep_result& r : results) {
+        os << r.key << ',' << detail::sweep_quoted_(describe ? describe(r.key) : std::string(), false) << ','
+            << (r.ran ? 1 : 0) << ',' << r.seconds << ',' << detail::sweep_hex_(r.checksum) << '\n';
+    }
+}
+
+inline void write_sweep_json(std::ostream& os, const std::vector<sweep_result>& results,
+        std::string (*describe)(std::size_t) = nullptr) {
+    os << "[";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const sweep_result& r = results[i];
+        os << (i ? ",\n " : "\n ") << "{\"key\": " << r.key
+            << ", \"modes\": " << detail::sweep_quoted_(describe ? describe(r.key) : std::string(), true)
+            << ", \"ran\": " << (r.ran ? "true" : "false")
+            << ", \"seconds\": " << r.seconds
+            << ", \"checksum\": \"" << detail::sweep_hex_(r.checksum) << "\"}";
+    }
+    os << "\n]\n";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // end namespace staticmode
+
+#endif /* INCLUDED_STATICMODESWEEP_H */
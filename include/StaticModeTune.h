@@ -0,0 +1,278 @@
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDED_STATICMODETUNE_H
+#define INCLUDED_STATICMODETUNE_H
+
+#include <chrono>
+#include <cstddef> // size_t
+#include <cstdio> // remove
+#include <cstdlib> // strtoul
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "StaticMode.h"
+#include "StaticModeFile.h" // detail::temp_file_name_, detail::replace_file_
+#include "StaticModeIsa.h" // detail::cpuid_
+
+// Autotuning: choosing the fastest of several algorithmically equivalent
+// combinations of modes (e.g. blocking strategy, unroll factor, table versus
+// compute) on the host, at startup.
+//
+// The tuned modes are the categories of a ModeSpace, and the candidates are
+// the instantiations of a kernel (see StaticModeDispatch.h) for each of its
+// packed keys. autotune() times each candidate and returns the key of the
+// fastest. autotune_cached() also persists the winning key in a cache file,
+// keyed by the tuner name and the CPU model, so that later startups load it
+// without timing anything:
+//
+// struct SumKernel {
+//     template<typename ModeExpr>
+//     static float apply(const float *x, std::size_t n) { ... } // e.g. unrolled per get_mode_t<Unroll, ModeExpr, ...>
+// };
+//
+// autotune_result r = autotune_cached<SumTuning, SumKernel>("tuning.cache", "sum", input, inputSize);
+// SumFunction sum = SumFunction::bind<SumKernel>(r.key);
+
+namespace staticmode {
+
+///////////////////////////////////////////////////////////////////////////////
+// cpu_model() identifies the host CPU, e.g. "Intel(R) Xeon(R) Platinum 8375C
+// CPU @ 2.90GHz": the cpuid brand string on x86, otherwise the "model name"
+// or "Hardware" line of /proc/cpuinfo, otherwise "unknown".
+
+inline std::string cpu_model() {
+    std::string model;
+
+#if defined(STATICMODE_ISA_X86_GNU_) || defined(STATICMODE_ISA_X86_MSVC_)
+    unsigned regs[4] = {};
+    if (detail::cpuid_(0x80000000u, 0, regs) && regs[0] >= 0x80000004u) {
+        char brand[49] = {};
+        for (unsigned leaf = 0; leaf < 3; ++leaf) {
+            detail::cpuid_(0x80000002u + leaf, 0, regs);
+            for (unsigned i = 0; i < 4; ++i) {
+                for (unsigned b = 0; b < 4; ++b)
+                    brand[leaf * 16 + i * 4 + b] = static_cast<char>((regs[i] >> (8 * b)) & 0xff);
+            }
+        }
+        model = brand;
+    }
+#endif
+
+    if (model.empty()) {
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while (model.empty() && std::getline(cpuinfo, line)) {
+            if (line.compare(0, 10, "model name") == 0 || line.compare(0, 8, "Hardware") == 0) {
+                std::string::size_type colon = line.find(':');
+                if (colon != std::string::npos)
+                    model = line.substr(colon + 1);
+            }
+        }
+    }
+
+    // trim, and normalize characters that the cache file format uses
+    std::string::size_type first = model.find_first_not_of(" \t");
+    std::string::size_type last = model.find_last_not_of(" \t");
+    model = (first == std::string::npos) ? std::string() : model.substr(first, last - first + 1);
+    for (char& c : model) {
+        if (c == '\t' || c == '\n' || c == '\r')
+            c = ' ';
+    }
+
+    return model.empty() ? "unknown" : model;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// autotune<Space, Kernel>(repetitions, args...) calls
+// Kernel::apply<PackedModes<Space, key>>(args...) for every key of /Space/:
+// once to warm up, then /repetitions/ timed calls. It returns the key with
+// the lowest minimum time (the minimum is the least noisy estimate).
+// /args/ are passed as lvalues: the representative input must stay valid
+// across calls, and a kernel that writes its output must do so the same way
+// each time.
+//
+// autotune_times<Space, Kernel>(repetitions, args...) returns the minimum
+// time of each key, in seconds, indexed by key.
+
+template<typename Space, typename Kernel, typename... Args>
+std::vector<double> autotune_times(unsigned repetitions, Args&&... args) {
+    using table_ = detail::method_table_<Space, Kernel>;
+
+    std::vector<double> times(Space::size);
+    for (std::size_t key = 0; key < Space::size; ++key) {
+        table_::functions[key](args...); // warm up
+
+        double best = 0;
+        for (unsigned r = 0; r < repetitions || r == 0; ++r) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            table_::functions[key](args...);
+            double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (r == 0 || t < best)
+                best = t;
+        }
+        times[key] = best;
+    }
+    return times;
+}
+
+template<typename Space, typename Kernel, typename... Args>
+std::size_t autotune(unsigned repetitions, Args&&... args) {
+    std::vector<double> times = autotune_times<Space, Kernel>(repetitions, args...);
+    std::size_t best = 0;
+    for (std::size_t key = 1; key < times.size(); ++key) {
+        if (times[key] < times[best])
+            best = key;
+    }
+    return best;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// autotune_cached<Space, Kernel>(cacheFile, name, args...) returns the key
+// cached in /cacheFile/ for tuner /name/ on this CPU model, if there is a
+// valid one. Otherwise it runs autotune() and records the winner in
+// /cacheFile/, replacing any previous entry for /name/ on this CPU model.
+// /name/ should identify the kernel and its space, and should change when
+// the candidates change. Cache file errors are not fatal: if the file can't
+// be read or written, the result is simply not cached.
+//
+// autotune() runs 5 repetitions, or the number given with
+// autotune_cached<Space, Kernel>(cacheFile, name, autotune_repetitions{n}, args...).
+//
+// /name/ must be non-empty and must not contain whitespace or control
+// characters. Otherwise the cache is neither read nor written: the key is
+// tuned on every call.
+//
+// The cache file is text, one entry per line:
+//
+//   <name> TAB <cpu model> TAB <Space::size> TAB <key>
+//
+// A new file is written under a name unique to the process and call, and
+// then renamed over /cacheFile/ (with MoveFileExA on Windows, where
+// std::rename can't replace an existing file), so readers never see a
+// partial file.
+// Concurrent tuners don't corrupt the file, but the last rename wins, so an
+// entry written at the same time by another process may be lost (and is
+// tuned again later).
+
+struct autotune_result {
+    std::size_t key;
+    bool cached; // true if /key/ was loaded from the cache file
+};
+
+struct autotune_repetitions {
+    unsigned count;
+};
+
+namespace detail {
+
+struct tune_cache_entry_ {
+    std::string name, cpu;
+    std::size_t size, key;
+};
+
+inline bool parse_tune_cache_line_(const std::string& line, tune_cache_entry_& entry) {
+    std::istringstream fields(line);
+    std::string size, key;
+    if (!std::getline(fields, entry.name, '\t') || !std::getline(fields, entry.cpu, '\t')
+            || !std::getline(fields, size, '\t') || !std::getline(fields, key))
+        return false;
+
+    char *end = nullptr;
+    entry.size = static_cast<std::size_t>(std::strtoul(size.c_str(), &end, 10));
+    if (size.empty() || *end != '\0')
+        return false;
+    entry.key = static_cast<std::size_t>(std::strtoul(key.c_str(), &end, 10));
+    return !key.empty() && *end == '\0';
+}
+
+// a tuner name can be stored in the cache file: no whitespace or control characters
+inline bool valid_tune_name_(const std::string& name) {
+    if (name.empty())
+        return false;
+    for (char c : name) {
+        const unsigned char u = static_cast<unsigned char>(c);
+        if (u <= ' ' || u == 0x7f)
+            return false;
+    }
+    return true;
+}
+
+} // end namespace detail
+
+template<typename Space, typename Kernel, typename... Args>
+autotune_result autotune_cached(const std::string& cacheFile, const std::string& name,
+        autotune_repetitions repetitions, Args&&... args) {
+    if (!detail::valid_tune_name_(name)) {
+        autotune_result result = { autotune<Space, Kernel>(repetitions.count, args...), false };
+        return result;
+    }
+
+    const std::string cpu = cpu_model();
+
+    // keep every other line as is
+    std::vector<std::string> lines;
+    {
+        std::ifstream in(cacheFile.c_str());
+        std::string line;
+        while (std::getline(in, line)) {
+            detail::tune_cache_entry_ entry;
+            if (detail::parse_tune_cache_line_(line, entry) && entry.name == name && entry.cpu == cpu) {
+                if (entry.size == Space::size && entry.key < Space::size) {
+                    autotune_result result = { entry.key, true };
+                    return result;
+                }
+                continue; // stale: drop it
+            }
+            lines.push_back(line);
+        }
+    }
+
+    autotune_result result = { autotune<Space, Kernel>(repetitions.count, args...), false };
+
+    std::ostringstream entry;
+    entry << name << '\t' << cpu << '\t' << Space::size << '\t' << result.key;
+    lines.push_back(entry.str());
+
+    // write a new file, then replace the old one, so that readers never see a partial file
+    const std::string temp = detail::temp_file_name_(cacheFile);
+    std::ofstream out(temp.c_str(), std::ios::trunc);
+    for (const std::string& line : lines)
+        out << line << '\n';
+    out.close();
+    if (!out)
+        std::remove(temp.c_str());
+    else
+        detail::replace_file_(temp, cacheFile);
+
+    return result;
+}
+
+template<typename Space, typename Kernel, typename... Args>
+autotune_result autotune_cached(const std::string& cacheFile, const std::string& name, Args&&... args) {
+    return autotune_cached<Space, Kernel>(cacheFile, name, autotune_repetitions{ 5 }, args...);
+}
+
+} // end namespace staticmode
+
+#endif /* INCLUDED_STATICMODETUNE_H */
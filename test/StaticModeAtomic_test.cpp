@@ -0,0 +1,210 @@
+//!clang++ -std=c++11 -Weverything -Wno-c++98-compat -Wno-unused-const-variable -Wno-exit-time-destructors StaticModeAtomic_test.cpp -DCATCH_CONFIG_MAIN -I../include -I./Catch -pthread -o atomic_test.out && ./atomic_test.out
+
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+#include "StaticModeAtomic.h"
+
+using namespace staticmode;
+
+namespace {
+
+    enum class Shape { point, pair, quad };
+    enum class Wide { no, yes };
+
+    constexpr Mode<Shape, Shape::quad> quad_;
+    constexpr Mode<Wide, Wide::yes> wide_;
+
+    using Shapes = ModeCategory<Shape, Shape::point, Shape::pair, Shape::quad>;
+    using Wides = ModeCategory<Wide, Wide::no, Wide::yes>;
+
+    using TestSpace = ModeSpace<Shapes, Wides>;
+
+    // A kernel returning its packed key plus an offset
+    struct KeyKernel {
+        template<typename ModeExpr>
+        static std::size_t apply(std::size_t offset) { return ModeExpr::key + offset; }
+    };
+
+    struct OtherKernel {
+        template<typename ModeExpr>
+        static std::size_t apply(std::size_t offset) { return ModeExpr::key * 10 + offset; }
+    };
+
+    using KeyFunction = atomic_mode_function<std::size_t(std::size_t), Shapes, Wides>;
+
+    // A stateful object that counts live instances
+    struct Counted {
+        static std::atomic<int> liveCount;
+
+        std::size_t key;
+
+        explicit Counted(std::size_t k) : key(k) { ++liveCount; }
+        ~Counted() { --liveCount; }
+    };
+
+    std::atomic<int> Counted::liveCount(0);
+
+} // end anonymous namespace
+
+TEST_CASE("StaticModeAtomic/atomic_mode_function", "atomic_mode_function publishes static dispatch entries") {
+
+    KeyFunction f;
+    REQUIRE(!f.load());
+
+    f.store<KeyKernel>(quad_ | wide_);
+    std::size_t quadWide = packed_key<TestSpace, decltype(quad_ | wide_)>::value;
+    REQUIRE(f.load().key() == quadWide);
+    REQUIRE(f(100) == quadWide + 100);
+
+    f.store<OtherKernel>(Shape::pair, Wide::no);
+    REQUIRE(f.load().key() == 1);
+    REQUIRE(f(3) == 13);
+
+    f.store<KeyKernel>(5);
+    REQUIRE(f(0) == 5);
+
+    // entries are shared static objects, bound like mode_function::bind()
+    KeyFunction g;
+    g.store<KeyKernel>(5);
+    REQUIRE(g.load().target() == f.load().target());
+    REQUIRE(f.load().target() == KeyFunction::function_type::bind<KeyKernel>(5).target());
+}
+
+TEST_CASE("StaticModeAtomic/atomic_mode_function/try_store", "try_store() rejects invalid keys and values, leaving the active entry") {
+
+    KeyFunction f;
+    REQUIRE(!f.try_store<KeyKernel>(TestSpace::size));
+    REQUIRE(!f.load()); // still unbound
+
+    REQUIRE(f.try_store<KeyKernel>(4));
+    REQUIRE(f(0) == 4);
+
+    REQUIRE(!f.try_store<OtherKernel>(TestSpace::size));
+    REQUIRE(!f.try_store<OtherKernel>(std::size_t(-1)));
+    REQUIRE(!f.try_store<OtherKernel>(static_cast<Shape>(7), Wide::no));
+    REQUIRE(!f.try_store<OtherKernel>(Shape::pair, static_cast<Wide>(2)));
+    REQUIRE(f.load().key() == 4); // unchanged
+    REQUIRE(f(0) == 4);
+
+    REQUIRE(f.try_store<OtherKernel>(Shape::pair, Wide::no));
+    REQUIRE(f(3) == 13);
+}
+
+TEST_CASE("StaticModeAtomic/atomic_mode_function/threads", "readers always see a consistent key and function") {
+
+    KeyFunction f;
+    f.store<KeyKernel>(0);
+
+    std::atomic<bool> done(false);
+    std::atomic<std::size_t> inconsistent(0);
+
+    std::thread reader([&f, &done, &inconsistent]() {
+        while (!done.load(std::memory_order_relaxed)) {
+            KeyFunction::function_type entry = f.load();
+            if (entry(0) != entry.key() && entry(0) != entry.key() * 10)
+                ++inconsistent;
+        }
+    });
+
+    for (std::size_t i = 0; i < 20000; ++i) {
+        if (i % 2)
+            f.store<KeyKernel>(i % TestSpace::size);
+        else
+            f.store<OtherKernel>(i % TestSpace::size);
+    }
+    done = true;
+    reader.join();
+
+    REQUIRE(inconsistent == 0);
+}
+
+TEST_CASE("StaticModeAtomic/hot_swap/reclamation", "hot_swap deletes retired objects after the reader is quiescent") {
+
+    {
+        hot_swap<Counted> s(std::unique_ptr<Counted>(new Counted(1)));
+        REQUIRE(s.get()->key == 1);
+
+        // the reader hasn't been quiescent since the swap: the old object is pending
+        Counted *old = s.get();
+        s.publish(std::unique_ptr<Counted>(new Counted(2)));
+        REQUIRE(s.get()->key == 2);
+        REQUIRE(old->key == 1);
+        REQUIRE(Counted::liveCount == 2);
+        REQUIRE(s.collect() == 1);
+
+        s.quiescent();
+        REQUIRE(s.collect() == 0);
+        REQUIRE(Counted::liveCount == 1);
+
+        // retired objects accumulate while the reader is busy
+        s.publish(std::unique_ptr<Counted>(new Counted(3)));
+        s.publish(std::unique_ptr<Counted>(new Counted(4)));
+        REQUIRE(Counted::liveCount == 3);
+
+        s.quiescent();
+        s.publish(std::unique_ptr<Counted>(new Counted(5))); // collects 2 and 3, retires 4
+        REQUIRE(Counted::liveCount == 2);
+        REQUIRE(s.get()->key == 5);
+    }
+
+    REQUIRE(Counted::liveCount == 0);
+}
+
+TEST_CASE("StaticModeAtomic/hot_swap/threads", "the reader never sees a deleted object") {
+
+    {
+        hot_swap<Counted> s(std::unique_ptr<Counted>(new Counted(0)));
+
+        std::atomic<bool> done(false);
+        std::atomic<std::size_t> bad(0);
+
+        std::thread reader([&s, &done, &bad]() {
+            while (!done.load(std::memory_order_relaxed)) {
+                Counted *c = s.get();
+                std::size_t key = c->key;
+                std::this_thread::yield();
+                if (c->key != key) // would read a deleted (or reused) object
+                    ++bad;
+                s.quiescent();
+            }
+        });
+
+        for (std::size_t i = 1; i <= 2000; ++i) {
+            s.publish(std::unique_ptr<Counted>(new Counted(i)));
+            if (i % 100 == 0)
+                std::this_thread::yield();
+        }
+        done = true;
+        reader.join();
+
+        REQUIRE(bad == 0);
+    }
+
+    REQUIRE(Counted::liveCount == 0);
+}
@@ -0,0 +1,192 @@
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Codegen verification: StaticMode's modes have no runtime representation.
+//
+// This file is not run. It is compiled to assembly at -O2, and
+// StaticModeCodegen_check.cmake checks that each function
+// codegen_<case>_modes compiles to the same instructions as the hand-written
+// codegen_<case>_direct: no mode objects, no stores of them, no extra
+// arguments. Calls to extern "C" functions must match exactly; calls to
+// C++ functions (mangled names) are compared without their names, because
+// the instantiations of a template and the hand-written functions have
+// different names.
+
+#include <type_traits>
+
+#include "StaticMode.h"
+
+using namespace staticmode;
+
+// A function that is not inlined, and not specialized for its callers
+// (e.g. by GCC's IPA-SRA removing unused parameters), so that calls to it
+// follow the ABI.
+#if defined(__clang__)
+#define CODEGEN_OUT_OF_LINE __attribute__((noinline))
+#else
+#define CODEGEN_OUT_OF_LINE __attribute__((noipa))
+#endif
+
+// Opaque primitives, so the compiler can't optimize the calls away
+extern "C" {
+    void plotDotted(int x, int y);
+    void plotDashed(int x, int y);
+    void plotSolid(int x, int y);
+    void plotArrows(int x, int y);
+    void plotCircles(int x, int y);
+}
+
+enum class LineStyle { dotted, dashed, solid };
+
+constexpr Mode<LineStyle, LineStyle::dotted> dotted;
+constexpr Mode<LineStyle, LineStyle::dashed> dashed;
+constexpr Mode<LineStyle, LineStyle::solid> solid;
+
+enum class EndStyle { no_ends, arrows, circles };
+
+constexpr Mode<EndStyle, EndStyle::no_ends> no_ends;
+constexpr Mode<EndStyle, EndStyle::arrows> arrows;
+constexpr Mode<EndStyle, EndStyle::circles> circles;
+
+// The empty-struct guarantee that the cases below depend on
+static_assert(std::is_empty<decltype(dashed)>::value, "Mode must be empty.");
+static_assert(std::is_empty<decltype(dashed | arrows)>::value, "ModeSet must be empty.");
+static_assert(std::is_empty<get_mode_t<LineStyle, decltype(arrows), decltype(solid)> >::value, "get_mode_t must be an empty Mode.");
+
+// ............................................................................
+// The library code: drawLine() as in the talk and the examples
+
+namespace lib {
+
+    inline void drawBody_(decltype(dotted), int x, int y) { plotDotted(x, y); }
+    inline void drawBody_(decltype(dashed), int x, int y) { plotDashed(x, y); }
+    inline void drawBody_(decltype(solid), int x, int y) { plotSolid(x, y); }
+
+    inline void drawEnds_(decltype(no_ends), int, int) {}
+    inline void drawEnds_(decltype(arrows), int x, int y) { plotArrows(x, y); }
+    inline void drawEnds_(decltype(circles), int x, int y) { plotCircles(x, y); }
+
+    template<typename ModeExpr>
+    inline void drawLine(int x, int y, ModeExpr) {
+        drawBody_(get_mode_t<LineStyle, ModeExpr, decltype(solid)>{}, x, y);
+        drawEnds_(get_mode_t<EndStyle, ModeExpr, decltype(no_ends)>{}, x, y);
+    }
+
+    // modes forwarded through another layer
+    template<typename ModeExpr>
+    inline void drawTwoLines(int x, int y, ModeExpr modes) {
+        drawLine(x, y, modes);
+        drawLine(y, x, modes);
+    }
+
+    // an out-of-line function taking modes by value: the modes must not
+    // take an argument register or stack slot
+    template<typename ModeExpr>
+    CODEGEN_OUT_OF_LINE void drawLineOutOfLine(int x, ModeExpr modes, int y) {
+        drawLine(x, y, modes);
+    }
+
+    class Painter {
+    public:
+        explicit Painter(int origin) : origin_(origin) {}
+
+        template<typename ModeExpr>
+        void drawLine(int x, ModeExpr modes) const { lib::drawLine(origin_ + x, origin_, modes); }
+
+    private:
+        int origin_;
+    };
+
+} // end namespace lib
+
+// the hand-written equivalents
+
+namespace direct {
+
+    CODEGEN_OUT_OF_LINE void drawDottedCirclesOutOfLine(int x, int y) {
+        plotDotted(x, y);
+        plotCircles(x, y);
+    }
+
+    class Painter {
+    public:
+        explicit Painter(int origin) : origin_(origin) {}
+
+        void drawDashedCircles(int x) const {
+            int x0 = origin_ + x, y0 = origin_;
+            plotDashed(x0, y0);
+            plotCircles(x0, y0);
+        }
+
+    private:
+        int origin_;
+    };
+
+} // end namespace direct
+
+// ............................................................................
+// Cases
+
+extern "C" {
+
+// the example from the talk
+void codegen_two_modes_modes(int x, int y) { lib::drawLine(x, y, dashed | arrows); }
+void codegen_two_modes_direct(int x, int y) { plotDashed(x, y); plotArrows(x, y); }
+
+// ModeSet order doesn't matter
+void codegen_reordered_modes(int x, int y) { lib::drawLine(x, y, arrows | dashed); }
+void codegen_reordered_direct(int x, int y) { plotDashed(x, y); plotArrows(x, y); }
+
+// a single Mode, and get_mode_t's default for the other category
+void codegen_default_mode_modes(int x, int y) { lib::drawLine(x, y, circles); }
+void codegen_default_mode_direct(int x, int y) { plotSolid(x, y); plotCircles(x, y); }
+
+// a mode that selects an empty overload
+void codegen_no_ends_modes(int x, int y) { lib::drawLine(x, y, dotted | no_ends); }
+void codegen_no_ends_direct(int x, int y) { plotDotted(x, y); }
+
+// modes passed through two layers of inline functions
+void codegen_forwarded_modes(int x, int y) { lib::drawTwoLines(x, y, solid | circles); }
+void codegen_forwarded_direct(int x, int y) { plotSolid(x, y); plotCircles(x, y); plotSolid(y, x); plotCircles(y, x); }
+
+// a call to an out-of-line function with a ModeSet parameter between two ints
+void codegen_out_of_line_call_modes(int x, int y) { lib::drawLineOutOfLine(x, dotted | circles, y); }
+void codegen_out_of_line_call_direct(int x, int y) { direct::drawDottedCirclesOutOfLine(x, y); }
+
+// a member function template with a mode parameter
+void codegen_member_modes(const lib::Painter& p, int x) { p.drawLine(x, dashed | circles); }
+void codegen_member_direct(const direct::Painter& p, int x) { p.drawDashedCircles(x); }
+
+// PackedModes: a compact mode expression from a packed key
+struct CodegenSpace : ModeSpace<ModeCategory<LineStyle, LineStyle::dotted, LineStyle::dashed, LineStyle::solid>,
+                                ModeCategory<EndStyle, EndStyle::no_ends, EndStyle::arrows, EndStyle::circles> > {};
+
+void codegen_packed_modes(int x, int y) { lib::drawLine(x, y, PackedModes<CodegenSpace, CodegenSpace::key(LineStyle::solid, EndStyle::arrows)>{}); }
+void codegen_packed_direct(int x, int y) { plotSolid(x, y); plotArrows(x, y); }
+
+static_assert(std::is_empty<PackedModes<CodegenSpace, 0> >::value, "PackedModes must be empty.");
+
+// the body of a function with a ModeSet parameter between two ints: the
+// ModeSet uses no register, so /y/ arrives in the second argument register
+CODEGEN_OUT_OF_LINE void codegen_out_of_line_body_modes(int x, decltype(dotted | circles) modes, int y) { lib::drawLine(x, y, modes); }
+CODEGEN_OUT_OF_LINE void codegen_out_of_line_body_direct(int x, int y) { plotDotted(x, y); plotCircles(x, y); }
+
+} // extern "C"
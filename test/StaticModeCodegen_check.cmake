@@ -0,0 +1,78 @@
+# Checks the assembly of StaticModeCodegen.cpp (see that file).
+#
+# cmake -DSOURCE=<StaticModeCodegen.cpp> -DASM=<StaticModeCodegen.s> -P StaticModeCodegen_check.cmake
+#
+# Every function codegen_<case>_modes defined in SOURCE must compile to the
+# same instructions as codegen_<case>_direct. Instructions are compared after
+# removing directives and comments, and normalizing local labels (.L*) and
+# the names of C++ functions (_Z*). Supports ELF assembly from GCC and Clang.
+
+if (NOT SOURCE OR NOT ASM)
+  message(FATAL_ERROR "usage: cmake -DSOURCE=<file.cpp> -DASM=<file.s> -P StaticModeCodegen_check.cmake")
+endif()
+
+# the cases defined in the source
+file(STRINGS ${SOURCE} source_lines REGEX "void codegen_[A-Za-z0-9_]+_modes\\(")
+set(cases "")
+foreach(line IN LISTS source_lines)
+  string(REGEX REPLACE "^.*void codegen_([A-Za-z0-9_]+)_modes\\(.*$" "\\1" name "${line}")
+  list(APPEND cases ${name})
+endforeach()
+list(LENGTH cases case_count)
+if (case_count EQUAL 0)
+  message(FATAL_ERROR "No codegen_<case>_modes functions found in ${SOURCE}")
+endif()
+
+# the normalized instructions of each codegen_ function in the assembly
+file(STRINGS ${ASM} asm_lines)
+set(current "")
+foreach(line IN LISTS asm_lines)
+  if (line MATCHES "^([A-Za-z_][A-Za-z0-9_.$]*):")
+    set(label ${CMAKE_MATCH_1})
+    if (label MATCHES "^codegen_")
+      set(current ${label})
+      set(body_${current} "")
+      set(found_${current} TRUE)
+    else()
+      set(current "")
+    endif()
+  elseif (NOT current STREQUAL "")
+    if (line MATCHES "^[ \t]*\\.size[ \t]" OR line MATCHES "^[ \t]*\\.cfi_endproc")
+      set(current "")
+    else()
+      string(REGEX REPLACE "[#;].*$" "" line "${line}")
+      string(STRIP "${line}" line)
+      if (line MATCHES "^\\.[A-Za-z0-9_]+:$")
+        set(line ".L:") # local label
+      elseif (line MATCHES "^\\." OR line STREQUAL "")
+        set(line "") # directive
+      endif()
+      if (NOT line STREQUAL "")
+        string(REGEX REPLACE "\\.L[A-Za-z0-9_]+" ".L" line "${line}")
+        string(REGEX REPLACE "_Z[A-Za-z0-9_.$]+" "_Z" line "${line}")
+        string(REGEX REPLACE "[ \t]+" " " line "${line}")
+        string(APPEND body_${current} "    ${line}\n")
+      endif()
+    endif()
+  endif()
+endforeach()
+
+set(failures 0)
+foreach(name IN LISTS cases)
+  set(modes codegen_${name}_modes)
+  set(direct codegen_${name}_direct)
+  if (NOT found_${modes} OR NOT found_${direct})
+    message(SEND_ERROR "${name}: ${modes} or ${direct} not found in ${ASM}")
+    math(EXPR failures "${failures} + 1")
+  elseif (NOT body_${modes} STREQUAL body_${direct})
+    message(SEND_ERROR "${name}: ${modes} differs from ${direct}\n${modes}:\n${body_${modes}}${direct}:\n${body_${direct}}")
+    math(EXPR failures "${failures} + 1")
+  else()
+    message(STATUS "${name}: ok")
+  endif()
+endforeach()
+
+if (failures GREATER 0)
+  message(FATAL_ERROR "${failures} of ${case_count} codegen cases failed")
+endif()
+message(STATUS "${case_count} codegen cases passed")
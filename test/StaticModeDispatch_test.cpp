@@ -0,0 +1,444 @@
+//!clang++ -std=c++11 -Weverything -Wno-c++98-compat -Wno-unused-const-variable -Wno-exit-time-destructors StaticModeDispatch_test.cpp -DCATCH_CONFIG_MAIN -I../include -I./Catch -o dispatch_test.out && ./dispatch_test.out
+
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch.hpp"
+
+#include <cstddef>
+#include <type_traits>
+
+#include "StaticModeDispatch.h"
+
+using namespace staticmode;
+
+namespace {
+
+    enum class Shape { point, pair, quad };
+    enum class Wide { no, yes };
+
+    constexpr Mode<Shape, Shape::pair> pair_;
+    constexpr Mode<Shape, Shape::quad> quad_;
+    constexpr Mode<Wide, Wide::yes> wide_;
+
+    using Shapes = ModeCategory<Shape, Shape::point, Shape::pair, Shape::quad>;
+    using Wides = ModeCategory<Wide, Wide::no, Wide::yes>;
+
+    struct TestSpace : ModeSpace<Shapes, Wides> {};
+
+    template<typename Space, typename ModeExpr>
+    constexpr std::size_t keyOf(ModeExpr) { return packed_key<Space, ModeExpr>::value; }
+
+    constexpr std::size_t elementCount_(Shape s) { return (s == Shape::point) ? 1 : (s == Shape::pair) ? 2 : 4; }
+
+    // A kernel: total size of /count/ shapes
+    struct SizeKernel {
+        template<typename ModeExpr>
+        static std::size_t apply(std::size_t count) {
+            using shape_t = get_mode_t<Shape, ModeExpr, Mode<Shape, Shape::point> >;
+            using wide_t = get_mode_t<Wide, ModeExpr, Mode<Wide, Wide::no> >;
+            return count * elementCount_(shape_t::value) * (wide_t::value == Wide::yes ? 2 : 1);
+        }
+    };
+
+    // A kernel with a reference argument
+    struct KeyKernel {
+        template<typename ModeExpr>
+        static void apply(std::size_t& result) { result = ModeExpr::key; }
+    };
+
+} // end anonymous namespace
+
+TEST_CASE("StaticModeDispatch/mode_function/static", "mode_function is small and trivially copyable") {
+
+    using SizeFunction = mode_function<std::size_t(std::size_t), Shapes, Wides>;
+
+    static_assert(std::is_trivially_copyable<SizeFunction>::value, "");
+    static_assert(sizeof(SizeFunction) == 2 * sizeof(void*), "");
+    static_assert(std::is_same<SizeFunction::key_type, std::uint8_t>::value, "");
+    static_assert(SizeFunction::space_type::size == 6, "");
+
+    constexpr SizeFunction unbound;
+    REQUIRE(!unbound);
+}
+
+TEST_CASE("StaticModeDispatch/mode_function/bind", "mode_function binds kernel instantiations") {
+
+    using SizeFunction = mode_function<std::size_t(std::size_t), Shapes, Wides>;
+    using space_type = SizeFunction::space_type;
+
+    SizeFunction f = SizeFunction::bind<SizeKernel>(Shape::quad, Wide::yes);
+    REQUIRE(f);
+    REQUIRE(f.key() == keyOf<space_type>(quad_ | wide_));
+    REQUIRE(f(3) == 3 * 4 * 2);
+    SizeFunction::function_type expected = &SizeKernel::apply<PackedModes<space_type, keyOf<space_type>(quad_ | wide_)> >;
+    REQUIRE(f.target() == expected);
+
+    SizeFunction g = f; // trivially copyable
+    REQUIRE(g(1) == 8);
+
+    g = SizeFunction::bind<SizeKernel>(pair_);
+    REQUIRE(g(1) == 2);
+    REQUIRE(f(1) == 8);
+
+    for (std::size_t key = 0; key < space_type::size; ++key) {
+        std::size_t result = 99;
+        mode_function<void(std::size_t&), Shapes, Wides>::bind<KeyKernel>(key)(result);
+        REQUIRE(result == key);
+    }
+}
+
+TEST_CASE("StaticModeDispatch/mode_function/try_bind", "try_bind returns an unbound mode_function for invalid input") {
+
+    using SizeFunction = mode_function<std::size_t(std::size_t), Shapes, Wides>;
+    using space_type = SizeFunction::space_type;
+
+    SizeFunction f = SizeFunction::try_bind<SizeKernel>(Shape::quad, Wide::yes);
+    REQUIRE(f);
+    REQUIRE(f.key() == keyOf<space_type>(quad_ | wide_));
+    REQUIRE(f(1) == 8);
+
+    REQUIRE(SizeFunction::try_bind<SizeKernel>(keyOf<space_type>(pair_)).target() == SizeFunction::bind<SizeKernel>(pair_).target());
+
+    // e.g. an enum value read from a config file
+    REQUIRE(!SizeFunction::try_bind<SizeKernel>(static_cast<Shape>(7), Wide::no));
+    REQUIRE(!SizeFunction::try_bind<SizeKernel>(Shape::pair, static_cast<Wide>(-1)));
+    REQUIRE(!SizeFunction::try_bind<SizeKernel>(space_type::size));
+    REQUIRE(!SizeFunction::try_bind<SizeKernel>(static_cast<std::size_t>(-1)));
+}
+
+namespace {
+
+    enum class Color { red, green };
+    using Colors = ModeCategory<Color, Color::red, Color::green>;
+    struct ColorSpace : ModeSpace<Colors> {};
+
+    // Returns the keys it was instantiated for, as a 3-digit decimal number
+    struct KeysKernel3 {
+        template<typename A, typename B, typename C>
+        static std::size_t apply(std::size_t base) { return base + A::key * 100 + B::key * 10 + C::key; }
+    };
+
+    struct KeysKernel2 {
+        template<typename A, typename B>
+        static std::size_t apply() { return A::key * 10 + B::key; }
+    };
+
+} // end anonymous namespace
+
+TEST_CASE("StaticModeDispatch/detail/mixed_radix_", "mixed_radix_") {
+
+    using radix = detail::mixed_radix_<3, 2, 4>;
+
+    static_assert(radix::size == 24, "");
+    static_assert(radix::index(0, 0, 0) == 0, "");
+    static_assert(radix::index(2, 1, 3) == 2 + 3 * (1 + 2 * 3), "");
+    static_assert(radix::valid(2, 1, 3) == true, "");
+    static_assert(radix::valid(2, 2, 3) == false, "");
+    static_assert(radix::digit(radix::index(2, 1, 3), 0) == 2, "");
+    static_assert(radix::digit(radix::index(2, 1, 3), 1) == 1, "");
+    static_assert(radix::digit(radix::index(2, 1, 3), 2) == 3, "");
+
+    static_assert(detail::triangle_row_(0) == 0, "");
+    static_assert(detail::triangle_row_(1) == 1, "");
+    static_assert(detail::triangle_row_(2) == 1, "");
+    static_assert(detail::triangle_row_(3) == 2, "");
+    static_assert(detail::triangle_row_(5) == 2, "");
+    static_assert(detail::triangle_row_(6) == 3, "");
+
+    REQUIRE(true);
+}
+
+TEST_CASE("StaticModeDispatch/multi_dispatch", "multi_dispatch finds the kernel for several runtime keys") {
+
+    using Dispatch = multi_dispatch<KeysKernel3, TestSpace, ColorSpace, TestSpace>;
+
+    static_assert(Dispatch::size == 6 * 2 * 6, "");
+    static_assert(std::is_same<Dispatch::function_type, std::size_t (*)(std::size_t)>::value, "");
+
+    for (std::size_t a = 0; a < TestSpace::size; ++a) {
+        for (std::size_t b = 0; b < ColorSpace::size; ++b) {
+            for (std::size_t c = 0; c < TestSpace::size; ++c) {
+                REQUIRE(Dispatch::find(a, b, c)(1000) == 1000 + a * 100 + b * 10 + c);
+            }
+        }
+    }
+
+    REQUIRE(Dispatch::find(TestSpace::size, 0, 0) == nullptr);
+    REQUIRE(Dispatch::find(0, ColorSpace::size, 0) == nullptr);
+    REQUIRE(Dispatch::find(0, 0, TestSpace::size) == nullptr);
+}
+
+TEST_CASE("StaticModeDispatch/symmetric_dispatch", "symmetric_dispatch only instantiates ordered pairs") {
+
+    using Dispatch = symmetric_dispatch<KeysKernel2, TestSpace>;
+
+    static_assert(Dispatch::size == 6 * 7 / 2, "");
+
+    for (std::size_t a = 0; a < TestSpace::size; ++a) {
+        for (std::size_t b = 0; b < TestSpace::size; ++b) {
+            std::size_t lo = (a < b) ? a : b;
+            std::size_t hi = (a < b) ? b : a;
+            REQUIRE(Dispatch::find(a, b)() == lo * 10 + hi);
+            REQUIRE(Dispatch::find(a, b) == Dispatch::find(b, a));
+        }
+    }
+
+    REQUIRE(Dispatch::find(0, TestSpace::size) == nullptr);
+    REQUIRE(Dispatch::find(TestSpace::size, 0) == nullptr);
+}
+
+namespace {
+
+    // A function object returning the packed key of its argument
+    struct KeyOf {
+        template<typename ModeExpr>
+        std::size_t operator()(ModeExpr) const { return ModeExpr::key; }
+    };
+
+} // end anonymous namespace
+
+TEST_CASE("StaticModeDispatch/dispatch", "dispatch calls a function object with the PackedModes for a runtime key") {
+
+    for (std::size_t key = 0; key < TestSpace::size; ++key) {
+        REQUIRE(dispatch<TestSpace>(key, KeyOf{}) == key);
+    }
+
+    KeyOf f;
+    REQUIRE(dispatch<TestSpace>(5, f) == 5);
+}
+
+namespace {
+
+    // A bucket kernel: out[i] = size of in[i] shapes, and count calls per key
+    struct BucketSizeKernel {
+        template<typename ModeExpr>
+        static void apply(std::size_t first, std::size_t last, const std::size_t *in, std::size_t *out, std::size_t *calls) {
+            ++calls[ModeExpr::key];
+            for (std::size_t i = first; i < last; ++i)
+                out[i] = SizeKernel::apply<ModeExpr>(in[i]);
+        }
+    };
+
+} // end anonymous namespace
+
+TEST_CASE("StaticModeDispatch/mode_batch", "mode_batch runs a kernel once per bucket of items with the same key") {
+
+    const std::size_t count = 100;
+    std::size_t keys[count];
+    std::size_t values[count];
+    for (std::size_t i = 0; i < count; ++i) {
+        keys[i] = (i * 7) % 5; // key 5 is never used
+        values[i] = i;
+    }
+
+    mode_batch<TestSpace> batch;
+    batch.partition(count, [&keys](std::size_t i) { return keys[i]; });
+
+    REQUIRE(batch.size() == count);
+    REQUIRE(batch.bucket_begin(0) == 0);
+    REQUIRE(batch.bucket_end(4) == count);
+    REQUIRE(batch.bucket_size(5) == 0);
+
+    // buckets are contiguous, ascending by key, and stable
+    for (std::size_t k = 0; k < TestSpace::size; ++k) {
+        for (std::size_t j = batch.bucket_begin(k); j < batch.bucket_end(k); ++j) {
+            REQUIRE(keys[batch.order()[j]] == k);
+            if (j > batch.bucket_begin(k))
+                REQUIRE(batch.order()[j - 1] < batch.order()[j]);
+        }
+    }
+
+    std::size_t sortedValues[count];
+    std::size_t sortedResults[count];
+    std::size_t results[count];
+    std::size_t calls[TestSpace::size] = {};
+
+    batch.gather(values, sortedValues);
+    batch.for_each_bucket<BucketSizeKernel>(sortedValues, sortedResults, calls);
+    batch.scatter(sortedResults, results);
+
+    for (std::size_t k = 0; k < TestSpace::size; ++k)
+        REQUIRE(calls[k] == (k < 5 ? 1u : 0u));
+
+    for (std::size_t i = 0; i < count; ++i)
+        REQUIRE(results[i] == (multi_dispatch<SizeKernel, TestSpace>::find(keys[i])(values[i])));
+
+    // a second, smaller batch reuses the object
+    batch.partition(3, [](std::size_t i) { return 5 - i; });
+    REQUIRE(batch.size() == 3);
+    REQUIRE(batch.bucket_size(0) == 0);
+    REQUIRE(batch.bucket_size(5) == 1);
+    REQUIRE(batch.order()[0] == 2);
+    REQUIRE(batch.order()[2] == 0);
+    REQUIRE(batch.rejected_begin() == 3);
+}
+
+TEST_CASE("StaticModeDispatch/mode_batch/rejected", "mode_batch puts items with out-of-range keys in a reject bucket") {
+
+    const std::size_t count = 6;
+    const std::size_t keys[count] = { 3, TestSpace::size, 1, std::size_t(-1), 3, TestSpace::size + 100 };
+    std::size_t values[count];
+    for (std::size_t i = 0; i < count; ++i)
+        values[i] = i;
+
+    mode_batch<TestSpace> batch;
+    REQUIRE(batch.partition(count, [&keys](std::size_t i) { return keys[i]; }) == 3);
+
+    REQUIRE(batch.size() == count);
+    REQUIRE(batch.bucket_size(1) == 1);
+    REQUIRE(batch.bucket_size(3) == 2);
+    REQUIRE(batch.bucket_end(TestSpace::size - 1) == 3);
+    REQUIRE(batch.rejected_begin() == 3);
+    REQUIRE(batch.order()[3] == 1); // in order
+    REQUIRE(batch.order()[4] == 3);
+    REQUIRE(batch.order()[5] == 5);
+
+    // the kernel only sees the valid items
+    std::size_t sortedValues[count];
+    std::size_t sortedResults[count] = {};
+    std::size_t calls[TestSpace::size] = {};
+    batch.gather(values, sortedValues);
+    batch.for_each_bucket<BucketSizeKernel>(sortedValues, sortedResults, calls);
+    for (std::size_t k = 0; k < TestSpace::size; ++k)
+        REQUIRE(calls[k] == (k == 1 || k == 3 ? 1u : 0u));
+
+    // a batch of rejected items only
+    REQUIRE(batch.partition(2, [](std::size_t) { return TestSpace::size; }) == 2);
+    REQUIRE(batch.rejected_begin() == 0);
+    REQUIRE(batch.bucket_size(0) == 0);
+    REQUIRE(batch.order()[1] == 1);
+}
+
+namespace {
+
+    // Per-element kernels
+    struct ElementSizeKernel {
+        template<typename ModeExpr>
+        static std::size_t apply(int count) { return SizeKernel::apply<ModeExpr>(static_cast<std::size_t>(count)); }
+    };
+
+    struct ScaleInPlaceKernel {
+        template<typename ModeExpr>
+        static void apply(std::size_t& x) { x = SizeKernel::apply<ModeExpr>(x); }
+    };
+
+} // end anonymous namespace
+
+TEST_CASE("StaticModeDispatch/dispatch_elements", "dispatch_elements applies a per-element kernel to a block") {
+
+    const std::size_t count = 10;
+    int in[count];
+    for (std::size_t i = 0; i < count; ++i)
+        in[i] = static_cast<int>(i);
+
+    for (std::size_t key = 0; key < TestSpace::size; ++key) {
+        std::size_t out[count] = {};
+        dispatch_elements<TestSpace, ElementSizeKernel>(key, in, out, count);
+
+        std::size_t data[count];
+        for (std::size_t i = 0; i < count; ++i)
+            data[i] = i;
+        dispatch_elements<TestSpace, ScaleInPlaceKernel>(key, data, count);
+
+        std::size_t scale = multi_dispatch<SizeKernel, TestSpace>::find(key)(1);
+        for (std::size_t i = 0; i < count; ++i) {
+            REQUIRE(out[i] == i * scale);
+            REQUIRE(data[i] == i * scale);
+        }
+    }
+
+    // empty blocks are allowed
+    dispatch_elements<TestSpace, ElementSizeKernel>(0, in, static_cast<std::size_t*>(nullptr), 0);
+}
+
+namespace {
+
+    // Block kernel: scales and accumulates a running sum, which carries over
+    // from one block to the next through /sum/
+    struct RunningSumKernel {
+        template<typename ModeExpr>
+        static void apply(const int *in, std::size_t count, std::size_t *out, std::size_t offset, std::size_t& sum) {
+            for (std::size_t i = 0; i < count; ++i) {
+                sum += SizeKernel::apply<ModeExpr>(static_cast<std::size_t>(in[i]));
+                out[i] = sum + offset;
+            }
+        }
+    };
+
+} // end anonymous namespace
+
+TEST_CASE("StaticModeDispatch/dispatch_block", "dispatch_block passes the block, parameters and state to a block kernel") {
+
+    const std::size_t count = 10;
+    int in[count];
+    for (std::size_t i = 0; i < count; ++i)
+        in[i] = static_cast<int>(i);
+
+    for (std::size_t key = 0; key < TestSpace::size; ++key) {
+        const std::size_t scale = multi_dispatch<SizeKernel, TestSpace>::find(key)(1);
+
+        std::size_t out[count] = {};
+        std::size_t sum = 0;
+        dispatch_block<TestSpace, RunningSumKernel>(key, in, 4, out, std::size_t(1000), sum); // two blocks
+        dispatch_block<TestSpace, RunningSumKernel>(key, in + 4, count - 4, out + 4, std::size_t(1000), sum);
+
+        std::size_t expected = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            expected += i * scale;
+            REQUIRE(out[i] == expected + 1000);
+        }
+        REQUIRE(sum == expected);
+    }
+}
+
+#if __cplusplus >= 201703L
+
+TEST_CASE("StaticModeDispatch/to_variant/category", "to_variant converts a runtime category value to a std::variant of Modes") {
+
+    static_assert(std::is_same<to_variant_t<Shapes>,
+        std::variant<Mode<Shape, Shape::point>, Mode<Shape, Shape::pair>, Mode<Shape, Shape::quad> > >::value, "");
+
+    auto v = to_variant<Shapes>(Shape::quad);
+    REQUIRE(v.index() == 2);
+    bool holdsQuad = std::holds_alternative<Mode<Shape, Shape::quad> >(v);
+    REQUIRE(holdsQuad);
+    REQUIRE(std::visit([](auto mode) { return elementCount_(mode.value); }, v) == 4);
+
+    REQUIRE(to_variant<Wides>(Wide::no).index() == 0);
+    REQUIRE(to_variant<Wides>(Wide::yes).index() == 1);
+}
+
+TEST_CASE("StaticModeDispatch/to_variant/space", "to_variant converts a packed key to a std::variant of normalized ModeSets") {
+
+    static_assert(std::variant_size<to_variant_t<TestSpace> >::value == TestSpace::size, "");
+    static_assert(std::is_same<std::variant_alternative_t<keyOf<TestSpace>(pair_ | wide_), to_variant_t<TestSpace> >,
+        normalize_t<TestSpace, decltype(pair_ | wide_)> >::value, "");
+
+    for (std::size_t key = 0; key < TestSpace::size; ++key) {
+        auto v = to_variant<TestSpace>(key);
+        REQUIRE(v.index() == key);
+        REQUIRE(std::visit([](auto modes) { return packed_key<TestSpace, decltype(modes)>::value; }, v) == key);
+        REQUIRE(std::visit([](auto modes) { return SizeKernel::apply<decltype(modes)>(1); }, v) == (multi_dispatch<SizeKernel, TestSpace>::find(key)(1)));
+    }
+}
+
+#endif /* __cplusplus >= 201703L */
@@ -0,0 +1,670 @@
+//!clang++ -std=c++11 -Weverything -Wno-c++98-compat -Wno-unused-const-variable -Wno-exit-time-destructors StaticModeErasure_test.cpp -DCATCH_CONFIG_MAIN -I../include -I./Catch -o erasure_test.out && ./erasure_test.out
+
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch.hpp"
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "StaticModeErasure.h"
+
+using namespace staticmode;
+
+namespace {
+
+    enum class Shape { point, pair, quad };
+    enum class Wide { no, yes };
+
+    using Shapes = ModeCategory<Shape, Shape::point, Shape::pair, Shape::quad>;
+    using Wides = ModeCategory<Wide, Wide::no, Wide::yes>;
+
+    struct TestSpace : ModeSpace<Shapes, Wides> {};
+
+    // Count heap allocations of the test payloads, to check that mode_holder
+    // and make_flyweight don't allocate. mode_holder constructs in place with
+    // ::new (p) T, which doesn't call these.
+
+    std::size_t allocationCount_ = 0;
+
+    struct CountsAllocations {
+        static void *operator new(std::size_t size) {
+            ++allocationCount_;
+            return ::operator new(size);
+        }
+
+        static void operator delete(void *p) noexcept { ::operator delete(p); }
+    };
+
+    struct TestBase : CountsAllocations {
+        static int liveCount;
+
+        TestBase() { ++liveCount; }
+        TestBase(const TestBase&) noexcept { ++liveCount; }
+        virtual ~TestBase();
+
+        virtual std::size_t key() const = 0;
+        virtual int value() const = 0;
+    };
+
+    int TestBase::liveCount = 0;
+
+    TestBase::~TestBase() { --liveCount; }
+
+    constexpr std::size_t elementCount_(Shape s) { return (s == Shape::point) ? 1 : (s == Shape::pair) ? 2 : 4; }
+
+    // The size of TestImplT depends on its modes
+    template<typename ModeExpr>
+    struct TestImplT : TestBase {
+        using shape_t = get_mode_t<Shape, ModeExpr, Mode<Shape, Shape::point> >;
+        using wide_t = get_mode_t<Wide, ModeExpr, Mode<Wide, Wide::no> >;
+        using element_t = typename std::conditional<wide_t::value == Wide::yes, long double, char>::type;
+
+        element_t elements[elementCount_(shape_t::value)];
+        int value_;
+
+        explicit TestImplT(int v = 0) : elements(), value_(v) {}
+
+        std::size_t key() const override { return packed_key<TestSpace, ModeExpr>::value; }
+        int value() const override { return value_; }
+    };
+
+    // A type that is not one of the TestImplT instantiations
+    struct OtherImpl : TestBase {
+        std::size_t key() const override { return 99; }
+        int value() const override { return -1; }
+    };
+
+    template<typename ModeExpr>
+    constexpr std::size_t keyOf(ModeExpr) { return packed_key<TestSpace, ModeExpr>::value; }
+
+    using TestHolder = mode_holder<TestBase, TestImplT, TestSpace>;
+
+    constexpr Mode<Shape, Shape::pair> pair_;
+    constexpr Mode<Shape, Shape::quad> quad_;
+    constexpr Mode<Wide, Wide::yes> wide_;
+
+} // end anonymous namespace
+
+TEST_CASE("StaticModeErasure/detail/max_", "max_") {
+
+    static_assert(detail::max_(3) == 3, "");
+    static_assert(detail::max_(3, 7, 5) == 7, "");
+    static_assert(detail::max_(9, 7, 5) == 9, "");
+
+    REQUIRE(true);
+}
+
+TEST_CASE("StaticModeErasure/mode_holder/storage", "mode_holder buffer is sized and aligned for the largest Impl") {
+
+    using largest_t = TestImplT<decltype(quad_ | wide_)>;
+
+    static_assert(TestHolder::capacity == sizeof(largest_t), "");
+    static_assert(TestHolder::alignment == alignof(largest_t), "");
+    static_assert(sizeof(TestHolder) <= sizeof(largest_t) + 2 * sizeof(void*) + alignof(largest_t), "");
+
+    static_assert(std::is_same<TestHolder::impl_t<decltype(wide_ | pair_)>,
+        TestImplT<PackedModes<TestSpace, packed_key<TestSpace, decltype(pair_ | wide_)>::value> > >::value, "");
+
+    REQUIRE(true);
+}
+
+TEST_CASE("StaticModeErasure/mode_holder/construct", "mode_holder holds the configured Impl") {
+
+    REQUIRE(TestBase::liveCount == 0);
+    {
+        TestHolder h0;
+        REQUIRE(h0->key() == 0); // default modes
+        REQUIRE(TestBase::liveCount == 1);
+
+        TestHolder h1(quad_ | wide_);
+        REQUIRE(h1->key() == keyOf(quad_ | wide_));
+        REQUIRE((*h1).key() == h1.get()->key());
+        REQUIRE(TestBase::liveCount == 2);
+
+        const TestHolder h2(pair_);
+        REQUIRE(h2->key() == keyOf(pair_));
+    }
+    REQUIRE(TestBase::liveCount == 0);
+}
+
+TEST_CASE("StaticModeErasure/mode_holder/value-semantics", "mode_holder copies and moves the held object") {
+
+    {
+        TestHolder a(pair_);
+        a.emplace<TestHolder::impl_t<decltype(pair_)> >(42);
+
+        TestHolder b(a); // copy
+        REQUIRE(b->key() == a->key());
+        REQUIRE(b->value() == 42);
+        REQUIRE(b.get() != a.get());
+        REQUIRE(static_cast<const void*>(b.get()) >= static_cast<const void*>(&b)); // in place
+        REQUIRE(static_cast<const void*>(b.get()) < static_cast<const void*>(&b + 1));
+
+        TestHolder c(std::move(b)); // move
+        REQUIRE(c->value() == 42);
+        REQUIRE(TestBase::liveCount == 3); // b still holds its moved-from object
+
+        TestHolder d(wide_);
+        d = a; // copy assign, different type
+        REQUIRE(d->key() == a->key());
+        REQUIRE(d->value() == 42);
+
+        d = TestHolder(quad_); // move assign
+        REQUIRE(d->key() == keyOf(quad_));
+
+        d = d; // self-assignment
+        REQUIRE(d->key() == keyOf(quad_));
+        REQUIRE(TestBase::liveCount == 4);
+    }
+    REQUIRE(TestBase::liveCount == 0);
+}
+
+TEST_CASE("StaticModeErasure/mode_holder/emplace", "mode_holder::emplace replaces the held object") {
+
+    {
+        TestHolder h;
+        h.emplace(quad_);
+        REQUIRE(h->key() == keyOf(quad_));
+
+        OtherImpl& other = h.emplace<OtherImpl>();
+        REQUIRE(&other == h.get());
+        REQUIRE(h->key() == 99);
+
+        TestHolder copy(h); // copies an OtherImpl
+        REQUIRE(copy->key() == 99);
+        REQUIRE(TestBase::liveCount == 2);
+    }
+    REQUIRE(TestBase::liveCount == 0);
+}
+
+TEST_CASE("StaticModeErasure/mode_holder/no-allocation", "mode_holder never allocates") {
+
+    std::size_t before = allocationCount_;
+    bool same = false;
+    {
+        TestHolder a(pair_ | wide_);
+        TestHolder b(a);
+        b.emplace(quad_);
+        a = b;
+        TestHolder c(std::move(a));
+        same = (c->key() == b->key());
+    }
+    std::size_t after = allocationCount_;
+    REQUIRE(same);
+    REQUIRE(after == before);
+}
+
+namespace {
+
+    struct StatelessBase : CountsAllocations {
+        virtual ~StatelessBase();
+        virtual std::size_t key() const = 0;
+    };
+
+    StatelessBase::~StatelessBase() {}
+
+    template<typename ModeExpr>
+    struct StatelessImplT : StatelessBase {
+        std::size_t key() const override { return packed_key<TestSpace, ModeExpr>::value; }
+    };
+
+    struct StatefulImpl : StatelessBase {
+        std::size_t key_;
+        explicit StatefulImpl(std::size_t k = 7) : key_(k) {}
+        std::size_t key() const override { return key_; }
+    };
+
+    struct EmptyType {};
+
+} // end anonymous namespace
+
+TEST_CASE("StaticModeErasure/is_stateless", "is_stateless") {
+
+    static_assert(is_stateless<EmptyType>::value == true, "");
+    static_assert(is_stateless<StatelessImplT<decltype(pair_)> >::value == true, "");
+    static_assert(is_stateless<StatefulImpl>::value == false, "");
+    static_assert(is_stateless<TestImplT<decltype(pair_)> >::value == false, "");
+    static_assert(is_stateless<int>::value == false, "");
+
+    REQUIRE(true);
+}
+
+TEST_CASE("StaticModeErasure/flyweight", "flyweight<T>() returns one shared instance per type") {
+
+    using pair_t = StatelessImplT<decltype(pair_)>;
+    using quad_t = StatelessImplT<decltype(quad_)>;
+
+    REQUIRE(&flyweight<pair_t>() == &flyweight<pair_t>());
+    REQUIRE(static_cast<void*>(&flyweight<pair_t>()) != static_cast<void*>(&flyweight<quad_t>()));
+    REQUIRE(flyweight<quad_t>().key() == keyOf(quad_));
+}
+
+#if !(defined(__cpp_constinit) && __cpp_constinit >= 201907L)
+namespace {
+
+    // a stateless type whose default constructor isn't constexpr (rejected
+    // by constinit under C++20)
+    struct DynamicStatelessImpl : StatelessBase {
+        DynamicStatelessImpl() { ++constructCount; }
+        std::size_t key() const override { return 5; }
+
+        static int constructCount;
+    };
+
+    int DynamicStatelessImpl::constructCount = 0;
+
+} // end anonymous namespace
+
+TEST_CASE("StaticModeErasure/flyweight/first-use", "before C++20, a flyweight without a constexpr constructor is initialized on first use") {
+
+    REQUIRE(DynamicStatelessImpl::constructCount == 0);
+    REQUIRE(flyweight<DynamicStatelessImpl>().key() == 5);
+    REQUIRE(&flyweight<DynamicStatelessImpl>() == &flyweight<DynamicStatelessImpl>());
+    REQUIRE(DynamicStatelessImpl::constructCount == 1);
+}
+#endif
+
+TEST_CASE("StaticModeErasure/make_flyweight", "make_flyweight shares stateless objects and allocates stateful ones") {
+
+    using pair_t = StatelessImplT<decltype(pair_)>;
+
+    std::size_t before = allocationCount_;
+    flyweight_ptr<StatelessBase> a = make_flyweight<StatelessBase, pair_t>();
+    flyweight_ptr<StatelessBase> b = make_flyweight<StatelessBase, pair_t>();
+    std::size_t afterStateless = allocationCount_;
+
+    REQUIRE(afterStateless == before);
+    REQUIRE(a.get() == b.get());
+    REQUIRE(a.get() == &flyweight<pair_t>());
+    REQUIRE(a->key() == keyOf(pair_));
+    REQUIRE(a.get_deleter().owned == false);
+
+    a.reset(); // doesn't delete the flyweight
+    REQUIRE(b->key() == keyOf(pair_));
+
+    flyweight_ptr<StatelessBase> c = make_flyweight<StatelessBase, StatefulImpl>(std::size_t(3));
+    REQUIRE(allocationCount_ == before + 1);
+    REQUIRE(c->key() == 3);
+    REQUIRE(c.get_deleter().owned == true);
+}
+
+namespace {
+
+    struct TestFactory {
+        template<typename ModeExpr>
+        static TestHolder make(int value) {
+            TestHolder result;
+            result.emplace<TestHolder::impl_t<ModeExpr> >(value);
+            return result;
+        }
+    };
+
+    using TestRegistry = mode_registry<TestSpace, TestFactory>;
+
+    struct KeyFactory {
+        template<typename ModeExpr>
+        static std::size_t make() { return ModeExpr::key; }
+    };
+
+    using KeyRegistry = mode_registry<TestSpace, KeyFactory>;
+
+} // end anonymous namespace
+
+TEST_CASE("StaticModeErasure/mode_registry/static", "mode_registry table is built at compile time") {
+
+    static_assert(KeyRegistry::size == TestSpace::size, "");
+    static_assert(std::is_same<KeyRegistry::factory_type, std::size_t (*)()>::value, "");
+    static_assert(KeyRegistry::factories[3] == &KeyFactory::make<PackedModes<TestSpace, 3> >, "");
+    static_assert(KeyRegistry::find(TestSpace::size) == nullptr, "");
+    static_assert(KeyRegistry::find(2) == &KeyFactory::make<PackedModes<TestSpace, 2> >, "");
+
+    REQUIRE(true);
+}
+
+TEST_CASE("StaticModeErasure/mode_registry/build", "mode_registry::build() calls the factory for a runtime key") {
+
+    for (std::size_t key = 0; key < TestSpace::size; ++key) {
+        REQUIRE(KeyRegistry::build(key) == key);
+    }
+
+    {
+        std::size_t key = TestSpace::key(Shape::quad, Wide::yes);
+        TestHolder h = TestRegistry::build(key, 5);
+        REQUIRE(h->key() == keyOf(quad_ | wide_));
+        REQUIRE(h->value() == 5);
+    }
+    REQUIRE(TestBase::liveCount == 0);
+}
+
+namespace {
+
+    // A mode-configured implementation without a base class
+    template<typename ModeExpr>
+    struct VariantImplT {
+        static int liveCount;
+
+        using shape_t = get_mode_t<Shape, ModeExpr, Mode<Shape, Shape::point> >;
+
+        int value_;
+
+        VariantImplT() : value_(0) { ++liveCount; }
+        VariantImplT(const VariantImplT& rhs) noexcept : value_(rhs.value_) { ++liveCount; }
+        ~VariantImplT() { --liveCount; }
+
+        std::size_t elementCount() const { return elementCount_(shape_t::value); }
+    };
+
+    template<typename ModeExpr>
+    int VariantImplT<ModeExpr>::liveCount = 0;
+
+    using TestVariant = mode_variant<VariantImplT, decltype(pair_), decltype(quad_ | wide_), ModeSet<> >;
+
+    int variantLiveCount() {
+        return TestVariant::alternative_t<0>::liveCount + TestVariant::alternative_t<1>::liveCount
+            + TestVariant::alternative_t<2>::liveCount;
+    }
+
+    struct ElementCount {
+        template<typename T>
+        std::size_t operator()(const T& impl) const { return impl.elementCount(); }
+    };
+
+    struct SetValue {
+        int value;
+
+        template<typename T>
+        void operator()(T& impl) const { impl.value_ = value; }
+    };
+
+    struct GetValue {
+        template<typename T>
+        int operator()(const T& impl) const { return impl.value_; }
+    };
+
+    // visit() passes the concrete type
+    struct IsQuadWide {
+        template<typename T>
+        bool operator()(const T&) const { return std::is_same<T, VariantImplT<decltype(quad_ | wide_)> >::value; }
+    };
+
+} // end anonymous namespace
+
+namespace {
+
+    struct Identity {
+        template<std::size_t I>
+        std::size_t operator()(std::integral_constant<std::size_t, I>) const { return I; }
+    };
+
+} // end anonymous namespace
+
+TEST_CASE("StaticMode/detail/dense_switch_", "dense_switch_ calls with the runtime index as a compile-time constant") {
+
+    Identity identity;
+
+    for (std::size_t i = 0; i < 3; ++i) {
+        REQUIRE((detail::dense_switch_<std::size_t, 3>::call(i, identity)) == i);
+    }
+
+    for (std::size_t i = 0; i < 40; ++i) { // more than two levels of 16 cases
+        REQUIRE((detail::dense_switch_<std::size_t, 40>::call(i, identity)) == i);
+    }
+}
+
+TEST_CASE("StaticModeErasure/mode_variant/static", "mode_variant types") {
+
+    static_assert(TestVariant::size == 3, "");
+    static_assert(std::is_same<TestVariant::index_type, std::uint8_t>::value, "");
+    static_assert(std::is_same<TestVariant::alternative_t<1>, VariantImplT<decltype(quad_ | wide_)> >::value, "");
+    static_assert(TestVariant::index_of<decltype(quad_ | wide_)>::value == 1, "");
+    static_assert(TestVariant::index_of<const ModeSet<> >::value == 2, "");
+    static_assert(TestVariant::index_of<decltype(wide_ | quad_)>::value == 1, ""); // in any order
+    static_assert(TestVariant::index_of<ModeSet<decltype(pair_)> >::value == 0, "");
+    static_assert(sizeof(TestVariant) == 2 * sizeof(int), ""); // index + largest alternative, no vptr
+
+    using TestSpaceVariant = space_variant_t<VariantImplT, TestSpace>;
+    static_assert(TestSpaceVariant::size == TestSpace::size, "");
+    static_assert(std::is_same<TestSpaceVariant::alternative_t<4>, VariantImplT<PackedModes<TestSpace, 4> > >::value, "");
+    // any spelling of a combination selects its packed key
+    static_assert(TestSpaceVariant::index_of<decltype(quad_ | wide_)>::value == keyOf(quad_ | wide_), "");
+    static_assert(TestSpaceVariant::index_of<decltype(wide_ | quad_)>::value == keyOf(quad_ | wide_), "");
+    static_assert(TestSpaceVariant::index_of<decltype(pair_)>::value == keyOf(pair_ | Mode<Wide, Wide::no>{}), "");
+    static_assert(TestSpaceVariant::index_of<ModeSet<> >::value == 0, "");
+    static_assert(TestSpaceVariant::index_of<PackedModes<TestSpace, 3> >::value == 3, "");
+
+    REQUIRE(true);
+}
+
+TEST_CASE("StaticModeErasure/mode_variant/visit", "mode_variant::visit() calls with the held alternative") {
+
+    REQUIRE(variantLiveCount() == 0);
+    {
+        TestVariant v0;
+        REQUIRE(v0.index() == 0);
+        REQUIRE(v0.visit(ElementCount{}) == 2);
+
+        TestVariant v1(quad_ | wide_);
+        REQUIRE(v1.index() == 1);
+        REQUIRE(v1.visit(ElementCount{}) == 4);
+        REQUIRE(visit(IsQuadWide{}, v1) == true);
+        REQUIRE(visit(IsQuadWide{}, v0) == false);
+
+        const TestVariant v2 = TestVariant::from_index(2);
+        REQUIRE(v2.index() == 2);
+        REQUIRE(v2.visit(ElementCount{}) == 1);
+        REQUIRE(variantLiveCount() == 3);
+
+        using TestSpaceVariant = space_variant_t<VariantImplT, TestSpace>;
+        TestSpaceVariant sv(wide_ | quad_);
+        REQUIRE(sv.index() == keyOf(quad_ | wide_));
+        REQUIRE(sv.visit(ElementCount{}) == 4);
+        REQUIRE(TestSpaceVariant(pair_).index() == keyOf(pair_));
+
+        for (std::size_t key = 0; key < TestSpace::size; ++key) {
+            TestSpaceVariant v = TestSpaceVariant::from_index(key);
+            REQUIRE(v.index() == key);
+            REQUIRE(v.visit(ElementCount{}) == elementCount_(TestSpace::value<Shape>(key)));
+        }
+    }
+    REQUIRE(variantLiveCount() == 0);
+}
+
+TEST_CASE("StaticModeErasure/mode_variant/value-semantics", "mode_variant copies and moves the held alternative") {
+
+    {
+        TestVariant a(quad_ | wide_);
+        a.visit(SetValue{ 42 });
+
+        TestVariant b(a);
+        REQUIRE(b.index() == 1);
+        REQUIRE(b.visit(GetValue{}) == 42);
+
+        TestVariant c(pair_);
+        c = b;
+        REQUIRE(c.index() == 1);
+        REQUIRE(c.visit(GetValue{}) == 42);
+
+        c = TestVariant(); // move assign
+        REQUIRE(c.index() == 0);
+        REQUIRE(c.visit(GetValue{}) == 0);
+
+        c = c;
+        REQUIRE(c.index() == 0);
+        REQUIRE(variantLiveCount() == 3);
+    }
+    REQUIRE(variantLiveCount() == 0);
+}
+
+namespace {
+
+    class KeyedShape : public mode_keyed<KeyedShape, TestSpace> {
+        struct ElementCount {
+            template<typename ModeExpr>
+            static std::size_t apply(const KeyedShape&) {
+                return elementCount_(get_mode_t<Shape, ModeExpr, Mode<Shape, Shape::point> >::value);
+            }
+        };
+
+        struct Key {
+            template<typename ModeExpr>
+            static std::size_t apply(KeyedShape& self, int add) {
+                self.value_ += add;
+                return ModeExpr::key;
+            }
+        };
+
+    public:
+        unsigned char value_;
+
+        explicit KeyedShape(std::size_t key) : mode_keyed(key), value_(0) {}
+
+        template<typename ModeExpr>
+        explicit KeyedShape(ModeExpr modes) : mode_keyed(modes), value_(0) {}
+
+        std::size_t elementCount() const { return dispatch<ElementCount>(); }
+        std::size_t key(int add) { return dispatch<Key>(add); }
+
+        void setKey(std::size_t key) { set_mode_key(key); }
+        bool trySetKey(std::size_t key) { return try_set_mode_key(key); }
+    };
+
+    struct EmptyKeyed : mode_keyed<EmptyKeyed, TestSpace> {
+        explicit EmptyKeyed(std::size_t key) : mode_keyed(key) {}
+    };
+
+} // end anonymous namespace
+
+TEST_CASE("StaticModeErasure/mode_keyed/static", "mode_keyed stores a one-byte key") {
+
+    static_assert(std::is_same<mode_keyed<KeyedShape, TestSpace>::key_type, std::uint8_t>::value, "");
+    static_assert(sizeof(EmptyKeyed) == 1, "");
+    static_assert(sizeof(KeyedShape) == 2, "");
+    static_assert(std::is_polymorphic<KeyedShape>::value == false, "");
+
+    REQUIRE(true);
+}
+
+TEST_CASE("StaticModeErasure/mode_keyed/dispatch", "mode_keyed dispatches on its runtime key") {
+
+    for (std::size_t key = 0; key < TestSpace::size; ++key) {
+        KeyedShape s(key);
+        REQUIRE(s.mode_key() == key);
+        REQUIRE(s.elementCount() == elementCount_(TestSpace::value<Shape>(key)));
+        REQUIRE(s.key(3) == key);
+        REQUIRE(s.value_ == 3);
+    }
+
+    KeyedShape q(quad_ | wide_);
+    REQUIRE(q.mode_key() == keyOf(quad_ | wide_));
+    REQUIRE(q.elementCount() == 4);
+
+    q.setKey(keyOf(pair_));
+    REQUIRE(q.elementCount() == 2);
+}
+
+TEST_CASE("StaticModeErasure/mode_keyed/checked", "mode_keyed rejects invalid runtime keys") {
+
+    static_assert(KeyedShape::valid_key(TestSpace::size - 1), "");
+    static_assert(!KeyedShape::valid_key(TestSpace::size), "");
+    REQUIRE(!KeyedShape::valid_key(TestSpace::key(static_cast<Shape>(9), Wide::no))); // an unlisted value
+
+    KeyedShape s(quad_);
+    REQUIRE(s.trySetKey(keyOf(pair_ | wide_)));
+    REQUIRE(s.mode_key() == keyOf(pair_ | wide_));
+    REQUIRE(!s.trySetKey(TestSpace::size));
+    REQUIRE(!s.trySetKey(0x100 + keyOf(quad_))); // would truncate to a valid key
+    REQUIRE(s.mode_key() == keyOf(pair_ | wide_));
+}
+
+namespace {
+
+    // Record the visiting order and the concrete types visited
+    struct CollectKeys {
+        std::vector<std::size_t> keys;
+
+        template<typename ModeExpr>
+        void operator()(const VariantImplT<ModeExpr>& impl) { keys.push_back(ModeExpr::key * 100 + static_cast<std::size_t>(impl.value_)); }
+    };
+
+    struct ElementCountSum {
+        std::size_t& sum;
+
+        template<typename T>
+        void operator()(const T& impl) const { sum += impl.elementCount(); }
+    };
+
+} // end anonymous namespace
+
+TEST_CASE("StaticModeErasure/mode_collection", "mode_collection stores each Impl type in its own segment") {
+
+    using TestCollection = mode_collection<VariantImplT, TestSpace>;
+
+    static_assert(std::is_same<TestCollection::impl_t<decltype(wide_ | quad_)>,
+        VariantImplT<PackedModes<TestSpace, packed_key<TestSpace, decltype(quad_ | wide_)>::value> > >::value, "");
+
+    {
+        TestCollection c;
+        REQUIRE(c.empty());
+
+        c.emplace(quad_ | wide_).value_ = 1;
+        c.emplace(pair_).value_ = 2;
+        c.emplace(wide_ | quad_).value_ = 3;
+        c.emplace_key(0);
+
+        VariantImplT<compact_t<TestSpace, decltype(pair_)> > p;
+        p.value_ = 4;
+        c.insert(p);
+
+        REQUIRE(c.size() == 5);
+        REQUIRE(c.segment<keyOf(quad_ | wide_)>().size() == 2);
+        REQUIRE(c.segment<keyOf(pair_)>().size() == 2);
+        REQUIRE(c.segment<0>().size() == 1);
+
+        // segments are visited in key order, objects in insertion order
+        CollectKeys collect;
+        c.for_each(collect);
+        std::vector<std::size_t> expected = {
+            0, keyOf(pair_) * 100 + 2, keyOf(pair_) * 100 + 4, keyOf(quad_ | wide_) * 100 + 1, keyOf(quad_ | wide_) * 100 + 3 };
+        REQUIRE(collect.keys == expected);
+
+        // for_each with an rvalue function object
+        std::size_t elementCount = 0;
+        const TestCollection& cc = c;
+        cc.for_each(ElementCountSum{ elementCount });
+        REQUIRE(elementCount == 1 + 2 + 2 + 4 + 4);
+
+        c.for_each(SetValue{ 7 });
+        REQUIRE(c.segment<0>()[0].value_ == 7);
+
+        c.clear();
+        REQUIRE(c.empty());
+    }
+
+    int liveCount = VariantImplT<PackedModes<TestSpace, 0> >::liveCount
+        + VariantImplT<compact_t<TestSpace, decltype(pair_)> >::liveCount
+        + VariantImplT<compact_t<TestSpace, decltype(quad_ | wide_)> >::liveCount;
+    REQUIRE(liveCount == 0);
+}
@@ -0,0 +1,227 @@
+//!clang++ -std=c++11 -Weverything -Wno-c++98-compat -Wno-unused-const-variable -Wno-exit-time-destructors StaticModeInstrument_test.cpp -DCATCH_CONFIG_MAIN -I../include -I./Catch -pthread -o instrument_test.out && ./instrument_test.out
+
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "StaticModeDispatch.h"
+#include "StaticModeInstrument.h"
+#include "StaticModeNames.h"
+
+using namespace staticmode;
+
+namespace {
+
+    enum class LineStyle { solid, dotted, dashed };
+    enum class EndStyle { no_ends, arrows };
+
+    using LineStyles = ModeCategory<LineStyle, LineStyle::solid, LineStyle::dotted, LineStyle::dashed>;
+    using EndStyles = ModeCategory<EndStyle, EndStyle::no_ends, EndStyle::arrows>;
+
+    using DrawFunction = mode_function<int(int), LineStyles, EndStyles>;
+    using PainterModes = DrawFunction::space_type;
+
+    struct DrawKernel {
+        template<typename ModeExpr>
+        static int apply(int x) {
+            if (x < 0)
+                throw std::runtime_error("negative");
+            return x * 10 + static_cast<int>(ModeExpr::key);
+        }
+    };
+
+    // a kernel with a void result and a reference parameter
+    struct AccumulateKernel {
+        template<typename ModeExpr>
+        static void apply(std::vector<int>& out) { out.push_back(static_cast<int>(ModeExpr::key)); }
+    };
+
+    using BuildModes = ModeSet<LineStyles::default_mode, instrumented_t>;
+
+    using InstrumentedDraw = instrument_t<DrawKernel, PainterModes, BuildModes>;
+
+    std::uint64_t histogram_sum(const dispatch_key_stats& s) {
+        std::uint64_t n = 0;
+        for (std::uint64_t count : s.histogram)
+            n += count;
+        return n;
+    }
+
+} // end anonymous namespace
+
+STATICMODE_MODE_NAMES(LineStyle, "line", "solid", "dotted", "dashed")
+STATICMODE_MODE_NAMES(EndStyle, "end", "none", "arrows")
+
+TEST_CASE("StaticModeInstrument/uninstrumented", "the uninstrumented kernel is the kernel itself") {
+
+    static_assert(std::is_same<instrument_t<DrawKernel, PainterModes>, DrawKernel>::value, "default");
+    static_assert(std::is_same<instrument_t<DrawKernel, PainterModes, uninstrumented_t>, DrawKernel>::value, "off");
+    static_assert(std::is_same<instrument_t<DrawKernel, PainterModes, LineStyles::default_mode>, DrawKernel>::value,
+        "no Instrumentation mode");
+    static_assert(!std::is_same<InstrumentedDraw, DrawKernel>::value, "on");
+
+    // ... so it binds to the same functions
+    using Plain = instrument_t<DrawKernel, PainterModes, decltype(uninstrumented)>;
+    REQUIRE(DrawFunction::bind<Plain>(3).target() == DrawFunction::bind<DrawKernel>(3).target());
+
+    dispatch_stats stats = collect_dispatch_stats<Plain>();
+    REQUIRE(stats.keys.empty());
+}
+
+TEST_CASE("StaticModeInstrument/counts", "calls are counted per key, across threads") {
+
+    const dispatch_stats before = collect_dispatch_stats<InstrumentedDraw>();
+    REQUIRE(before.keys.size() == PainterModes::size);
+    REQUIRE(std::string(before.unit) == "ns");
+
+    DrawFunction f = DrawFunction::bind<InstrumentedDraw>(LineStyle::dashed, EndStyle::arrows);
+    REQUIRE(f(4) == 40 + static_cast<int>(f.key()));
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([t] {
+            DrawFunction g = DrawFunction::bind<InstrumentedDraw>(static_cast<std::size_t>(t));
+            for (int i = 0; i < 1000; ++i)
+                g(i);
+        });
+    }
+    for (std::thread& t : threads)
+        t.join();
+
+    // exceptions propagate, and the call is still counted
+    DrawFunction h = DrawFunction::bind<InstrumentedDraw>(std::size_t(5));
+    bool threw = false;
+    try {
+        h(-1);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    REQUIRE(threw);
+
+    const dispatch_stats after = collect_dispatch_stats<InstrumentedDraw>();
+    for (std::size_t key = 0; key < PainterModes::size; ++key) {
+        const dispatch_key_stats& s = after.keys[key];
+        const std::uint64_t expected = ((key < 4) ? 1000 : 0) + ((key == f.key()) ? 1 : 0) + ((key == 5) ? 1 : 0);
+        REQUIRE(s.key == key);
+        REQUIRE(s.calls - before.keys[key].calls == expected);
+        REQUIRE(histogram_sum(s) == s.calls);
+        REQUIRE(s.total >= s.max);
+        if (s.calls != 0)
+            REQUIRE(dispatch_percentile(s, 100.) >= s.max);
+    }
+}
+
+TEST_CASE("StaticModeInstrument/signatures", "void results, reference parameters and other clocks") {
+
+    using Accumulate = instrument_t<AccumulateKernel, PainterModes, decltype(instrumented), tsc_ticks>;
+    static_assert(std::is_same<decltype(&Accumulate::apply<PackedModes<PainterModes, 0> >), void (*)(std::vector<int>&)>::value,
+        "same signature as the kernel");
+
+    std::vector<int> out;
+    for (std::size_t key = 0; key < PainterModes::size; ++key)
+        detail::method_table_<PainterModes, Accumulate>::functions[key](out);
+    REQUIRE(out.size() == PainterModes::size);
+    REQUIRE(out[2] == 2);
+
+    const dispatch_stats stats = collect_dispatch_stats<Accumulate>();
+    for (const dispatch_key_stats& s : stats.keys)
+        REQUIRE(s.calls == 1);
+}
+
+TEST_CASE("StaticModeInstrument/reports", "plain text report") {
+
+    dispatch_stats stats = { "ns", std::vector<dispatch_key_stats>(PainterModes::size) };
+    for (std::size_t key = 0; key < PainterModes::size; ++key) {
+        stats.keys[key] = dispatch_key_stats();
+        stats.keys[key].key = key;
+    }
+    dispatch_key_stats& s = stats.keys[4];
+    s.calls = 3;
+    s.total = 600;
+    s.max = 300;
+    s.histogram[8] = 2;  // [128, 256)
+    s.histogram[9] = 1;  // [256, 512)
+
+    REQUIRE(dispatch_percentile(s, 50.) == 255);
+    REQUIRE(dispatch_percentile(s, 100.) == 511);
+
+    std::ostringstream os;
+    write_dispatch_stats(os, stats, &to_string<PainterModes>);
+    REQUIRE(os.str() ==
+        "# staticmode dispatch stats\n"
+        "# unit ns\n"
+        "# combination <key> <calls> <total> <mean> <max> <modes>\n"
+        "combination 4 3 600 200 300 line=dotted,end=arrows\n"
+        "histogram 4 255:2 511:1\n");
+
+    const std::string file = "StaticModeInstrument_test.stats";
+    REQUIRE(dump_dispatch_stats(file, stats));
+    std::ifstream in(file.c_str());
+    std::string line;
+    REQUIRE(std::getline(in, line));
+    REQUIRE(line == "# staticmode dispatch stats");
+    in.close();
+    std::remove(file.c_str());
+
+    REQUIRE(!dump_dispatch_stats("no-such-directory/x.stats", stats));
+}
+
+TEST_CASE("StaticModeInstrument/dump_dispatch_stats/concurrent", "concurrent dumps to one file never publish a mixed report") {
+
+    dispatch_stats stats;
+    stats.unit = "ns";
+    stats.keys.resize(1);
+    stats.keys[0].key = 1;
+    stats.keys[0].calls = 1;
+    stats.keys[0].total = 100;
+    stats.keys[0].max = 100;
+
+    const std::string file = "StaticModeInstrument_test_concurrent.stats";
+    std::vector<std::thread> dumpers;
+    for (int t = 0; t < 4; ++t) {
+        dumpers.emplace_back([&stats, &file] {
+            for (int i = 0; i < 20; ++i)
+                dump_dispatch_stats(file, stats);
+        });
+    }
+    for (std::thread& t : dumpers)
+        t.join();
+
+    std::ostringstream expected;
+    write_dispatch_stats(expected, stats);
+    std::ifstream in(file.c_str());
+    std::ostringstream actual;
+    actual << in.rdbuf();
+    REQUIRE(actual.str() == expected.str());
+    in.close();
+    std::remove(file.c_str());
+}
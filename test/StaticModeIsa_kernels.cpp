@@ -0,0 +1,73 @@
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Compiled once per level by staticmode_isa_objects(), with -DSTATICMODE_ISA=<level>
+
+#include "StaticModeIsa_kernels.h"
+
+namespace {
+
+    // whether the predefined macro for the level's instruction set is defined
+    constexpr bool targetMacroDefined_(staticmode::Isa isa) {
+        return (isa == staticmode::Isa::scalar)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+            || (isa == staticmode::Isa::sse2)
+#endif
+#if defined(__AVX2__)
+            || (isa == staticmode::Isa::avx2)
+#endif
+#if defined(__AVX512F__)
+            || (isa == staticmode::Isa::avx512)
+#endif
+            ;
+    }
+
+} // end anonymous namespace
+
+// A template with external linkage, instantiated with the same arguments at
+// every level. In the per-level namespace, each level calls its own copy.
+
+STATICMODE_ISA_NAMESPACE_BEGIN
+
+template<typename T>
+#if defined(__GNUC__)
+__attribute__((noinline)) // keep a call to the linked copy
+#endif
+T accumulate(const T *x, std::size_t n, staticmode::Isa& compiledFor)
+{
+    T sum = 0;
+    for (std::size_t i = 0; i < n; ++i)
+        sum += x[i];
+    compiledFor = staticmode::compiled_isa_t::value;
+    return sum;
+}
+
+STATICMODE_ISA_NAMESPACE_END
+
+IsaSumResult isaSum(staticmode::compiled_isa_t, const float *x, std::size_t n)
+{
+    staticmode::Isa helperCompiledFor = staticmode::Isa::scalar;
+    float sum = STATICMODE_ISA_NS::accumulate(x, n, helperCompiledFor);
+
+    IsaSumResult result = { sum, staticmode::compiled_isa_t::value,
+        targetMacroDefined_(staticmode::compiled_isa_t::value), helperCompiledFor };
+    return result;
+}
@@ -0,0 +1,52 @@
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef INCLUDED_STATICMODEISA_KERNELS_H
+#define INCLUDED_STATICMODEISA_KERNELS_H
+
+#include <cstddef>
+
+#include "StaticModeIsa.h"
+
+// Kernels for StaticModeIsa_test.cpp. StaticModeIsa_kernels.cpp is compiled
+// once per level, and defines the overload for that level.
+
+struct IsaSumResult {
+    float sum;
+    staticmode::Isa compiledFor;    // the level of the overload that ran
+    bool targetMacroDefined;        // the compiler flags for that level were in effect
+    staticmode::Isa helperCompiledFor; // the level of the copy of a shared template helper that ran
+};
+
+IsaSumResult isaSum(staticmode::Mode<staticmode::Isa, staticmode::Isa::scalar>, const float *x, std::size_t n);
+IsaSumResult isaSum(staticmode::Mode<staticmode::Isa, staticmode::Isa::sse2>, const float *x, std::size_t n);
+IsaSumResult isaSum(staticmode::Mode<staticmode::Isa, staticmode::Isa::avx2>, const float *x, std::size_t n);
+IsaSumResult isaSum(staticmode::Mode<staticmode::Isa, staticmode::Isa::avx512>, const float *x, std::size_t n);
+
+struct IsaSumKernel {
+    template<typename ModeExpr>
+    static IsaSumResult apply(const float *x, std::size_t n) {
+        return isaSum(staticmode::get_mode_t<staticmode::Isa, ModeExpr,
+            staticmode::Mode<staticmode::Isa, staticmode::Isa::scalar> >{}, x, n);
+    }
+};
+
+#endif /* INCLUDED_STATICMODEISA_KERNELS_H */
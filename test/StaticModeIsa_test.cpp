@@ -0,0 +1,94 @@
+//!clang++ -std=c++11 -Weverything -Wno-c++98-compat -Wno-unused-const-variable -Wno-exit-time-destructors StaticModeIsa_test.cpp -DCATCH_CONFIG_MAIN -I../include -I./Catch -c && for isa in scalar sse2 "avx2 -mavx2 -mfma" "avx512 -mavx512f -mavx2 -mfma"; do set -- $isa; clang++ -std=c++11 -I../include -DSTATICMODE_ISA=$1 ${@:2} -c StaticModeIsa_kernels.cpp -o kernels_$1.o; done && clang++ StaticModeIsa_test.o kernels_*.o -o isa_test.out && ./isa_test.out
+
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch.hpp"
+
+#include <cstddef>
+
+#include "StaticModeIsa.h"
+#include "StaticModeDispatch.h"
+
+#include "StaticModeIsa_kernels.h"
+
+using namespace staticmode;
+
+namespace {
+
+    using SumFunction = mode_function<IsaSumResult(const float*, std::size_t), Isas>;
+
+} // end anonymous namespace
+
+TEST_CASE("StaticModeIsa/detection", "runtime_isa is supported and no higher than detected_isa") {
+
+    REQUIRE(isa_supported(Isa::scalar));
+#if defined(__x86_64__) || defined(_M_X64)
+    REQUIRE(isa_supported(Isa::sse2)); // part of x86-64
+#endif
+    REQUIRE(isa_supported(detected_isa()));
+    REQUIRE(static_cast<int>(runtime_isa()) <= static_cast<int>(detected_isa()));
+    REQUIRE(detected_isa() == detected_isa()); // cached
+}
+
+TEST_CASE("StaticModeIsa/parse_isa", "parse_isa") {
+
+    Isa isa = Isa::scalar;
+    REQUIRE(parse_isa("avx2", isa));
+    REQUIRE(isa == Isa::avx2);
+    REQUIRE(parse_isa("avx512", isa));
+    REQUIRE(isa == Isa::avx512);
+    REQUIRE(parse_isa("scalar", isa));
+    REQUIRE(isa == Isa::scalar);
+
+    REQUIRE(!parse_isa("AVX2", isa));
+    REQUIRE(!parse_isa("", isa));
+    REQUIRE(isa == Isa::scalar);
+}
+
+TEST_CASE("StaticModeIsa/forced", "each supported level runs the kernel compiled for it") {
+
+    float x[100];
+    for (std::size_t i = 0; i < 100; ++i)
+        x[i] = static_cast<float>(i);
+
+    for (std::size_t i = 0; i < Isas::size; ++i) {
+        Isa level = Isas::values[i];
+        if (!isa_supported(level)) {
+            WARN("level " << i << " is not supported by this CPU: skipped");
+            continue;
+        }
+
+        SumFunction sum = SumFunction::bind<IsaSumKernel>(level);
+        IsaSumResult result = sum(x, 100);
+
+        REQUIRE(result.sum == 4950.f);
+        REQUIRE(result.compiledFor == level);
+        REQUIRE(result.helperCompiledFor == level); // no other level's copy of a shared template
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+        REQUIRE(result.targetMacroDefined);
+#endif
+    }
+
+    // the level selected at startup
+    IsaSumResult result = SumFunction::bind<IsaSumKernel>(runtime_isa())(x, 100);
+    REQUIRE(result.compiledFor == runtime_isa());
+}
@@ -0,0 +1,59 @@
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "StaticModeManifest_shared.h"
+
+#include "StaticMode.h"
+#include "StaticModeNames.h"
+
+using namespace staticmode;
+
+namespace {
+
+    enum class Shape { point, pair, quad };
+    enum class Wide { no, yes };
+
+    using Shapes = ModeCategory<Shape, Shape::point, Shape::pair, Shape::quad>;
+    using Wides = ModeCategory<Wide, Wide::no, Wide::yes>;
+
+    struct SharedModes : ModeSpace<Shapes, Wides> {};
+
+    struct SharedKernel {
+        template<typename ModeExpr>
+        static std::size_t apply(std::size_t x) {
+            STATICMODE_MANIFEST(SharedModes, ModeExpr);
+            return x * 100 + ModeExpr::key;
+        }
+    };
+
+} // end anonymous namespace
+
+STATICMODE_MODE_NAMES(Shape, "shape", "point", "pair", "quad")
+STATICMODE_MODE_NAMES(Wide, "wide", "no", "yes")
+
+std::size_t shared_manifest_apply(std::size_t key, std::size_t x) {
+    return detail::method_table_<SharedModes, SharedKernel>::functions[key](x);
+}
+
+std::vector<manifest_record> shared_manifest_records() {
+    return manifest_records();
+}
@@ -0,0 +1,42 @@
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef INCLUDED_STATICMODEMANIFEST_SHARED_H
+#define INCLUDED_STATICMODEMANIFEST_SHARED_H
+
+#include <cstddef>
+#include <vector>
+
+#include "StaticModeManifest.h"
+
+// A shared library for StaticModeManifest_test.cpp. StaticModeManifest_shared.cpp
+// is compiled as position-independent code, to check that manifest entries
+// assemble and link there, and that manifest_records() called from a shared
+// library lists that library's combinations.
+
+// calls the library's kernel for packed key /key/ (every key has a copy)
+std::size_t shared_manifest_apply(std::size_t key, std::size_t x);
+
+// manifest_records() called from inside the library
+std::vector<staticmode::manifest_record> shared_manifest_records();
+
+#endif /* INCLUDED_STATICMODEMANIFEST_SHARED_H */
@@ -0,0 +1,174 @@
+//!clang++ -std=c++11 -Weverything -Wno-c++98-compat -Wno-unused-const-variable -Wno-exit-time-destructors StaticModeManifest_test.cpp -DCATCH_CONFIG_MAIN -I../include -I./Catch -o manifest_test.out && ./manifest_test.out
+
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "StaticModeManifest.h"
+#include "StaticModeNames.h"
+
+#if defined(STATICMODE_TEST_SHARED_MANIFEST)
+#include "StaticModeManifest_shared.h"
+#endif
+
+using namespace staticmode;
+
+namespace {
+
+    enum class LineStyle { solid, dotted, dashed };
+    enum class EndStyle { no_ends, arrows, circles };
+    enum class Precision { single, double_ };
+
+    constexpr Mode<LineStyle, LineStyle::dashed> dashed;
+    constexpr Mode<EndStyle, EndStyle::arrows> arrows;
+    constexpr Mode<Precision, Precision::double_> double_precision;
+
+    using LineStyles = ModeCategory<LineStyle, LineStyle::solid, LineStyle::dotted, LineStyle::dashed>;
+    using EndStyles = ModeCategory<EndStyle, EndStyle::no_ends, EndStyle::arrows, EndStyle::circles>;
+    using Precisions = ModeCategory<Precision, Precision::single, Precision::double_>;
+
+    struct PainterModes : ModeSpace<LineStyles, EndStyles> {};
+
+    // a category that lists its modes in non-enum order
+    using SomeLineStyles = ModeCategory<LineStyle, LineStyle::dashed, LineStyle::solid>;
+    struct FilterModes : ModeSpace<Precisions, SomeLineStyles> {};
+
+    // every key of PainterModes is instantiated, through method_table_
+    struct PainterKernel {
+        template<typename ModeExpr>
+        static std::size_t apply(std::size_t x) {
+            STATICMODE_MANIFEST(PainterModes, ModeExpr);
+            return x * 10 + ModeExpr::key;
+        }
+    };
+
+    // only instantiated for one combination of FilterModes
+    template<typename ModeExpr>
+    int filter(int x) {
+        STATICMODE_MANIFEST(FilterModes, ModeExpr);
+        return x + static_cast<int>(get_mode_t<Precision, ModeExpr, Mode<Precision, Precision::single> >::value);
+    }
+
+    std::uint64_t fnv1a64(const char *s) {
+        std::uint64_t h = 14695981039346656037ull;
+        for (; *s; ++s)
+            h = (h ^ static_cast<unsigned char>(*s)) * 1099511628211ull;
+        return h;
+    }
+
+    const manifest_record *find_record(const std::vector<manifest_record>& records, const std::string& name) {
+        for (const manifest_record& r : records) {
+            if (name == r.name)
+                return &r;
+        }
+        return nullptr;
+    }
+
+} // end anonymous namespace
+
+STATICMODE_MODE_NAMES(LineStyle, "line", "solid", "dotted", "dashed")
+STATICMODE_MODE_NAMES(EndStyle, "end", "none", "arrows", "circles")
+STATICMODE_MODE_NAMES(Precision, "precision", "single", "double")
+
+TEST_CASE("StaticModeManifest/names", "the canonical mode string and its hash are computed at compile time") {
+
+    using entry = detail::manifest_entry_<PainterModes, decltype(dashed | arrows)>;
+    static_assert(entry::key == packed_key<PainterModes, decltype(arrows | dashed)>::value, "key");
+    static_assert(entry::name_type::length == sizeof("line=dashed,end=arrows") - 1, "length");
+    static_assert(entry::name_size % 8 == 0 && entry::name_size > entry::name_type::length, "name_size");
+    static_assert(detail::manifest_hash_<entry::name_type>() == 0xb0e735980fbe6c7bull, "FNV-1a 64 of the name");
+
+    std::string name;
+    for (std::size_t i = 0; i < entry::name_type::length; ++i)
+        name += entry::name_type::at(i);
+    REQUIRE(name == "line=dashed,end=arrows");
+    REQUIRE(name == to_string<PainterModes>(entry::key));
+    REQUIRE(detail::manifest_hash_<entry::name_type>() == fnv1a64("line=dashed,end=arrows"));
+
+    // category order, and a category that lists its modes in non-enum order
+    using other = detail::manifest_entry_<FilterModes, decltype(double_precision)>;
+    name.clear();
+    for (std::size_t i = 0; i < other::name_type::length; ++i)
+        name += other::name_type::at(i);
+    REQUIRE(name == "precision=double,line=dashed");
+    REQUIRE(name == to_string<FilterModes>(other::key));
+}
+
+TEST_CASE("StaticModeManifest/records", "manifest_records() lists each instantiated combination once") {
+
+    // instantiate and call every combination of PainterModes, and one of FilterModes
+    std::size_t sum = 0;
+    for (std::size_t key = 0; key < PainterModes::size; ++key)
+        sum += detail::method_table_<PainterModes, PainterKernel>::functions[key](1);
+    REQUIRE(sum == PainterModes::size * 10 + PainterModes::size * (PainterModes::size - 1) / 2);
+    REQUIRE(filter<decltype(double_precision)>(1) == 2);
+
+    const std::vector<manifest_record> records = manifest_records();
+#if defined(STATICMODE_MANIFEST_ENABLED)
+    REQUIRE(records.size() == PainterModes::size + 1);
+
+    for (std::size_t key = 0; key < PainterModes::size; ++key) {
+        const std::string name = to_string<PainterModes>(key);
+        const manifest_record *r = find_record(records, name);
+        REQUIRE(r != nullptr);
+        REQUIRE(r->key == key);
+        REQUIRE(r->hash == fnv1a64(r->name));
+    }
+
+    const manifest_record *r = find_record(records, "precision=double,line=dashed");
+    REQUIRE(r != nullptr);
+    const std::size_t doubleKey = packed_key<FilterModes, decltype(double_precision)>::value;
+    REQUIRE(r->key == doubleKey);
+    REQUIRE(find_record(records, "precision=single,line=dashed") == nullptr);
+#else
+    REQUIRE(records.empty()); // no manifest on this target
+    REQUIRE(find_record(records, to_string<PainterModes>(0)) == nullptr);
+#endif
+}
+
+#if defined(STATICMODE_TEST_SHARED_MANIFEST)
+TEST_CASE("StaticModeManifest/shared-library", "manifest entries work in position-independent code, per module") {
+
+    for (std::size_t key = 0; key < 6; ++key)
+        REQUIRE(shared_manifest_apply(key, 1) == 100 + key);
+
+    const std::vector<manifest_record> records = shared_manifest_records();
+#if defined(STATICMODE_MANIFEST_ENABLED)
+    REQUIRE(records.size() == 6); // only the library's combinations
+    const manifest_record *r = find_record(records, "shape=quad,wide=yes");
+    REQUIRE(r != nullptr);
+    REQUIRE(r->key == 5);
+    REQUIRE(r->hash == fnv1a64(r->name));
+    REQUIRE(find_record(records, "line=dashed,end=arrows") == nullptr);
+
+    REQUIRE(find_record(manifest_records(), "shape=quad,wide=yes") == nullptr); // and not the executable's
+#else
+    REQUIRE(records.empty());
+#endif
+}
+#endif
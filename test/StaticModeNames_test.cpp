@@ -0,0 +1,243 @@
+//!clang++ -std=c++11 -Weverything -Wno-c++98-compat -Wno-unused-const-variable -Wno-exit-time-destructors StaticModeNames_test.cpp -DCATCH_CONFIG_MAIN -I../include -I./Catch -o names_test.out && ./names_test.out
+
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch.hpp"
+
+#include <cstring>
+#include <string>
+
+#include "StaticModeNames.h"
+
+using namespace staticmode;
+
+namespace {
+
+    // Modes used by the tests
+
+    enum class LineStyle { solid, dotted, dashed };
+    constexpr Mode<LineStyle, LineStyle::solid> solid;
+    constexpr Mode<LineStyle, LineStyle::dotted> dotted;
+    constexpr Mode<LineStyle, LineStyle::dashed> dashed;
+
+    enum class EndStyle { no_ends, arrows, circles };
+    constexpr Mode<EndStyle, EndStyle::no_ends> no_ends;
+    constexpr Mode<EndStyle, EndStyle::arrows> arrows;
+    constexpr Mode<EndStyle, EndStyle::circles> circles;
+
+    // names that share length, first, middle and last chars (told apart by
+    // the prefix hash, which samples their second char)
+    enum class Similar { aXcde, aYcde, aZcde };
+
+    // names that the prefix hash can't tell apart: "a" is a prefix of the
+    // others. The sampled hash tells them apart by length.
+    enum class Nested { a, ab, abc };
+
+    // neither the prefix nor the sampled hash can tell these apart, so the
+    // perfect hash falls back to hashing every char
+    enum class Lookalike { a, aXcde, aYcde };
+
+    using LineStyles = ModeCategory<LineStyle, LineStyle::solid, LineStyle::dotted, LineStyle::dashed>;
+    using EndStyles = ModeCategory<EndStyle, EndStyle::no_ends, EndStyle::arrows, EndStyle::circles>;
+    using Similars = ModeCategory<Similar, Similar::aXcde, Similar::aYcde, Similar::aZcde>;
+
+    // NB: EndStyles before LineStyles, so category order differs from mode string order in some tests
+    struct TestSpace : ModeSpace<EndStyles, LineStyles, Similars> {};
+
+    // A space where a category lists only some of its modes, in non-enum order
+    using SomeLineStyles = ModeCategory<LineStyle, LineStyle::dashed, LineStyle::solid>;
+    struct PartialSpace : ModeSpace<SomeLineStyles> {};
+
+    using Nesteds = ModeCategory<Nested, Nested::a, Nested::ab, Nested::abc>;
+    using Lookalikes = ModeCategory<Lookalike, Lookalike::a, Lookalike::aXcde, Lookalike::aYcde>;
+    struct FallbackSpace : ModeSpace<Nesteds, Lookalikes> {};
+
+} // end anonymous namespace
+
+STATICMODE_MODE_NAMES(LineStyle, "line", "solid", "dotted", "dashed")
+STATICMODE_MODE_NAMES(EndStyle, "end", "none", "arrows", "circles")
+STATICMODE_MODE_NAMES(Similar, "similar", "aXcde", "aYcde", "aZcde")
+STATICMODE_MODE_NAMES(Nested, "nested", "a", "ab", "abc")
+STATICMODE_MODE_NAMES(Lookalike, "lookalike", "a", "aXcde", "aYcde")
+
+TEST_CASE("StaticModeNames/names", "category_name<>() and mode_name()") {
+
+    static_assert(category_name<LineStyle>()[0] == 'l', "");
+    static_assert(mode_name(dashed)[1] == 'a', ""); // constexpr
+
+    REQUIRE(std::string(category_name<EndStyle>()) == "end");
+    REQUIRE(std::string(mode_name(solid)) == "solid");
+    REQUIRE(std::string(mode_name(circles)) == "circles");
+
+    // runtime values
+    REQUIRE(std::string(mode_name(LineStyle::dotted)) == "dotted");
+    REQUIRE(std::string(mode_name(EndStyle::no_ends)) == "none");
+    REQUIRE(mode_name(static_cast<LineStyle>(3)) == nullptr);
+}
+
+TEST_CASE("StaticModeNames/to_string", "to_string() of mode expressions and packed keys") {
+
+    REQUIRE(to_string(dashed) == "line=dashed");
+    REQUIRE(to_string(dashed | arrows) == "line=dashed,end=arrows");
+    REQUIRE(to_string(arrows | dashed) == "end=arrows,line=dashed");
+    REQUIRE(to_string(ModeSet<>{}) == "");
+
+    // normalized: all categories, in category order
+    REQUIRE(to_string(compact<TestSpace>(dashed)) == "end=none,line=dashed,similar=aXcde");
+    REQUIRE(to_string<TestSpace>(0) == "end=none,line=solid,similar=aXcde");
+    const std::size_t dottedCirclesKey = packed_key<TestSpace, decltype(dotted | circles)>::value;
+    REQUIRE(to_string<TestSpace>(dottedCirclesKey) == "end=circles,line=dotted,similar=aXcde");
+}
+
+TEST_CASE("StaticModeNames/perfect-hash", "perfect_hash_ finds every name and rejects others") {
+
+    using lineHash = detail::perfect_hash_<detail::mode_names_<LineStyle> >;
+    using similarHash = detail::perfect_hash_<detail::mode_names_<Similar> >;
+    using nestedHash = detail::perfect_hash_<detail::mode_names_<Nested> >;
+    using lookalikeHash = detail::perfect_hash_<detail::mode_names_<Lookalike> >;
+
+    static_assert(lineHash::kind == detail::hash_kind_::prefix, "");
+    static_assert(similarHash::kind == detail::hash_kind_::prefix, "");
+    static_assert(nestedHash::kind == detail::hash_kind_::sampled, "");
+    static_assert(lookalikeHash::kind == detail::hash_kind_::full, "");
+
+    REQUIRE(lineHash::find("solid", 5) == 0);
+    REQUIRE(lineHash::find("dotted", 6) == 1);
+    REQUIRE(lineHash::find("dashed", 6) == 2);
+    REQUIRE(lineHash::find("dashes", 6) == 3);
+    REQUIRE(lineHash::find("dashed", 5) == 3);
+    REQUIRE(lineHash::find("", 0) == 3);
+
+    REQUIRE(similarHash::find("aXcde", 5) == 0);
+    REQUIRE(similarHash::find("aYcde", 5) == 1);
+    REQUIRE(similarHash::find("aZcde", 5) == 2);
+    REQUIRE(similarHash::find("aWcde", 5) == 3);
+    REQUIRE(similarHash::find("a", 1) == 3);
+
+    REQUIRE(nestedHash::find("a", 1) == 0);
+    REQUIRE(nestedHash::find("ab", 2) == 1);
+    REQUIRE(nestedHash::find("abc", 3) == 2);
+    REQUIRE(nestedHash::find("abd", 3) == 3);
+
+    REQUIRE(lookalikeHash::find("a", 1) == 0);
+    REQUIRE(lookalikeHash::find("aXcde", 5) == 1);
+    REQUIRE(lookalikeHash::find("aYcde", 5) == 2);
+    REQUIRE(lookalikeHash::find("aZcde", 5) == 3);
+}
+
+TEST_CASE("StaticModeNames/perfect-hash/find_token", "find_token() finds the name at the start of a token and advances past it") {
+
+    using lineHash = detail::perfect_hash_<detail::mode_names_<LineStyle> >;
+    using nestedHash = detail::perfect_hash_<detail::mode_names_<Nested> >;
+
+    const char *const dashedComma = "dashed,end=arrows";
+    const char *s = dashedComma;
+    REQUIRE(lineHash::find_token(s, s + 17, ',') == 2);
+    REQUIRE(s == dashedComma + 6);
+
+    s = dashedComma;
+    REQUIRE(lineHash::find_token(s, s + 6, ',') == 2); // ends at /end/
+    REQUIRE(s == dashedComma + 6);
+
+    s = dashedComma;
+    REQUIRE(lineHash::find_token(s, s + 5, ',') == 3); // "dashe"
+    REQUIRE(lineHash::find_token(s, s + 17, '=') == 3); // not followed by the delimiter
+    REQUIRE(lineHash::find_token(s, s, ',') == 3);
+    REQUIRE(s == dashedComma); // not advanced
+
+    const char *const dashedX = "dashedX";
+    s = dashedX;
+    REQUIRE(lineHash::find_token(s, s + 7, ',') == 3);
+    REQUIRE(s == dashedX);
+
+    const char *const ab = "ab,abc";
+    s = ab;
+    REQUIRE(nestedHash::find_token(s, s + 6, ',') == 1);
+    REQUIRE(s == ab + 2);
+    ++s;
+    REQUIRE(nestedHash::find_token(s, s + 3, ',') == 2);
+    REQUIRE(s == ab + 6);
+}
+
+TEST_CASE("StaticModeNames/parse_modes", "parse_modes<>() parses mode strings to packed keys") {
+
+    REQUIRE(parse_modes<TestSpace>("") == 0);
+    const std::size_t dashedKey = packed_key<TestSpace, decltype(dashed)>::value;
+    const std::size_t dashedArrowsKey = packed_key<TestSpace, decltype(dashed | arrows)>::value;
+
+    REQUIRE(parse_modes<TestSpace>("line=dashed") == dashedKey);
+    REQUIRE(parse_modes<TestSpace>("line=dashed,end=arrows") == dashedArrowsKey);
+    REQUIRE(parse_modes<TestSpace>("end=arrows,line=dashed") == dashedArrowsKey);
+    REQUIRE(parse_modes<TestSpace>(std::string("similar=aZcde,end=circles")) == TestSpace::key(EndStyle::circles, LineStyle::solid, Similar::aZcde));
+
+    // /n/ limits the parsed chars
+    REQUIRE(parse_modes<TestSpace>("line=dottedXXX", 11) == TestSpace::key(EndStyle::no_ends, LineStyle::dotted, Similar::aXcde));
+
+    // round trip
+    for (std::size_t k = 0; k < TestSpace::size; ++k) {
+        REQUIRE(parse_modes<TestSpace>(to_string<TestSpace>(k)) == k);
+    }
+
+    // errors
+    REQUIRE(parse_modes<TestSpace>("line") == TestSpace::size);                   // no '='
+    REQUIRE(parse_modes<TestSpace>("line=") == TestSpace::size);                  // empty mode
+    REQUIRE(parse_modes<TestSpace>("=dashed") == TestSpace::size);                // empty category
+    REQUIRE(parse_modes<TestSpace>("line=dashes") == TestSpace::size);            // unknown mode
+    REQUIRE(parse_modes<TestSpace>("lines=dashed") == TestSpace::size);           // unknown category
+    REQUIRE(parse_modes<TestSpace>("line=dashed,") == TestSpace::size);           // trailing comma
+    REQUIRE(parse_modes<TestSpace>(",line=dashed") == TestSpace::size);           // leading comma
+    REQUIRE(parse_modes<TestSpace>("line=dashed,,end=arrows") == TestSpace::size);
+    REQUIRE(parse_modes<TestSpace>("line=dashed,line=solid") == TestSpace::size); // category twice
+    REQUIRE(parse_modes<TestSpace>("line=dashed=solid") == TestSpace::size);
+    REQUIRE(parse_modes<TestSpace>("line=arrows") == TestSpace::size);            // mode from another category
+    REQUIRE(parse_modes<TestSpace>("line=dashedX") == TestSpace::size);           // mode name with a suffix
+    REQUIRE(parse_modes<TestSpace>("line=dashe") == TestSpace::size);             // truncated mode name
+    REQUIRE(parse_modes<TestSpace>("linee=dashed") == TestSpace::size);           // category name with a suffix
+    REQUIRE(parse_modes<TestSpace>("line=dashed,end") == TestSpace::size);        // no '=' after a pair
+    REQUIRE(parse_modes<TestSpace>("l") == TestSpace::size);                      // shorter than every name
+}
+
+TEST_CASE("StaticModeNames/parse_modes/fallback-hashes", "parse_modes<>() with names that the prefix hash can't tell apart") {
+
+    REQUIRE(parse_modes<FallbackSpace>("nested=ab,lookalike=aYcde") == FallbackSpace::key(Nested::ab, Lookalike::aYcde));
+    REQUIRE(parse_modes<FallbackSpace>("lookalike=a,nested=abc") == FallbackSpace::key(Nested::abc, Lookalike::a));
+    REQUIRE(parse_modes<FallbackSpace>("nested=a") == FallbackSpace::key(Nested::a, Lookalike::a));
+
+    for (std::size_t k = 0; k < FallbackSpace::size; ++k) {
+        REQUIRE(parse_modes<FallbackSpace>(to_string<FallbackSpace>(k)) == k);
+    }
+
+    REQUIRE(parse_modes<FallbackSpace>("nested=abcd") == FallbackSpace::size);
+    REQUIRE(parse_modes<FallbackSpace>("nested=ab,") == FallbackSpace::size);
+    REQUIRE(parse_modes<FallbackSpace>("lookalike=aZcde") == FallbackSpace::size);
+    REQUIRE(parse_modes<FallbackSpace>("lookalike=aXcde=a") == FallbackSpace::size);
+}
+
+TEST_CASE("StaticModeNames/parse_modes/partial-category", "parse_modes<>() with a category that lists some modes") {
+
+    REQUIRE(parse_modes<PartialSpace>("") == 0);
+    REQUIRE(parse_modes<PartialSpace>("line=dashed") == 0);
+    REQUIRE(parse_modes<PartialSpace>("line=solid") == 1);
+    REQUIRE(parse_modes<PartialSpace>("line=dotted") == PartialSpace::size); // named, but not in the category
+
+    REQUIRE(to_string<PartialSpace>(1) == "line=solid");
+}
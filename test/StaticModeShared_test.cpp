@@ -0,0 +1,258 @@
+//!clang++ -std=c++11 -Weverything -Wno-c++98-compat -Wno-unused-const-variable -Wno-exit-time-destructors StaticModeShared_test.cpp -DCATCH_CONFIG_MAIN -I../include -I./Catch -lrt -pthread -o shared_test.out && ./shared_test.out
+
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h> // O_RDWR
+#include <sys/mman.h> // shm_open, mmap
+#include <sys/wait.h> // waitpid
+#include <unistd.h> // fork, getpid
+
+#include "StaticModeShared.h"
+
+using namespace staticmode;
+
+namespace {
+
+    enum class Shape { point, pair, quad };
+    enum class Wide { no, yes };
+
+    using Shapes = ModeCategory<Shape, Shape::point, Shape::pair, Shape::quad>;
+    using Wides = ModeCategory<Wide, Wide::no, Wide::yes>;
+
+    using TestSpace = ModeSpace<Shapes, Wides>;
+    using OtherSpace = ModeSpace<Shapes>;
+
+    // a name unique to this test process
+    std::string shmName(const char *suffix) {
+        return "/staticmode-test-" + std::to_string(static_cast<long>(::getpid())) + "-" + suffix;
+    }
+
+} // end anonymous namespace
+
+TEST_CASE("StaticModeShared/shared_mode_config", "stores are visible through every mapping") {
+
+    std::string name = shmName("basic");
+
+    shared_mode_config<TestSpace> writer;
+    REQUIRE(!writer.is_open());
+    REQUIRE(writer.create(name.c_str()));
+
+    shared_mode_config<TestSpace> reader;
+    REQUIRE(reader.open(name.c_str()));
+
+    shared_mode_config<TestSpace>::snapshot s = reader.load();
+    REQUIRE(s.key == 0);
+    REQUIRE(s.version == 0);
+
+    writer.store(TestSpace::key(Shape::quad, Wide::yes), 42);
+    REQUIRE(reader.version() == 1);
+    s = reader.load();
+    REQUIRE(s.key == TestSpace::key(Shape::quad, Wide::yes));
+    REQUIRE(s.version == 1);
+    REQUIRE(s.stamp == 42);
+
+    // either handle may store
+    reader.store(1);
+    REQUIRE(writer.load().key == 1);
+    REQUIRE(writer.version() == 2);
+
+    // a mapping stays valid after unlink, but the name is gone
+    REQUIRE(shared_mode_config<TestSpace>::unlink(name.c_str()));
+    REQUIRE(reader.load().key == 1);
+    shared_mode_config<TestSpace> late;
+    REQUIRE(!late.open(name.c_str()));
+}
+
+TEST_CASE("StaticModeShared/shared_mode_config/mismatch", "open() rejects an object created for a different space") {
+
+    std::string name = shmName("mismatch");
+
+    shared_mode_config<TestSpace> writer;
+    REQUIRE(writer.create(name.c_str()));
+
+    shared_mode_config<OtherSpace> other;
+    REQUIRE(!other.open(name.c_str()));
+    REQUIRE(!other.is_open());
+
+    shared_mode_config<TestSpace>::unlink(name.c_str());
+}
+
+TEST_CASE("StaticModeShared/shared_mode_config/recreate", "create() on a mapped object keeps the version increasing") {
+
+    std::string name = shmName("recreate");
+
+    shared_mode_config<TestSpace> writer;
+    REQUIRE(writer.create(name.c_str()));
+    REQUIRE(writer.version() == 0);
+
+    shared_mode_config<TestSpace> reader;
+    REQUIRE(reader.open(name.c_str()));
+    writer.store(4);
+    writer.store(5);
+    const std::uint64_t cachedVersion = reader.version();
+    REQUIRE(cachedVersion == 2);
+
+    // a reader that cached the version before re-creation sees a change
+    shared_mode_config<TestSpace> other;
+    REQUIRE(other.create(name.c_str()));
+    REQUIRE(reader.version() == 3);
+    REQUIRE(reader.version() != cachedVersion);
+    shared_mode_config<TestSpace>::snapshot s = reader.load();
+    REQUIRE(s.key == 0);
+    REQUIRE(s.stamp == 0);
+
+    // an object created after unlink starts from version 0
+    REQUIRE(shared_mode_config<TestSpace>::unlink(name.c_str()));
+    REQUIRE(writer.create(name.c_str()));
+    REQUIRE(writer.version() == 0);
+
+    shared_mode_config<TestSpace>::unlink(name.c_str());
+}
+
+TEST_CASE("StaticModeShared/shared_mode_config/too-small", "open() rejects an object too small to map, setting errno to EINVAL") {
+
+    std::string name = shmName("small");
+
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    REQUIRE(fd != -1);
+    ::close(fd); // zero size
+
+    errno = ENOENT; // stale error from an earlier call
+    shared_mode_config<TestSpace> config;
+    REQUIRE(!config.open(name.c_str()));
+    REQUIRE(errno == EINVAL);
+    REQUIRE(!config.is_open());
+
+    shared_mode_config<TestSpace>::unlink(name.c_str());
+}
+
+TEST_CASE("StaticModeShared/shared_mode_config/writers", "concurrent stores are serialized") {
+
+    std::string name = shmName("writers");
+
+    shared_mode_config<TestSpace> config;
+    REQUIRE(config.create(name.c_str()));
+
+    // each writer stores its own key, with a stamp derived from the key:
+    // a reader must never see the key of one store with the stamp of another
+    const int stores = 20000;
+    std::vector<std::thread> writers;
+    for (std::size_t w = 0; w < 3; ++w) {
+        writers.emplace_back([&name, w] {
+            shared_mode_config<TestSpace> writer;
+            if (!writer.open(name.c_str()))
+                return;
+            for (int i = 0; i < stores; ++i)
+                writer.store(w, 1000 + w);
+        });
+    }
+
+    bool consistent = true;
+    for (int i = 0; i < stores; ++i) {
+        shared_mode_config<TestSpace>::snapshot s = config.load();
+        if (s.version != 0 && s.stamp != 1000 + s.key)
+            consistent = false;
+    }
+    for (std::thread& t : writers)
+        t.join();
+
+    REQUIRE(consistent);
+    REQUIRE(config.version() == 3 * stores); // no store was lost
+
+    shared_mode_config<TestSpace>::unlink(name.c_str());
+}
+
+TEST_CASE("StaticModeShared/shared_mode_config/try_load", "try_load() gives up on a store that never finishes") {
+
+    std::string name = shmName("try-load");
+
+    shared_mode_config<TestSpace> config;
+    REQUIRE(config.create(name.c_str()));
+    config.store(3, 7);
+
+    shared_mode_config<TestSpace>::snapshot s = { 0, 0, 0 };
+    REQUIRE(config.try_load(s, 0));
+    REQUIRE(s.key == 3);
+    REQUIRE(s.version == 1);
+    REQUIRE(s.stamp == 7);
+
+    // simulate a writer that died mid-store: leave the sequence odd
+    int fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+    REQUIRE(fd != -1);
+    void *p = ::mmap(nullptr, sizeof(detail::shared_mode_block_), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    REQUIRE(p != MAP_FAILED);
+    detail::shared_mode_block_ *block = static_cast<detail::shared_mode_block_*>(p);
+    block->sequence.fetch_add(1);
+
+    shared_mode_config<TestSpace>::snapshot t = { 0, 0, 0 };
+    REQUIRE(!config.try_load(t, 1000));
+    REQUIRE(t.key == 0); // unchanged
+
+    // re-creating the object is the way to recover. The version keeps increasing.
+    REQUIRE(config.create(name.c_str()));
+    REQUIRE(config.try_load(t, 0));
+    REQUIRE(t.key == 0);
+    REQUIRE(t.version == 2);
+
+    ::munmap(p, sizeof(detail::shared_mode_block_));
+    shared_mode_config<TestSpace>::unlink(name.c_str());
+}
+
+TEST_CASE("StaticModeShared/shared_mode_config/processes", "a child process sees the parent's stores") {
+
+    std::string name = shmName("fork");
+
+    shared_mode_config<TestSpace> config;
+    REQUIRE(config.create(name.c_str()));
+
+    pid_t pid = ::fork();
+    REQUIRE(pid != -1);
+    if (pid == 0) {
+        // child: map by name, wait for version 3, report the key in the exit status
+        shared_mode_config<TestSpace> child;
+        if (!child.open(name.c_str()))
+            ::_exit(100);
+        while (child.version() < 3) {}
+        ::_exit(static_cast<int>(child.load().key));
+    }
+
+    config.store(1);
+    config.store(2);
+    config.store(5);
+
+    int status = 0;
+    REQUIRE(::waitpid(pid, &status, 0) == pid);
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 5);
+
+    shared_mode_config<TestSpace>::unlink(name.c_str());
+}
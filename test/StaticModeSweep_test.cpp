@@ -0,0 +1,166 @@
+//!clang++ -std=c++11 -Weverything -Wno-c++98-compat -Wno-unused-const-variable -Wno-exit-time-destructors StaticModeSweep_test.cpp -DCATCH_CONFIG_MAIN -I../include -I./Catch -pthread -o sweep_test.out && ./sweep_test.out
+
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "StaticModeNames.h"
+#include "StaticModeSweep.h"
+
+using namespace staticmode;
+
+namespace {
+
+    enum class LineStyle { solid, dotted, dashed };
+    enum class EndStyle { no_ends, arrows, circles };
+
+    constexpr Mode<LineStyle, LineStyle::solid> solid;
+    constexpr Mode<LineStyle, LineStyle::dotted> dotted;
+    constexpr Mode<EndStyle, EndStyle::arrows> arrows;
+    constexpr Mode<EndStyle, EndStyle::circles> circles;
+
+    using LineStyles = ModeCategory<LineStyle, LineStyle::solid, LineStyle::dotted, LineStyle::dashed>;
+    using EndStyles = ModeCategory<EndStyle, EndStyle::no_ends, EndStyle::arrows, EndStyle::circles>;
+
+    struct PainterModes : ModeSpace<LineStyles, EndStyles> {};
+
+    using PainterRules = ModeRules<PainterModes,
+        Requires<decltype(circles), decltype(solid)>,
+        Excludes<decltype(dotted), decltype(arrows)> >;
+
+    std::atomic<int> calls(0);
+
+    // checksum: a function of the key and the input
+    struct KeyKernel {
+        template<typename ModeExpr>
+        static std::uint64_t apply(const std::vector<int>& input, std::uint64_t salt) {
+            ++calls;
+            std::uint64_t sum = salt;
+            for (int x : input)
+                sum = sum * 31 + static_cast<std::uint64_t>(x);
+            return sum * 1000 + ModeExpr::key;
+        }
+    };
+
+    struct ThrowingKernel {
+        template<typename ModeExpr>
+        static int apply() {
+            if (ModeExpr::key == 4)
+                throw std::runtime_error("key 4");
+            return 0;
+        }
+    };
+
+} // end anonymous namespace
+
+STATICMODE_MODE_NAMES(LineStyle, "line", "solid", "dotted", "dashed")
+STATICMODE_MODE_NAMES(EndStyle, "end", "none", "arrows", "circles")
+
+TEST_CASE("StaticModeSweep/sweep", "sweep runs every key once per repetition") {
+
+    const std::vector<int> input = { 1, 2, 3 };
+    std::vector<sweep_result> serial = sweep<PainterModes, KeyKernel>(1, 1, input, std::uint64_t(7));
+
+    REQUIRE(serial.size() == PainterModes::size);
+    for (std::size_t key = 0; key < PainterModes::size; ++key) {
+        REQUIRE(serial[key].key == key);
+        REQUIRE(serial[key].ran);
+        REQUIRE(serial[key].seconds >= 0);
+        REQUIRE(serial[key].checksum % 1000 == key);
+    }
+
+    for (unsigned threads : { 0u, 2u, 3u, 64u }) {
+        calls = 0;
+        std::vector<sweep_result> parallel = sweep<PainterModes, KeyKernel>(threads, 3, input, std::uint64_t(7));
+        REQUIRE(calls == 3 * static_cast<int>(PainterModes::size));
+        for (std::size_t key = 0; key < PainterModes::size; ++key) {
+            REQUIRE(parallel[key].ran);
+            REQUIRE(parallel[key].checksum == serial[key].checksum);
+        }
+    }
+}
+
+TEST_CASE("StaticModeSweep/sweep_allowed", "sweep_allowed skips keys that the rules forbid") {
+
+    const std::vector<int> input = { 4 };
+    calls = 0;
+    std::vector<sweep_result> results = sweep_allowed<PainterRules, KeyKernel>(2, 1, input, std::uint64_t(0));
+
+    REQUIRE(results.size() == PainterModes::size);
+    int ran = 0;
+    for (std::size_t key = 0; key < PainterModes::size; ++key) {
+        REQUIRE(results[key].ran == PainterRules::test(key));
+        if (results[key].ran)
+            ++ran;
+        else
+            REQUIRE(results[key].checksum == 0);
+    }
+    REQUIRE(ran == 6); // 9, less dotted|arrows, dotted|circles and dashed|circles
+    REQUIRE(calls == ran);
+}
+
+TEST_CASE("StaticModeSweep/exceptions", "an exception from a kernel is rethrown") {
+
+    for (unsigned threads : { 1u, 3u }) {
+        bool thrown = false;
+        try {
+            sweep<PainterModes, ThrowingKernel>(threads, 1);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        REQUIRE(thrown);
+    }
+}
+
+TEST_CASE("StaticModeSweep/reports", "CSV and JSON reports") {
+
+    sweep_result a = { 0, true, 0.5, 0x1f };
+    sweep_result b = { 1, false, 0., 0 };
+    std::vector<sweep_result> results = { a, b };
+
+    std::ostringstream csv;
+    write_sweep_csv(csv, results, &to_string<PainterModes>);
+    REQUIRE(csv.str() ==
+        "key,modes,ran,seconds,checksum\n"
+        "0,\"line=solid,end=none\",1,0.5,0x000000000000001f\n"
+        "1,\"line=dotted,end=none\",0,0,0x0000000000000000\n");
+
+    std::ostringstream json;
+    write_sweep_json(json, results, &to_string<PainterModes>);
+    REQUIRE(json.str() ==
+        "[\n"
+        " {\"key\": 0, \"modes\": \"line=solid,end=none\", \"ran\": true, \"seconds\": 0.5, \"checksum\": \"0x000000000000001f\"},\n"
+        " {\"key\": 1, \"modes\": \"line=dotted,end=none\", \"ran\": false, \"seconds\": 0, \"checksum\": \"0x0000000000000000\"}\n"
+        "]\n");
+
+    std::ostringstream plain;
+    write_sweep_csv(plain, std::vector<sweep_result>(1, a));
+    REQUIRE(plain.str() == "key,modes,ran,seconds,checksum\n0,\"\",1,0.5,0x000000000000001f\n");
+}
@@ -0,0 +1,259 @@
+//!clang++ -std=c++11 -Weverything -Wno-c++98-compat -Wno-unused-const-variable -Wno-exit-time-destructors StaticModeTune_test.cpp -DCATCH_CONFIG_MAIN -I../include -I./Catch -pthread -o tune_test.out && ./tune_test.out
+
+// StaticMode
+// Copyright (c) 2017 Ross Bencina
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "catch.hpp"
+
+#include <cstddef>
+#include <cstdio> // remove
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "StaticModeTune.h"
+
+using namespace staticmode;
+
+namespace {
+
+    enum class Work { heavy, light };
+    using Works = ModeCategory<Work, Work::heavy, Work::light>;
+
+    enum class Extra { none, some };
+    using Extras = ModeCategory<Extra, Extra::none, Extra::some>;
+
+    struct TuneSpace : ModeSpace<Works, Extras> {};
+
+    // heavy is ~1000x the work of light, so light always wins
+    struct SpinKernel {
+        static int calls;
+
+        template<typename ModeExpr>
+        static std::size_t apply(std::size_t& sink) {
+            ++calls;
+            const bool heavy = get_mode_t<Work, ModeExpr, Mode<Work, Work::heavy> >::value == Work::heavy;
+            const bool extra = get_mode_t<Extra, ModeExpr, Mode<Extra, Extra::none> >::value == Extra::some;
+            std::size_t n = (heavy ? 200000 : 200) + (extra ? 100 : 0);
+            volatile std::size_t x = 0;
+            for (std::size_t i = 0; i < n; ++i)
+                x = x + i;
+            sink += x;
+            return sink;
+        }
+    };
+
+    int SpinKernel::calls = 0;
+
+    const char *const cacheFile = "StaticModeTune_test.cache";
+
+    std::vector<std::string> readLines(const char *path) {
+        std::vector<std::string> lines;
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line))
+            lines.push_back(line);
+        return lines;
+    }
+
+} // end anonymous namespace
+
+TEST_CASE("StaticModeTune/cpu_model", "cpu_model") {
+
+    std::string model = cpu_model();
+    REQUIRE(!model.empty());
+    REQUIRE(model.find('\t') == std::string::npos);
+    REQUIRE(model.find('\n') == std::string::npos);
+    REQUIRE(model == cpu_model());
+}
+
+TEST_CASE("StaticModeTune/autotune", "autotune picks the fastest key") {
+
+    std::size_t sink = 0;
+    SpinKernel::calls = 0;
+
+    std::vector<double> times = autotune_times<TuneSpace, SpinKernel>(3, sink);
+    REQUIRE(times.size() == TuneSpace::size);
+    REQUIRE(SpinKernel::calls == 4 * static_cast<int>(TuneSpace::size)); // warm up + 3 repetitions
+
+    const std::size_t lightNone = TuneSpace::key(Work::light, Extra::none);
+    for (std::size_t key = 0; key < TuneSpace::size; ++key)
+        REQUIRE(times[key] > 0);
+    REQUIRE(times[lightNone] < times[TuneSpace::key(Work::heavy, Extra::none)]);
+
+    std::size_t best = autotune<TuneSpace, SpinKernel>(3, sink);
+    bool light = (best == lightNone || best == TuneSpace::key(Work::light, Extra::some));
+    REQUIRE(light);
+}
+
+TEST_CASE("StaticModeTune/autotune_cached", "autotune_cached persists the winner per CPU model") {
+
+    std::remove(cacheFile);
+
+    // an unrelated entry, and a stale entry for another space size, and garbage
+    {
+        std::ofstream out(cacheFile);
+        out << "other\t" << cpu_model() << "\t4\t3\n";
+        out << "spin\t" << cpu_model() << "\t99\t0\n";
+        out << "not an entry\n";
+        out << "spin\tsome other cpu\t4\t0\n";
+    }
+
+    std::size_t sink = 0;
+    SpinKernel::calls = 0;
+
+    autotune_result first = autotune_cached<TuneSpace, SpinKernel>(cacheFile, "spin", sink);
+    REQUIRE(!first.cached);
+    REQUIRE(first.key < TuneSpace::size);
+    REQUIRE(SpinKernel::calls > 0);
+
+    std::vector<std::string> lines = readLines(cacheFile);
+    REQUIRE(lines.size() == 4); // the stale entry was replaced
+    REQUIRE(lines[0] == "other\t" + cpu_model() + "\t4\t3");
+    REQUIRE(lines[1] == "not an entry");
+    REQUIRE(lines[2] == "spin\tsome other cpu\t4\t0");
+    REQUIRE(lines[3] == "spin\t" + cpu_model() + "\t4\t" + std::to_string(first.key));
+
+    // later startups: no timing
+    SpinKernel::calls = 0;
+    autotune_result second = autotune_cached<TuneSpace, SpinKernel>(cacheFile, "spin", sink);
+    REQUIRE(second.cached);
+    REQUIRE(second.key == first.key);
+    REQUIRE(SpinKernel::calls == 0);
+
+    // the cached key is used as is, even if it isn't the fastest
+    {
+        std::ofstream out(cacheFile);
+        out << "spin\t" << cpu_model() << "\t4\t0\n";
+    }
+    autotune_result forced = autotune_cached<TuneSpace, SpinKernel>(cacheFile, "spin", sink);
+    REQUIRE(forced.cached);
+    REQUIRE(forced.key == 0);
+
+    // out of range keys are ignored
+    {
+        std::ofstream out(cacheFile);
+        out << "spin\t" << cpu_model() << "\t4\t4\n";
+    }
+    autotune_result retuned = autotune_cached<TuneSpace, SpinKernel>(cacheFile, "spin", sink);
+    REQUIRE(!retuned.cached);
+    REQUIRE(readLines(cacheFile).size() == 1);
+
+    std::remove(cacheFile);
+}
+
+TEST_CASE("StaticModeTune/unwritable", "autotune_cached still tunes when the cache can't be written") {
+
+    std::size_t sink = 0;
+    autotune_result r = autotune_cached<TuneSpace, SpinKernel>("no-such-directory/tune.cache", "spin", sink);
+    REQUIRE(!r.cached);
+    REQUIRE(r.key < TuneSpace::size);
+}
+
+TEST_CASE("StaticModeTune/repetitions", "autotune_cached times the given number of repetitions") {
+
+    std::remove(cacheFile);
+
+    std::size_t sink = 0;
+    SpinKernel::calls = 0;
+    autotune_result r = autotune_cached<TuneSpace, SpinKernel>(cacheFile, "spin", autotune_repetitions{ 2 }, sink);
+    REQUIRE(!r.cached);
+    REQUIRE(SpinKernel::calls == 3 * static_cast<int>(TuneSpace::size)); // warm up + 2 repetitions
+
+    SpinKernel::calls = 0;
+    std::remove(cacheFile);
+    autotune_cached<TuneSpace, SpinKernel>(cacheFile, "spin", sink);
+    REQUIRE(SpinKernel::calls == 6 * static_cast<int>(TuneSpace::size)); // warm up + the default 5
+
+    std::remove(cacheFile);
+}
+
+TEST_CASE("StaticModeTune/names", "autotune_cached doesn't cache names that the file format can't hold") {
+
+    std::remove(cacheFile);
+    {
+        std::ofstream out(cacheFile);
+        out << "other\t" << cpu_model() << "\t4\t3\n";
+    }
+
+    std::size_t sink = 0;
+    const char *const badNames[] = { "", "two words", "tab\tname", "new\nline", "cr\r" };
+    for (const char *name : badNames) {
+        for (int i = 0; i < 2; ++i) {
+            autotune_result r = autotune_cached<TuneSpace, SpinKernel>(cacheFile, name, autotune_repetitions{ 1 }, sink);
+            REQUIRE(!r.cached);
+            REQUIRE(r.key < TuneSpace::size);
+        }
+    }
+
+    std::vector<std::string> lines = readLines(cacheFile);
+    REQUIRE(lines.size() == 1);
+    REQUIRE(lines[0] == "other\t" + cpu_model() + "\t4\t3");
+
+    std::remove(cacheFile);
+}
+
+namespace {
+
+    // SpinKernel without the (unsynchronized) call counter
+    struct QuietKernel {
+        template<typename ModeExpr>
+        static std::size_t apply(std::size_t& sink) {
+            const bool light = get_mode_t<Work, ModeExpr, Mode<Work, Work::heavy> >::value == Work::light;
+            volatile std::size_t x = 0;
+            for (std::size_t i = 0; i < (light ? 100u : 1000u); ++i)
+                x = x + i;
+            sink += x;
+            return sink;
+        }
+    };
+
+} // end anonymous namespace
+
+TEST_CASE("StaticModeTune/concurrent", "concurrent tuners never publish a corrupt cache file") {
+
+    std::remove(cacheFile);
+
+    // each thread tunes under its own name, several times
+    std::vector<std::thread> tuners;
+    for (int t = 0; t < 4; ++t) {
+        tuners.emplace_back([t] {
+            std::size_t sink = 0;
+            for (int i = 0; i < 10; ++i) {
+                autotune_cached<TuneSpace, QuietKernel>(cacheFile, "spin-" + std::to_string(t) + "-" + std::to_string(i),
+                    autotune_repetitions{ 1 }, sink);
+            }
+        });
+    }
+    for (std::thread& t : tuners)
+        t.join();
+
+    // entries may be lost to a concurrent rename, but every line is a whole entry
+    std::vector<std::string> lines = readLines(cacheFile);
+    REQUIRE(!lines.empty());
+    for (const std::string& line : lines) {
+        REQUIRE(line.compare(0, 5, "spin-") == 0);
+        REQUIRE(line.find("\t" + cpu_model() + "\t4\t") != std::string::npos);
+    }
+
+    std::remove(cacheFile);
+}
@@ -23,6 +23,7 @@
 
 #include "catch.hpp"
 
+#include <cstdint>
 #include <type_traits>
 
 #include "StaticMode.h"
@@ -95,6 +96,15 @@ TEST_CASE("StaticMode/detail/or_", "or_") {
     REQUIRE(true);
 }
 
+TEST_CASE("StaticMode/detail/make_index_sequence_", "make_index_sequence_") {
+
+    static_assert(std::is_same<detail::make_index_sequence_<0>::type, detail::index_sequence_<> >::value, "");
+    static_assert(std::is_same<detail::make_index_sequence_<1>::type, detail::index_sequence_<0> >::value, "");
+    static_assert(std::is_same<detail::make_index_sequence_<5>::type, detail::index_sequence_<0, 1, 2, 3, 4> >::value, "");
+
+    REQUIRE(true);
+}
+
 /// type_pack templates
 
 TEST_CASE("StaticMode/detail/has_type_no_cv", "has_type_no_cv") {
@@ -550,6 +560,124 @@ TEST_CASE("StaticMode/has_mode", "has_mode<>") {
     }
 }
 
+// accepts_modes, requires_mode, is_callable_with_modes
+
+namespace {
+
+    // Overloads selected by SFINAE. Each returns the number of the overload chosen.
+
+    template<typename ModeExpr, enable_if_requires_mode_t<ModeExpr, TestEnumOne> = 0>
+    int sfinaeOverload(ModeExpr) { return 1; }
+
+    template<typename ModeExpr, enable_if_accepts_modes_t<ModeExpr, TestEnumTwo, TestEnumThree> = 0>
+    int sfinaeOverload(ModeExpr) { return 2; }
+
+    inline int sfinaeOverload(int) { return 3; }
+
+    struct AcceptsOneAndTwo {
+        template<typename ModeExpr, enable_if_accepts_modes_t<ModeExpr, TestEnumOne, TestEnumTwo> = 0>
+        void operator()(ModeExpr) const {}
+    };
+
+    struct AcceptsAnything {
+        template<typename T>
+        void operator()(T) const {}
+    };
+
+} // end anonymous namespace
+
+TEST_CASE("StaticMode/accepts_modes", "accepts_modes<> is false for non-mode-expressions") {
+
+    static_assert(accepts_modes<ModeSet<>, TestEnumOne>::value == true, "");
+    static_assert(accepts_modes<ModeSet<> >::value == true, "");
+    static_assert(accepts_modes<decltype(one_test1), TestEnumOne>::value == true, "");
+    static_assert(accepts_modes<decltype(one_test1 | two_test1), TestEnumOne, TestEnumTwo>::value == true, "");
+    static_assert(accepts_modes<decltype(one_test1 | two_test1), TestEnumTwo, TestEnumOne>::value == true, "");
+
+    static_assert(accepts_modes<decltype(one_test1), TestEnumTwo>::value == false, "");
+    static_assert(accepts_modes<decltype(one_test1 | two_test1), TestEnumOne>::value == false, "");
+
+    // unlike has_no_other_modes, these compile:
+    static_assert(accepts_modes<int, TestEnumOne>::value == false, "");
+    static_assert(accepts_modes<type_pack<TestEnumOne>, TestEnumOne>::value == false, "");
+
+    REQUIRE(true);
+}
+
+TEST_CASE("StaticMode/requires_mode", "requires_mode<> is false for non-mode-expressions") {
+
+    static_assert(requires_mode<decltype(one_test1), TestEnumOne>::value == true, "");
+    static_assert(requires_mode<decltype(two_test1 | one_test1), TestEnumOne>::value == true, "");
+
+    static_assert(requires_mode<ModeSet<>, TestEnumOne>::value == false, "");
+    static_assert(requires_mode<decltype(two_test1), TestEnumOne>::value == false, "");
+
+    // unlike has_mode, this compiles:
+    static_assert(requires_mode<int, TestEnumOne>::value == false, "");
+
+    REQUIRE(true);
+}
+
+TEST_CASE("StaticMode/enable_if/overloads", "enable_if_accepts_modes_t<> and enable_if_requires_mode_t<> prune overloads") {
+
+    REQUIRE(sfinaeOverload(one_test1) == 1);
+    REQUIRE(sfinaeOverload(one_test2 | four_test1) == 1);
+    REQUIRE(sfinaeOverload(two_test1) == 2);
+    REQUIRE(sfinaeOverload(three_test1 | two_test1) == 2);
+    REQUIRE(sfinaeOverload(ModeSet<>{}) == 2);
+    REQUIRE(sfinaeOverload(42) == 3);
+
+    //sfinaeOverload(four_test1); // should fail to compile, no viable overload
+}
+
+TEST_CASE("StaticMode/is_callable_with_modes", "is_callable_with_modes<> probes callables") {
+
+    static_assert(is_callable_with_modes<AcceptsOneAndTwo, decltype(one_test1 | two_test1)>::value == true, "");
+    static_assert(is_callable_with_modes<AcceptsOneAndTwo, ModeSet<> >::value == true, "");
+    static_assert(is_callable_with_modes<AcceptsOneAndTwo, decltype(one_test1 | three_test1)>::value == false, "");
+    static_assert(is_callable_with_modes<AcceptsOneAndTwo, int>::value == false, "");
+
+    static_assert(is_callable_with_modes<AcceptsAnything, decltype(four_test1)>::value == true, "");
+
+    REQUIRE(true);
+}
+
+#if defined(__cpp_concepts) && __cpp_concepts >= 201907L
+
+namespace {
+
+    template<RequiresMode<TestEnumOne> M>
+    int conceptOverload(M) { return 1; }
+
+    template<AcceptsModes<TestEnumTwo, TestEnumThree> M>
+    int conceptOverload(M) { return 2; }
+
+    inline int conceptOverload(int) { return 3; }
+
+} // end anonymous namespace
+
+TEST_CASE("StaticMode/concepts", "ModeExpr, AcceptsModes and RequiresMode concepts") {
+
+    static_assert(ModeExpr<decltype(one_test1)>, "");
+    static_assert(ModeExpr<ModeSet<> >, "");
+    static_assert(!ModeExpr<int>, "");
+
+    static_assert(AcceptsModes<decltype(one_test1 | two_test1), TestEnumOne, TestEnumTwo>, "");
+    static_assert(!AcceptsModes<decltype(one_test1 | two_test1), TestEnumOne>, "");
+    static_assert(!AcceptsModes<int, TestEnumOne>, "");
+
+    static_assert(RequiresMode<decltype(two_test1 | one_test1), TestEnumOne>, "");
+    static_assert(!RequiresMode<decltype(two_test1), TestEnumOne>, "");
+    static_assert(!RequiresMode<int, TestEnumOne>, "");
+
+    REQUIRE(conceptOverload(one_test1) == 1);
+    REQUIRE(conceptOverload(one_test2 | four_test1) == 1);
+    REQUIRE(conceptOverload(three_test1 | two_test1) == 2);
+    REQUIRE(conceptOverload(42) == 3);
+}
+
+#endif
+
 // get_mode_t
 
 TEST_CASE("StaticMode/get_mode_t/happy-path", "get_mode_t<> test happy path usage") {
@@ -634,6 +762,175 @@ TEST_CASE("StaticMode/get_mode_t/happy-path", "get_mode_t<> test happy path usag
     REQUIRE(true);
 }
 
+// ModeCategory<>, ModeSpace<>, PackedModes<>
+
+namespace {
+
+    using TestOnes = ModeCategory<TestEnumOne, TestEnumOne::test1, TestEnumOne::test2, TestEnumOne::test3>;
+    using TestTwos = ModeCategory<TestEnumTwo, TestEnumTwo::test2, TestEnumTwo::test1>; // test2 is the default
+    using TestThrees = ModeCategory<TestEnumThree, TestEnumThree::test1, TestEnumThree::testX>;
+
+    struct TestSpace : ModeSpace<TestOnes, TestTwos, TestThrees> {};
+
+} // end anonymous namespace
+
+TEST_CASE("StaticMode/mode-category", "ModeCategory<> fields and index lookup") {
+
+    static_assert(TestOnes::size == 3, "");
+    static_assert(std::is_same<TestOnes::value_type, TestEnumOne>::value, "");
+    static_assert(std::is_same<TestOnes::modes, type_pack<Mode<TestEnumOne, TestEnumOne::test1>,
+        Mode<TestEnumOne, TestEnumOne::test2>, Mode<TestEnumOne, TestEnumOne::test3> > >::value, "");
+    static_assert(detail::is_same_no_cv<TestOnes::default_mode, decltype(one_test1)>::value, "");
+    static_assert(detail::is_same_no_cv<TestTwos::default_mode, decltype(two_test2)>::value, "");
+
+    static_assert(TestOnes::index_of(TestEnumOne::test1) == 0, "");
+    static_assert(TestOnes::index_of(TestEnumOne::test3) == 2, "");
+    static_assert(TestOnes::index_of(TestEnumOne::testX) == TestOnes::size, ""); // not listed
+    static_assert(TestTwos::index_of(TestEnumTwo::test1) == 1, "");
+
+    static_assert(TestOnes::value_at(1) == TestEnumOne::test2, "");
+    static_assert(TestTwos::value_at(0) == TestEnumTwo::test2, "");
+
+    REQUIRE(TestOnes::index_of(TestEnumOne::test2) == 1);
+}
+
+TEST_CASE("StaticMode/mode-space/key", "ModeSpace<> packs runtime values into keys") {
+
+    static_assert(TestSpace::size == 3 * 2 * 2, "");
+
+    static_assert(TestSpace::key(TestEnumOne::test1, TestEnumTwo::test2, TestEnumThree::test1) == 0, ""); // all defaults
+    static_assert(TestSpace::key(TestEnumOne::test2, TestEnumTwo::test2, TestEnumThree::test1) == 1, "");
+    static_assert(TestSpace::key(TestEnumOne::test1, TestEnumTwo::test1, TestEnumThree::test1) == 3, "");
+    static_assert(TestSpace::key(TestEnumOne::test3, TestEnumTwo::test1, TestEnumThree::testX) == 2 + 3*1 + 6*1, "");
+
+    // unlisted values yield the invalid key /size/
+    static_assert(TestSpace::key(TestEnumOne::testX, TestEnumTwo::test1, TestEnumThree::test1) == TestSpace::size, "");
+    static_assert(TestSpace::key(TestEnumOne::test1, TestEnumTwo::test1, TestEnumThree::test2) == TestSpace::size, "");
+
+    TestEnumTwo two = TestEnumTwo::test1; // runtime value
+    REQUIRE(TestSpace::key(TestEnumOne::test2, two, TestEnumThree::testX) == 1 + 3 + 6);
+}
+
+TEST_CASE("StaticMode/mode-space/packed-key", "packed_key<> and normalize_t<> of mode expressions") {
+
+    static_assert(packed_key<TestSpace, ModeSet<> >::value == 0, "");
+    static_assert(packed_key<TestSpace, decltype(one_test2)>::value == 1, "");
+    static_assert(packed_key<TestSpace, decltype(two_test1 | one_test2)>::value == 4, "");
+    static_assert(packed_key<TestSpace, decltype(one_test2 | two_test1)>::value == 4, ""); // order doesn't matter
+    static_assert(packed_key<TestSpace, decltype(one_test1 | two_test2)>::value == 0, ""); // explicit defaults
+
+    // normalized ModeSets list every category, in category order
+    static_assert(std::is_same<normalize_t<TestSpace, ModeSet<> >,
+        ModeSet<Mode<TestEnumOne, TestEnumOne::test1>, Mode<TestEnumTwo, TestEnumTwo::test2>, Mode<TestEnumThree, TestEnumThree::test1> > >::value, "");
+    static_assert(std::is_same<normalize_t<TestSpace, decltype(three_testX | one_test3)>,
+        ModeSet<Mode<TestEnumOne, TestEnumOne::test3>, Mode<TestEnumTwo, TestEnumTwo::test2>, Mode<TestEnumThree, TestEnumThree::testX> > >::value, "");
+
+    static_assert(std::is_same<TestSpace::mode_set_t<4>, normalize_t<TestSpace, decltype(two_test1 | one_test2)> >::value, "");
+
+    //packed_key<TestSpace, decltype(four_test1)>::value; // should fail to compile, category not in TestSpace
+
+    REQUIRE(true);
+}
+
+TEST_CASE("StaticMode/packed-modes", "PackedModes<> is a mode expression") {
+
+    using packed_t = compact_t<TestSpace, decltype(two_test1 | one_test2)>;
+
+    static_assert(std::is_same<packed_t, PackedModes<TestSpace, 4> >::value, "");
+    static_assert(std::is_same<packed_t, compact_t<TestSpace, decltype(one_test2 | two_test1 | three_test1)> >::value, "");
+    static_assert(std::is_same<packed_t, decltype(compact<TestSpace>(one_test2 | two_test1))>::value, "");
+    static_assert(packed_t::key == 4, "");
+
+    static_assert(is_packed_modes<packed_t>::value == true, "");
+    static_assert(is_packed_modes<const packed_t>::value == true, "");
+    static_assert(is_packed_modes<ModeSet<> >::value == false, "");
+    static_assert(is_mode_expr<packed_t>::value == true, "");
+
+    static_assert(has_mode<TestEnumThree, packed_t>::value == true, "");
+    static_assert(has_mode<TestEnumFour, packed_t>::value == false, "");
+    static_assert(has_no_other_modes<type_pack<TestEnumOne, TestEnumTwo, TestEnumThree>, packed_t>::value == true, "");
+    static_assert(has_no_other_modes<type_pack<TestEnumOne, TestEnumTwo>, packed_t>::value == false, "");
+
+    static_assert(detail::is_same_no_cv<get_mode_t<TestEnumOne, packed_t, decltype(one_testX)>, decltype(one_test2)>::value, "");
+    static_assert(detail::is_same_no_cv<get_mode_t<TestEnumTwo, packed_t, decltype(two_testX)>, decltype(two_test1)>::value, "");
+    static_assert(detail::is_same_no_cv<get_mode_t<TestEnumThree, packed_t, decltype(three_testX)>, decltype(three_test1)>::value, "");
+    static_assert(detail::is_same_no_cv<get_mode_t<TestEnumFour, packed_t, decltype(four_testX)>, decltype(four_testX)>::value, "");
+
+    REQUIRE(true);
+}
+
+// ModeSpace<>::index/value, ModeRules<>
+
+TEST_CASE("StaticMode/mode-space/index-value", "ModeSpace<>::index<>() and value<>() unpack runtime keys") {
+
+    constexpr std::size_t key = TestSpace::key(TestEnumOne::test3, TestEnumTwo::test1, TestEnumThree::testX);
+
+    static_assert(TestSpace::index<TestEnumOne>(key) == 2, "");
+    static_assert(TestSpace::index<TestEnumTwo>(key) == 1, "");
+    static_assert(TestSpace::index<TestEnumThree>(key) == 1, "");
+
+    static_assert(TestSpace::value<TestEnumOne>(key) == TestEnumOne::test3, "");
+    static_assert(TestSpace::value<TestEnumTwo>(key) == TestEnumTwo::test1, "");
+    static_assert(TestSpace::value<TestEnumThree>(key) == TestEnumThree::testX, "");
+
+    //TestSpace::value<TestEnumFour>(key); // should fail to compile, category not in TestSpace
+
+    for (std::size_t k = 0; k < TestSpace::size; ++k) {
+        REQUIRE(TestSpace::key(TestSpace::value<TestEnumOne>(k), TestSpace::value<TestEnumTwo>(k), TestSpace::value<TestEnumThree>(k)) == k);
+    }
+}
+
+namespace {
+
+    using TestRules = ModeRules<TestSpace,
+        Requires<Mode<TestEnumThree, TestEnumThree::testX>, Mode<TestEnumOne, TestEnumOne::test3> >,
+        Excludes<Mode<TestEnumOne, TestEnumOne::test2>, Mode<TestEnumTwo, TestEnumTwo::test1> > >;
+
+    // a larger space, to test bitmaps spanning several words
+    enum class TestEnumBig { b0, b1, b2, b3, b4, b5, b6, b7, b8, b9 };
+    using TestBigs = ModeCategory<TestEnumBig, TestEnumBig::b0, TestEnumBig::b1, TestEnumBig::b2, TestEnumBig::b3,
+        TestEnumBig::b4, TestEnumBig::b5, TestEnumBig::b6, TestEnumBig::b7, TestEnumBig::b8, TestEnumBig::b9>;
+    struct TestBigSpace : ModeSpace<TestBigs, TestOnes, TestTwos, TestThrees> {};
+
+    using TestBigRules = ModeRules<TestBigSpace,
+        Excludes<Mode<TestEnumBig, TestEnumBig::b9>, Mode<TestEnumTwo, TestEnumTwo::test1> > >;
+
+} // end anonymous namespace
+
+TEST_CASE("StaticMode/mode-rules/static", "is_allowed<> checks mode expressions against ModeRules<>") {
+
+    static_assert(is_allowed<TestRules, ModeSet<> >::value == true, "");
+    static_assert(is_allowed<TestRules, decltype(three_testX | one_test3)>::value == true, "");
+    static_assert(is_allowed<TestRules, decltype(three_testX)>::value == false, ""); // default one_test1 violates Requires
+    static_assert(is_allowed<TestRules, decltype(one_test2)>::value == true, "");
+    static_assert(is_allowed<TestRules, decltype(one_test2 | two_test1)>::value == false, "");
+    static_assert(is_allowed<TestRules, decltype(two_test1 | one_test2)>::value == false, "");
+
+    static_assert(is_allowed<ModeRules<TestSpace>, decltype(three_testX)>::value == true, ""); // no rules
+
+    REQUIRE(true);
+}
+
+TEST_CASE("StaticMode/mode-rules/runtime", "ModeRules<>::test() agrees with ModeRules<>::allows()") {
+
+    for (std::size_t k = 0; k < TestSpace::size; ++k) {
+        bool expected = !(TestSpace::value<TestEnumThree>(k) == TestEnumThree::testX && TestSpace::value<TestEnumOne>(k) != TestEnumOne::test3)
+            && !(TestSpace::value<TestEnumOne>(k) == TestEnumOne::test2 && TestSpace::value<TestEnumTwo>(k) == TestEnumTwo::test1);
+        REQUIRE(TestRules::test(k) == expected);
+        REQUIRE(TestRules::allows(k) == expected);
+    }
+    REQUIRE(TestRules::test(TestSpace::size) == false); // invalid key
+    REQUIRE(TestRules::test(TestSpace::size + 1000) == false);
+
+    static_assert(TestBigSpace::size == 120, "");
+    static_assert(sizeof(TestBigRules::bitmap::words) == 2 * sizeof(std::uint64_t), "");
+    for (std::size_t k = 0; k < TestBigSpace::size + 10; ++k) {
+        bool expected = k < TestBigSpace::size
+            && !(TestBigSpace::value<TestEnumBig>(k) == TestEnumBig::b9 && TestBigSpace::value<TestEnumTwo>(k) == TestEnumTwo::test1);
+        REQUIRE(TestBigRules::test(k) == expected);
+    }
+}
+
 /// Integration tests
 
 namespace {
@@ -0,0 +1,267 @@
+#!/usr/bin/env python3
+# manifest-report.py [--csv] <binary>...
+#
+# Reports the code size of each mode combination recorded with
+# STATICMODE_MANIFEST() (see include/StaticModeManifest.h) in a linked ELF
+# executable or shared library, and the code size of each mode of each
+# category, summed over the combinations that use it.
+#
+# A combination's code is:
+#
+#   - the functions that contain its manifest entries: the functions that
+#     use STATICMODE_MANIFEST(), or the callers that the compiler inlined
+#     them into, and
+#   - the functions that were not inlined into those, found by name: the
+#     functions whose names contain the template arguments of a function
+#     that contains its entries (e.g. helper<PackedModes<Space, 5ul>>() for
+#     Kernel::apply<PackedModes<Space, 5ul>>()).
+#
+# A function that contains the entries of several combinations (e.g. a
+# dispatcher that several kernels were inlined into) is shared: its size is
+# not counted towards any one combination, it is listed separately.
+#
+# The binary must not be stripped of its symbol table. Requires Python 3 and
+# nm (binutils or llvm-nm; set NM to choose).
+
+import os
+import struct
+import subprocess
+import sys
+
+SECTION = "staticmode_manifest"
+MAGIC = 0x464d4d53
+VERSION = 1
+
+
+class ElfError(Exception):
+    pass
+
+
+class Elf:
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        d = self.data
+        if d[:4] != b"\x7fELF":
+            raise ElfError("not an ELF file")
+        self.is64 = d[4] == 2
+        self.endian = "<" if d[5] == 1 else ">"
+        if self.is64:
+            (e_type,) = struct.unpack_from(self.endian + "H", d, 16)
+            shoff, = struct.unpack_from(self.endian + "Q", d, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from(self.endian + "HHH", d, 0x3a)
+        else:
+            (e_type,) = struct.unpack_from(self.endian + "H", d, 16)
+            shoff, = struct.unpack_from(self.endian + "I", d, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from(self.endian + "HHH", d, 0x2e)
+        if e_type not in (2, 3):  # ET_EXEC, ET_DYN
+            raise ElfError("not a linked executable or shared library")
+
+        self.sections = []
+        for i in range(shnum):
+            off = shoff + i * shentsize
+            if self.is64:
+                name, type_, flags, addr, offset, size = struct.unpack_from(self.endian + "IIQQQQ", d, off)
+            else:
+                name, type_, flags, addr, offset, size = struct.unpack_from(self.endian + "IIIIII", d, off)
+            self.sections.append({"name": name, "type": type_, "flags": flags,
+                                  "addr": addr, "offset": offset, "size": size})
+        strtab = self.sections[shstrndx]
+        for s in self.sections:
+            start = strtab["offset"] + s["name"]
+            s["name"] = d[start:d.index(b"\0", start)].decode("ascii", "replace")
+
+    def section(self, name):
+        for s in self.sections:
+            if s["name"] == name:
+                return s
+        return None
+
+    def read(self, addr, size):
+        """the /size/ bytes at virtual address /addr/, from the section that contains them"""
+        for s in self.sections:
+            SHF_ALLOC, SHT_NOBITS = 0x2, 8
+            if (s["flags"] & SHF_ALLOC) and s["type"] != SHT_NOBITS \
+                    and s["addr"] <= addr and addr + size <= s["addr"] + s["size"]:
+                start = s["offset"] + addr - s["addr"]
+                return self.data[start:start + size]
+        raise ElfError("address 0x%x is not in the file" % addr)
+
+
+def read_manifest(elf):
+    """returns {record address: record}, and a list of (record address, code address) entries"""
+    section = elf.section(SECTION)
+    if section is None:
+        return {}, []
+    e = elf.endian
+    records, entries = {}, []
+    raw = elf.data[section["offset"]:section["offset"] + section["size"]]
+    for i in range(0, len(raw) - 7, 8):
+        record_offset, code_offset = struct.unpack_from(e + "ii", raw, i)
+        entry = section["addr"] + i
+        record_addr, code_addr = entry + record_offset, entry + 4 + code_offset
+        if record_addr not in records:
+            magic, version, hash_, key, name_size = struct.unpack(e + "IIQII", elf.read(record_addr, 24))
+            if magic != MAGIC or version != VERSION:
+                raise ElfError("bad manifest record at 0x%x" % record_addr)
+            name = elf.read(record_addr + 24, name_size).split(b"\0")[0].decode("utf-8", "replace")
+            records[record_addr] = {"name": name, "hash": hash_, "key": key}
+        entries.append((record_addr, code_addr))
+    return records, entries
+
+
+def read_functions(path):
+    """(address, size, name) of each function symbol, sorted by address"""
+    nm = os.environ.get("NM", "nm")
+    out = subprocess.run([nm, "-C", "--print-size", "--defined-only", path],
+                         stdout=subprocess.PIPE, check=True, universal_newlines=True).stdout
+    functions = []
+    for line in out.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) == 4 and fields[2] in ("t", "T", "w", "W", "i"):
+            functions.append((int(fields[0], 16), int(fields[1], 16), fields[3]))
+    functions.sort()
+    return functions
+
+
+def find_function(functions, addr):
+    lo, hi = 0, len(functions)
+    while lo < hi:  # the last function starting at or before /addr/
+        mid = (lo + hi) // 2
+        if functions[mid][0] <= addr:
+            lo = mid + 1
+        else:
+            hi = mid
+    if lo > 0:
+        start, size, name = functions[lo - 1]
+        if start <= addr < start + max(size, 1):
+            return functions[lo - 1]
+    return None
+
+
+def template_arguments(name):
+    """the last top-level template argument list of a demangled function name, e.g.
+    "PackedModes<Space, 5ul>" for "Kernel::apply<PackedModes<Space, 5ul> >(int)" """
+    end = len(name)
+    if name.endswith(" const"):
+        end -= len(" const")
+    if end > 0 and name[end - 1] == ")":  # skip the parameter list
+        depth = 0
+        for i in range(end - 1, -1, -1):
+            depth += {")": 1, "(": -1}.get(name[i], 0)
+            if depth == 0:
+                end = i
+                break
+    while end > 0 and name[end - 1] == " ":
+        end -= 1
+    if end == 0 or name[end - 1] != ">":
+        return None
+    depth = 0
+    for i in range(end - 1, -1, -1):
+        if name[i] == ">":
+            depth += 1
+        elif name[i] == "<":
+            depth -= 1
+            if depth == 0:
+                arguments = name[i + 1:end - 1].strip()
+                return arguments if "<" in arguments else None  # only distinctive (template type) arguments
+    return None
+
+
+def report(path, csv, out):
+    elf = Elf(path)
+    records, entries = read_manifest(elf)
+    functions = read_functions(path)
+
+    # the combinations in each function
+    contents = {}
+    for record_addr, code_addr in entries:
+        f = find_function(functions, code_addr) or (code_addr, 0, "(unknown code at 0x%x)" % code_addr)
+        contents.setdefault(f, set()).add(record_addr)
+
+    own = {r: {"functions": 0, "bytes": 0} for r in records}
+    shared = []
+    arguments = {}  # template arguments -> combination
+    for f, rs in contents.items():
+        if len(rs) == 1:
+            r = next(iter(rs))
+            own[r]["functions"] += 1
+            own[r]["bytes"] += f[1]
+            a = template_arguments(f[2])
+            if a is not None:
+                arguments[a] = r
+        else:
+            shared.append((f, rs))
+
+    # functions without entries, by name (longest match)
+    patterns = sorted(arguments, key=len, reverse=True)
+    for f in functions:
+        if f in contents:
+            continue
+        for a in patterns:
+            if a in f[2]:
+                own[arguments[a]]["functions"] += 1
+                own[arguments[a]]["bytes"] += f[1]
+                break
+
+    modes = {}  # (category, mode) -> [combinations, bytes]
+    for r, rec in records.items():
+        for pair in rec["name"].split(","):
+            category, _, mode = pair.partition("=")
+            m = modes.setdefault((category, mode), [0, 0])
+            m[0] += 1
+            m[1] += own[r]["bytes"]
+
+    combinations = sorted(records.items(), key=lambda item: (-own[item[0]]["bytes"], item[1]["name"]))
+    if csv:
+        out.write("kind,name,hash,key,combinations,functions,bytes\n")
+        for r, rec in combinations:
+            out.write('combination,"%s",0x%016x,%d,1,%d,%d\n'
+                      % (rec["name"], rec["hash"], rec["key"], own[r]["functions"], own[r]["bytes"]))
+        for (category, mode), (count, size) in sorted(modes.items()):
+            out.write('mode,"%s=%s",,,%d,,%d\n' % (category, mode, count, size))
+        for f, rs in shared:
+            out.write('shared,"%s",,,%d,1,%d\n' % (f[2].replace('"', '""'), len(rs), f[1]))
+        return
+
+    out.write("%s: %d combinations, %d manifest entries\n\n" % (path, len(records), len(entries)))
+    out.write("%10s %9s  %-18s %5s  %s\n" % ("bytes", "functions", "hash", "key", "combination"))
+    for r, rec in combinations:
+        out.write("%10d %9d  0x%016x %5d  %s\n"
+                  % (own[r]["bytes"], own[r]["functions"], rec["hash"], rec["key"], rec["name"]))
+    out.write("%10d            total\n" % sum(o["bytes"] for o in own.values()))
+
+    out.write("\n%10s %12s  %s\n" % ("bytes", "combinations", "category=mode"))
+    previous = None
+    for (category, mode), (count, size) in sorted(modes.items()):
+        if previous is not None and category != previous:
+            out.write("\n")
+        previous = category
+        out.write("%10d %12d  %s=%s\n" % (size, count, category, mode))
+
+    if shared:
+        out.write("\nshared functions (not counted above):\n")
+        for f, rs in sorted(shared, key=lambda item: -item[0][1]):
+            out.write("%10d %12d  %s\n" % (f[1], len(rs), f[2]))
+    out.write("\n")
+
+
+def main(argv):
+    args = argv[1:]
+    csv = "--csv" in args
+    paths = [a for a in args if a != "--csv"]
+    if not paths:
+        sys.stderr.write("usage: %s [--csv] <binary>...\n" % argv[0])
+        return 2
+    status = 0
+    for path in paths:
+        try:
+            report(path, csv, sys.stdout)
+        except (OSError, ElfError, subprocess.CalledProcessError) as e:
+            sys.stderr.write("%s: %s\n" % (path, e))
+            status = 1
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))